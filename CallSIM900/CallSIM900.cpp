@@ -14,6 +14,11 @@
 #include "CallSIM900.h"
 #include <SIM900.h>
 
+#ifndef SIM900_NO_CALL
+
+#include "CallSIM900Tokens.h"
+#include "CallSIM900Automata.h"
+
 CallSIM900::CallSIM900(SIM900 *sim)
         : sim(sim) {
 }
@@ -22,7 +27,7 @@ CallSIM900::~CallSIM900() {
 }
 
 unsigned char CallSIM900::answer() {
-    return (unsigned char) sim->sendCommandExpecting((const char*) "A", (const char*) "CONNECT", true);
+    return (unsigned char) sim->sendCommandExpecting(F("A"), F("CONNECT"), true);
 }
 
 unsigned char CallSIM900::callNumber(unsigned char *number) {
@@ -47,23 +52,11 @@ unsigned char CallSIM900::disconnect() {
 }
 
 unsigned char CallSIM900::checkResponse() {
-    CallResponse response = OK;
-    if (sim->doesResponseContains((const char *) "OK")) {
-        response = OK;
-    } else if (sim->doesResponseContains((const char *) "CME")) {
-        response = CME_ERROR;
-    } else if (sim->doesResponseContains((const char *) "DIALTONE")) {
-        response = NO_DIALTONE;
-    } else if (sim->doesResponseContains((const char *) "BUSY")) {
-        response = BUSY;
-    } else if (sim->doesResponseContains((const char *) "CARRIER")) {
-        response = NO_CARRIER;
-    } else if (sim->doesResponseContains((const char *) "ANSWER")) {
-        response = NO_ANSWER;
-    } else if (sim->doesResponseContains((const char *) "CONNECT")) {
-        response = CONNECT_TEXT;
-    }
-    return response;
+    const char *response = (const char *) sim->getLastResponse();
+
+    // OK wins over the call results wherever it is, then they go in the table's order
+    return ResponseMatcher::rank(&CALL_SIM900_RESPONSE_AUTOMATON, response, OK);
 }
+#endif
 
 #endif /* __ARDUINO_DRIVER_GSM_CALL_SIM900_CPP__ */
@@ -0,0 +1,106 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CallSIM900Automata.h
+ *
+ * Automata of the token tables of CallSIM900Tokens.h, generated by
+ * "make automata". Do not edit.
+ *
+ * A state is { first edge, edges, fail, token, match }.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_CALL_SIM900_AUTOMATA_H__
+#define __ARDUINO_DRIVER_GSM_CALL_SIM900_AUTOMATA_H__ 1
+
+#include "CallSIM900Tokens.h"
+
+/**
+ * 7 tokens of CALL_SIM900_RESPONSE_TOKENS, 36 states.
+ */
+static_assert(sizeof(CALL_SIM900_RESPONSE_TOKENS) / sizeof(ResponseToken) == 7,
+        "CALL_SIM900_RESPONSE_TOKENS changed, run make automata");
+
+static const ResponseState CALL_SIM900_RESPONSE_STATES[] PROGMEM = {
+    { 0, 5, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 0 "" */
+    { 5, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 1 "O" */
+    { 6, 0, 0, 0, 0 }, /* 2 "OK" */
+    { 6, 3, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 3 "C" */
+    { 9, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 4 "CM" */
+    { 10, 0, 0, 1, 1 }, /* 5 "CME" */
+    { 10, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 6 "D" */
+    { 11, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 7 "DI" */
+    { 12, 1, 24, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 8 "DIA" */
+    { 13, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 9 "DIAL" */
+    { 14, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 10 "DIALT" */
+    { 15, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 11 "DIALTO" */
+    { 16, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 12 "DIALTON" */
+    { 17, 0, 0, 2, 2 }, /* 13 "DIALTONE" */
+    { 17, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 14 "B" */
+    { 18, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 15 "BU" */
+    { 19, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 16 "BUS" */
+    { 20, 0, 0, 3, 3 }, /* 17 "BUSY" */
+    { 20, 1, 24, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 18 "CA" */
+    { 21, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 19 "CAR" */
+    { 22, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 20 "CARR" */
+    { 23, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 21 "CARRI" */
+    { 24, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 22 "CARRIE" */
+    { 25, 0, 0, 4, 4 }, /* 23 "CARRIER" */
+    { 25, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 24 "A" */
+    { 26, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 25 "AN" */
+    { 27, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 26 "ANS" */
+    { 28, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 27 "ANSW" */
+    { 29, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 28 "ANSWE" */
+    { 30, 0, 0, 5, 5 }, /* 29 "ANSWER" */
+    { 30, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 30 "CO" */
+    { 31, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 31 "CON" */
+    { 32, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 32 "CONN" */
+    { 33, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 33 "CONNE" */
+    { 34, 1, 3, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 34 "CONNEC" */
+    { 35, 0, 0, 6, 6 } /* 35 "CONNECT" */
+};
+
+static const ResponseEdge CALL_SIM900_RESPONSE_EDGES[] PROGMEM = {
+    { 'A', 24 },
+    { 'B', 14 },
+    { 'C', 3 },
+    { 'D', 6 },
+    { 'O', 1 },
+    { 'K', 2 },
+    { 'A', 18 },
+    { 'M', 4 },
+    { 'O', 30 },
+    { 'E', 5 },
+    { 'I', 7 },
+    { 'A', 8 },
+    { 'L', 9 },
+    { 'T', 10 },
+    { 'O', 11 },
+    { 'N', 12 },
+    { 'E', 13 },
+    { 'U', 15 },
+    { 'S', 16 },
+    { 'Y', 17 },
+    { 'R', 19 },
+    { 'R', 20 },
+    { 'I', 21 },
+    { 'E', 22 },
+    { 'R', 23 },
+    { 'N', 25 },
+    { 'S', 26 },
+    { 'W', 27 },
+    { 'E', 28 },
+    { 'R', 29 },
+    { 'N', 31 },
+    { 'N', 32 },
+    { 'E', 33 },
+    { 'C', 34 },
+    { 'T', 35 }
+};
+
+static const ResponseAutomaton CALL_SIM900_RESPONSE_AUTOMATON PROGMEM = {
+    CALL_SIM900_RESPONSE_TOKENS, CALL_SIM900_RESPONSE_STATES, CALL_SIM900_RESPONSE_EDGES
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_CALL_SIM900_AUTOMATA_H__ */
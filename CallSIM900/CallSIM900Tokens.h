@@ -0,0 +1,39 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CallSIM900Tokens.h
+ *
+ * Token tables of the call responses, the sources of CallSIM900Automata.h.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_CALL_SIM900_TOKENS_H__
+#define __ARDUINO_DRIVER_GSM_CALL_SIM900_TOKENS_H__ 1
+
+#include <Arduino.h>
+#include <ResponseMatcher.h>
+#include "CallSIM900.h"
+
+/**
+ * The final responses of a call.
+ */
+static const char CALL_SIM900_OK[] PROGMEM = "OK";
+static const char CALL_SIM900_CME_ERROR[] PROGMEM = "CME";
+static const char CALL_SIM900_NO_DIALTONE[] PROGMEM = "DIALTONE";
+static const char CALL_SIM900_BUSY[] PROGMEM = "BUSY";
+static const char CALL_SIM900_NO_CARRIER[] PROGMEM = "CARRIER";
+static const char CALL_SIM900_NO_ANSWER[] PROGMEM = "ANSWER";
+static const char CALL_SIM900_CONNECT_TEXT[] PROGMEM = "CONNECT";
+
+static const ResponseToken CALL_SIM900_RESPONSE_TOKENS[] PROGMEM = {
+    { CALL_SIM900_OK, CallSIM900::OK },
+    { CALL_SIM900_CME_ERROR, CallSIM900::CME_ERROR },
+    { CALL_SIM900_NO_DIALTONE, CallSIM900::NO_DIALTONE },
+    { CALL_SIM900_BUSY, CallSIM900::BUSY },
+    { CALL_SIM900_NO_CARRIER, CallSIM900::NO_CARRIER },
+    { CALL_SIM900_NO_ANSWER, CallSIM900::NO_ANSWER },
+    { CALL_SIM900_CONNECT_TEXT, CallSIM900::CONNECT_TEXT }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_CALL_SIM900_TOKENS_H__ */
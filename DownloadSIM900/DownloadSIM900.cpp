@@ -0,0 +1,280 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * DownloadSIM900.cpp
+ *
+ * HTTP download through the HTTP stack built into the SIM900.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_CPP__
+#define __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_CPP__ 1
+
+#include "DownloadSIM900.h"
+#include <CommandBatch.h>
+#include <WString.h>
+#include <stdlib.h>
+
+DownloadSIM900::DownloadSIM900(SIM900 *sim)
+        : sim(sim), announced(0), actionDone(false), actionStatus(0), actionLength(0), offset(0), length(-1),
+          window(DOWNLOAD_SIM900_MIN_WINDOW), overhead(0), restarts(0) {
+    sim->onHttpData(onHttpData, this);
+    sim->onUnsolicited(SIM900::URC_HTTP_ACTION, onAction, this);
+    sim->getLatencyEstimator(SIM900::LATENCY_HTTP)->reset(DOWNLOAD_SIM900_ACTION_TIMEOUT, DOWNLOAD_SIM900_MIN_TIMEOUT,
+            DOWNLOAD_SIM900_ACTION_TIMEOUT * DOWNLOAD_SIM900_MAX_TIMEOUT_FACTOR);
+}
+
+RingBuffer *DownloadSIM900::onHttpData(SIM900 *sim, char connection, unsigned int length, void *context) {
+    DownloadSIM900 *download = (DownloadSIM900 *) context;
+    download->announced = length;
+    return &download->buffer;
+}
+
+void DownloadSIM900::onAction(SIM900 *sim, unsigned char code, char connection, const char *line, void *context) {
+    DownloadSIM900 *download = (DownloadSIM900 *) context;
+    const char *p = strchr(line, ',');
+
+    // +HTTPACTION: <method>,<status>,<length>
+    if (p == NULL) {
+        return;
+    }
+    download->actionStatus = atoi(p + 1);
+    p = strchr(p + 1, ',');
+    download->actionLength = p != NULL ? strtoul(p + 1, NULL, 10) : 0;
+    download->actionDone = true;
+}
+
+unsigned char DownloadSIM900::openBearer(const char *apn, const char *user, const char *password) {
+    CommandBatch batch;
+    batch.add(F("+SAPBR=3,1,\"Contype\",\"GPRS\""));
+    batch.add(F("+SAPBR=3,1,\"APN\",\""));
+    batch.append(apn);
+    batch.append(F("\""));
+    if (user != NULL) {
+        batch.add(F("+SAPBR=3,1,\"USER\",\""));
+        batch.append(user);
+        batch.append(F("\""));
+    }
+    if (password != NULL) {
+        batch.add(F("+SAPBR=3,1,\"PWD\",\""));
+        batch.append(password);
+        batch.append(F("\""));
+    }
+    if (batch.isOverflowed()) {
+        return DownloadSIM900::COMMAND_TOO_LONG;
+    }
+    if (!sim->sendBatch(&batch)) {
+        return DownloadSIM900::ERROR;
+    }
+    if (sim->sendCommandExpecting(F("+SAPBR=1,1"), F("OK"), true, DOWNLOAD_SIM900_BEARER_TIMEOUT)) {
+        return DownloadSIM900::OK;
+    }
+
+    // The modem answers ERROR when the bearer is open already
+    if (sim->sendCommandExpecting(F("+SAPBR=2,1"), F("+SAPBR: 1,1,"), true)) {
+        sim->waitUntilReceive(F("OK"), SIM900_DEFAULT_COMMAND_TIMEOUT);
+        return DownloadSIM900::OK;
+    }
+    return DownloadSIM900::ERROR;
+}
+
+unsigned char DownloadSIM900::closeBearer() {
+    bool expected = sim->sendCommandExpecting(F("+SAPBR=0,1"), F("OK"), true, DOWNLOAD_SIM900_BEARER_TIMEOUT);
+    return (unsigned char) (expected ? DownloadSIM900::OK : DownloadSIM900::ERROR);
+}
+
+unsigned char DownloadSIM900::download(const char *url, DownloadSink sink, void *context) {
+    offset = 0;
+    length = -1;
+    restarts = 0;
+    return resume(url, sink, context);
+}
+
+unsigned char DownloadSIM900::resume(const char *url, DownloadSink sink, void *context) {
+    unsigned long start;
+    unsigned int got, len;
+    unsigned char result, failures = 0;
+    bool whole;
+    result = begin();
+    if (result != DownloadSIM900::OK) {
+        return result;
+    }
+    while (length < 0 || offset < (unsigned long) length) {
+        result = fetch(url);
+        if (result == DownloadSIM900::COMMAND_TOO_LONG) {
+            break;
+        }
+        if (result == DownloadSIM900::OK) {
+
+            // Asked past the end, the file ended with the previous range
+            if (actionStatus == 416) {
+                length = offset;
+                break;
+            }
+
+            // 6xx are the network errors of the modem, the range is fetched again
+            if (actionStatus / 100 == 6) {
+                result = DownloadSIM900::ERROR;
+            } else if (actionStatus != 200 && actionStatus != 206) {
+                result = DownloadSIM900::HTTP_ERROR;
+                break;
+            }
+        }
+        if (result == DownloadSIM900::OK) {
+
+            // A server ignoring the range sends the whole file
+            whole = actionStatus == 200;
+            start = whole ? offset : 0;
+            if (whole) {
+                length = actionLength;
+            }
+            while (start < actionLength && result == DownloadSIM900::OK) {
+                len = actionLength - start < window ? (unsigned int) (actionLength - start) : window;
+                result = readWindow(start, len, sink, context, &got);
+                start += got;
+                offset += got;
+            }
+            if (result == DownloadSIM900::SINK_STOPPED) {
+                break;
+            }
+            if (result == DownloadSIM900::OK) {
+                if (!whole && actionLength < DOWNLOAD_SIM900_RANGE_SIZE) {
+                    length = offset;
+                }
+                failures = 0;
+                continue;
+            }
+        }
+        if (++failures > DOWNLOAD_SIM900_RETRIES) {
+            result = DownloadSIM900::INTERRUPTED;
+            break;
+        }
+        restarts++;
+    }
+    sim->sendCommandExpecting(F("+HTTPTERM"), F("OK"), true);
+    return result;
+}
+
+unsigned char DownloadSIM900::begin() {
+
+    // The service may be left running by a download which did not end
+    if (!sim->sendCommandExpecting(F("+HTTPINIT"), F("OK"), true)) {
+        sim->sendCommandExpecting(F("+HTTPTERM"), F("OK"), true);
+        if (!sim->sendCommandExpecting(F("+HTTPINIT"), F("OK"), true)) {
+            return DownloadSIM900::ERROR;
+        }
+    }
+    if (!sim->sendCommandExpecting(F("+HTTPPARA=\"CID\",1"), F("OK"), true)) {
+        return DownloadSIM900::ERROR;
+    }
+    return DownloadSIM900::OK;
+}
+
+unsigned char DownloadSIM900::fetch(const char *url) {
+    unsigned long start, elapsed;
+    StaticCommandBuilder<DOWNLOAD_SIM900_MAX_COMMAND_LENGTH> command(COMMAND_PREFIX("AT+HTTPPARA=\"URL\","));
+    command.appendQuoted(url);
+    if (command.isOverflowed()) {
+        return DownloadSIM900::COMMAND_TOO_LONG;
+    }
+    if (!sim->sendCommandExpecting(&command, F("OK"))) {
+        return DownloadSIM900::ERROR;
+    }
+    command.clear();
+    command.append(F("AT+HTTPPARA=\"BREAK\","));
+    command.appendNumber(offset);
+    command.append(F(";+HTTPPARA=\"BREAKEND\","));
+    command.appendNumber(offset + DOWNLOAD_SIM900_RANGE_SIZE - 1);
+    if (!sim->sendCommandExpecting(&command, F("OK"))) {
+        return DownloadSIM900::ERROR;
+    }
+
+    // The OK comes right away, +HTTPACTION once the range is in the modem
+    actionDone = false;
+    actionStatus = 0;
+    if (!sim->sendCommandExpecting(F("+HTTPACTION=0"), F("OK"), true)) {
+        return DownloadSIM900::ERROR;
+    }
+    start = millis();
+    while (!actionDone && millis() - start < sim->getTimeout(SIM900::LATENCY_HTTP)) {
+        sim->poll();
+    }
+    elapsed = millis() - start;
+    if (!actionDone) {
+        sim->recordLatency(SIM900::LATENCY_HTTP, SIM900::COMMAND_TIMEOUT, elapsed);
+        return DownloadSIM900::ERROR;
+    }
+    sim->recordLatency(SIM900::LATENCY_HTTP,
+            actionStatus / 100 == 6 ? SIM900::COMMAND_FAILED : SIM900::COMMAND_OK, elapsed);
+    return DownloadSIM900::OK;
+}
+
+unsigned char DownloadSIM900::readWindow(unsigned long start, unsigned int len, DownloadSink sink, void *context,
+        unsigned int *got) {
+    unsigned char chunk[DOWNLOAD_SIM900_BUFFER_SIZE];
+    unsigned int n;
+    unsigned long started, wire = 0;
+    long rate = sim->getBaudRate();
+    bool stopped = false;
+    int c;
+    StaticCommandBuilder<DOWNLOAD_SIM900_MAX_COMMAND_LENGTH> command(COMMAND_PREFIX("AT+HTTPREAD="));
+    command.appendNumber(start);
+    command.append(',');
+    command.appendNumber(len);
+    *got = 0;
+    if (rate > 0) {
+        wire = (unsigned long) len * 10000UL / (unsigned long) rate;
+    }
+    sim->waitForCommand();
+    buffer.clear();
+    announced = 0;
+    started = millis();
+    sim->submitCommand(&command, F("OK"), sim->getTimeout(SIM900::LATENCY_LOCAL) + 2 * wire);
+
+    // The payload is held back while the buffer is full, so it is drained as the command runs
+    while (sim->isBusy() || buffer.available() > 0) {
+        sim->poll();
+        for (n = 0; n < sizeof(chunk) && (c = buffer.get()) >= 0; n++) {
+            chunk[n] = (unsigned char) c;
+        }
+        if (n == 0 || stopped) {
+            continue;
+        }
+        if (sink(chunk, n, offset + *got, context)) {
+            *got += n;
+        } else {
+            stopped = true;
+        }
+
+        // The timeout is for the line, not for the sink: it runs again once a piece is consumed
+        sim->restartTimeout();
+    }
+    if (stopped) {
+        return DownloadSIM900::SINK_STOPPED;
+    }
+    if (sim->getCommandResult() != SIM900::COMMAND_OK || *got != announced || *got == 0) {
+        return DownloadSIM900::ERROR;
+    }
+    sizeWindow(*got, millis() - started);
+    return DownloadSIM900::OK;
+}
+
+void DownloadSIM900::sizeWindow(unsigned int got, unsigned long elapsed) {
+    unsigned long wire = 0, sample, target = 0;
+    long rate = sim->getBaudRate();
+    if (rate > 0) {
+        wire = (unsigned long) got * 10000UL / (unsigned long) rate;
+    }
+    sample = elapsed > wire ? elapsed - wire : 0;
+    overhead = overhead == 0 ? sample : (overhead * 3 + sample) / 4;
+
+    // Bytes the line carries while DOWNLOAD_SIM900_PIPE_FACTOR overheads pass
+    if (rate > 0) {
+        target = overhead * DOWNLOAD_SIM900_PIPE_FACTOR * (unsigned long) rate / 10000UL;
+    }
+    for (window = DOWNLOAD_SIM900_MIN_WINDOW; window < DOWNLOAD_SIM900_MAX_WINDOW && window < target; window <<= 1) {
+    }
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_CPP__ */
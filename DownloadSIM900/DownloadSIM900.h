@@ -0,0 +1,285 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * DownloadSIM900.h
+ *
+ * HTTP download through the HTTP stack built into the SIM900.
+ *
+ * Steps to download a file.
+ *
+ * <ul>
+ *  <li>call openBearer</li>
+ *  <li>call download, and resume while it fails</li>
+ *  <li>call closeBearer</li>
+ * </ul>
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_H__
+#define __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_H__ 1
+
+#ifndef DOWNLOAD_SIM900_MAX_COMMAND_LENGTH
+#define DOWNLOAD_SIM900_MAX_COMMAND_LENGTH      128
+#endif
+
+#define DOWNLOAD_SIM900_BEARER_TIMEOUT          85000UL
+#define DOWNLOAD_SIM900_ACTION_TIMEOUT          60000UL
+#define DOWNLOAD_SIM900_MIN_TIMEOUT             1000UL
+#define DOWNLOAD_SIM900_MAX_TIMEOUT_FACTOR      4
+
+/**
+ * Bytes the modem is asked to fetch at once (AT+HTTPPARA="BREAK" and
+ * "BREAKEND"), within what it can hold.
+ */
+#ifndef DOWNLOAD_SIM900_RANGE_SIZE
+#define DOWNLOAD_SIM900_RANGE_SIZE              32768UL
+#endif
+
+/**
+ * Buffer between the parser and the sink, a power of two up to 256.
+ */
+#ifndef DOWNLOAD_SIM900_BUFFER_SIZE
+#define DOWNLOAD_SIM900_BUFFER_SIZE             64
+#endif
+
+/**
+ * Bounds of the window read with each AT+HTTPREAD, and how many times its
+ * transfer should outlast the time each command costs besides.
+ */
+#define DOWNLOAD_SIM900_MIN_WINDOW              128
+#ifndef DOWNLOAD_SIM900_MAX_WINDOW
+#define DOWNLOAD_SIM900_MAX_WINDOW              4096
+#endif
+#define DOWNLOAD_SIM900_PIPE_FACTOR             8
+
+/**
+ * Failed ranges in a row download() retries before giving up.
+ */
+#ifndef DOWNLOAD_SIM900_RETRIES
+#define DOWNLOAD_SIM900_RETRIES                 3
+#endif
+
+#include <SIM900.h>
+
+/**
+ * Receives the downloaded bytes, in order.
+ *
+ * @param buf           The bytes.
+ * @param len           How many.
+ * @param offset        Offset of the first of them in the file.
+ * @param context       The opaque pointer given to download().
+ * @return              false to stop the download, e.g. when a flash
+ *                      page could not be written.
+ */
+typedef bool (*DownloadSink)(const unsigned char *buf, unsigned int len, unsigned long offset, void *context);
+
+/**
+ * The modem fetches the file a range at a time into its own memory, and
+ * the range is then read from it a window at a time, the bytes going
+ * through a small buffer to the sink as they arrive: the whole file is
+ * never held, by the modem or by the MCU.
+ *
+ * What reached the sink is never fetched again: a range which fails, when
+ * the bearer drops for instance, is fetched again from the offset the sink
+ * got to, and so does resume() once download() gave up.
+ */
+class DownloadSIM900 {
+
+    SIM900 *sim;
+
+    /**
+     * The bytes read and not given to the sink yet, how many the running
+     * AT+HTTPREAD announced.
+     */
+    StaticRingBuffer<DOWNLOAD_SIM900_BUFFER_SIZE> buffer;
+    unsigned int announced;
+
+    /**
+     * The +HTTPACTION of the range being fetched: whether it came, the
+     * HTTP status (or 6xx network error) and the length of the body.
+     */
+    bool actionDone;
+    int actionStatus;
+    unsigned long actionLength;
+
+    /**
+     * Progress: the offset the sink got to, and the length of the file,
+     * -1 while unknown.
+     */
+    unsigned long offset;
+    long length;
+
+    /**
+     * The window, and the time an AT+HTTPREAD costs besides its transfer,
+     * smoothed, in milliseconds.
+     */
+    unsigned int window;
+    unsigned long overhead;
+
+    unsigned char restarts;
+
+    static RingBuffer *onHttpData(SIM900 *sim, char connection, unsigned int length, void *context);
+
+    static void onAction(SIM900 *sim, unsigned char code, char connection, const char *line, void *context);
+
+    /**
+     * Starts the HTTP service of the modem, ending the one left running.
+     *
+     * @return              Result
+     */
+    unsigned char begin();
+
+    /**
+     * Has the modem fetch the range starting at offset, and waits for it.
+     *
+     * @return              Result
+     */
+    unsigned char fetch(const char *url);
+
+    /**
+     * Reads a window of the fetched range to the sink.
+     *
+     * @param start         Offset of the window in the range.
+     * @param len           Its length.
+     * @param got           Where to put the number of bytes the sink got.
+     * @return              Result
+     */
+    unsigned char readWindow(unsigned long start, unsigned int len, DownloadSink sink, void *context,
+            unsigned int *got);
+
+    /**
+     * Sizes the window after a read, so its transfer outlasts the rest of
+     * the command DOWNLOAD_SIM900_PIPE_FACTOR times.
+     *
+     * @param got           Bytes read.
+     * @param elapsed       Time the read took, in milliseconds.
+     */
+    void sizeWindow(unsigned int got, unsigned long elapsed);
+
+public:
+
+    enum Result {
+        OK = 0,
+        ERROR = 1,
+        COMMAND_TOO_LONG = 2,
+
+        // The server answered with something else than 200 or 206
+        HTTP_ERROR = 3,
+
+        // The sink asked to stop
+        SINK_STOPPED = 4,
+
+        // Ranges kept failing, resume() continues from getOffset()
+        INTERRUPTED = 5
+    };
+
+    /**
+     * Public constructor.
+     *
+     * @param sim           The modem, begun.
+     */
+    DownloadSIM900(SIM900 *sim);
+
+    /**
+     * Opens the bearer of the HTTP stack (AT+SAPBR), which is independent
+     * from the one of AT+CIICR.
+     *
+     * @param apn
+     * @param user
+     * @param password
+     * @return              Result
+     */
+    unsigned char openBearer(const char *apn, const char *user, const char *password);
+
+    /**
+     * Closes the bearer.
+     *
+     * @return              Result
+     */
+    unsigned char closeBearer();
+
+    /**
+     * Downloads a file from its start.
+     *
+     * Example:
+     * > AT+HTTPPARA="URL","example.com/fw.bin"
+     * > AT+HTTPPARA="BREAK",0;+HTTPPARA="BREAKEND",32767
+     * > AT+HTTPACTION=0
+     * < +HTTPACTION: 0,206,32768
+     * > AT+HTTPREAD=0,2048
+     * < +HTTPREAD: 2048
+     * < ...
+     *
+     * @param url           The URL, http:// only.
+     * @param sink          Where the bytes go.
+     * @param context       Given back to the sink.
+     * @return              Result
+     */
+    unsigned char download(const char *url, DownloadSink sink, void *context);
+
+    /**
+     * Continues a download from getOffset().
+     *
+     * @return              Result
+     */
+    unsigned char resume(const char *url, DownloadSink sink, void *context);
+
+    /**
+     * The offset the sink got to, where resume() continues.
+     *
+     * @return
+     */
+    inline unsigned long getOffset() {
+        return offset;
+    }
+
+    /**
+     * Sets where resume() continues, to go on with a download after a
+     * reset, from the offset saved along with what the sink wrote.
+     *
+     * @param offset
+     */
+    inline void setOffset(unsigned long offset) {
+        this->offset = offset;
+        length = -1;
+    }
+
+    /**
+     * The length of the file, -1 until known.
+     *
+     * @return
+     */
+    inline long getLength() {
+        return length;
+    }
+
+    /**
+     * The status of the last +HTTPACTION.
+     *
+     * @return
+     */
+    inline int getStatus() {
+        return actionStatus;
+    }
+
+    /**
+     * The window of the next read.
+     *
+     * @return
+     */
+    inline unsigned int getWindow() {
+        return window;
+    }
+
+    /**
+     * How many ranges were fetched again after failing.
+     *
+     * @return
+     */
+    inline unsigned char getRestarts() {
+        return restarts;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_DOWNLOAD_SIM900_H__ */
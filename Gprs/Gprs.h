@@ -11,10 +11,21 @@
 #ifndef __ARDUINO_DRIVER_GSM_GPRS_H__
 #define __ARDUINO_DRIVER_GSM_GPRS_H__ 1
 
+class __FlashStringHelper;
+
 class Gprs {
 
 public:
 
+    /**
+     * What the operations answer, unless they say otherwise.
+     */
+    enum OperationResult {
+        OK = 0,
+        ERROR = 1,
+        COMMAND_TOO_LONG = 2
+    };
+
     /**
      * Start Up Multi-IP Connection 
      * 
@@ -129,12 +140,78 @@ public:
      */
     virtual unsigned int send(char connection, unsigned char *buf, unsigned int len) = 0;
 
+    /**
+     * Starts sending a payload of known length, given in pieces with write().
+     * 
+     * @param connection    The connection, -1 in single connection mode.
+     * @param len           Length of the whole payload.
+     * @return 
+     */
+    virtual unsigned char beginSend(char connection, unsigned long len) = 0;
+
+    /**
+     * Sends the next piece of the payload started with beginSend().
+     * 
+     * @return              Number of bytes sent.
+     */
+    virtual unsigned int write(const unsigned char *buf, unsigned int len) = 0;
+
+    /**
+     * Sends the next piece of the payload, a string stored in flash.
+     * 
+     * @return              Number of bytes sent.
+     */
+    virtual unsigned int write(const __FlashStringHelper *str) = 0;
+
+    /**
+     * Waits until the payload started with beginSend() is sent.
+     * 
+     * @return 
+     */
+    virtual unsigned char endSend() = 0;
+
+    /**
+     * Bytes of the last payload the modem accepted, what a failed send
+     * leaves to be sent again.
+     * 
+     * @return 
+     */
+    virtual unsigned long getAccepted() = 0;
+
+    /**
+     * Number of received bytes waiting to be read from a connection.
+     * 
+     * @param connection    The connection, -1 in single connection mode.
+     * @return 
+     */
+    virtual int available(char connection) = 0;
+
+    /**
+     * Reads the bytes received from a connection, without waiting for more.
+     * 
+     * @param connection    The connection, -1 in single connection mode.
+     * @return              Number of bytes read.
+     */
+    virtual int read(char connection, unsigned char *buf, unsigned int len) = 0;
+
+    /**
+     * Tells if the peer or the network closed a connection, as far as it
+     * was reported. What it received may still wait to be read.
+     * 
+     * @param connection    The connection, -1 in single connection mode.
+     * @return 
+     */
+    virtual bool isClosed(char connection) = 0;
+
+#ifndef GPRS_NO_SERVER
+
     /**
      * Configure Module as Server
      * 
      * @return 
      */
     virtual unsigned char configureServer(unsigned char mode, unsigned int port) = 0;
+#endif
 
     /**
      * Deactivate GPRS PDP Context
@@ -13,9 +13,68 @@
 
 #include "GprsSIM900.h"
 #include <WString.h>
+#include "GprsSIM900Tokens.h"
+#include "GprsSIM900Automata.h"
+#include <ctype.h>
+
+/**
+ * Whether a string is a dotted IPv4 address rather than a name.
+ */
+static bool isIpAddress(const char *str) {
+    unsigned char dots = 0, digits = 0;
+    for (; *str != '\0'; str++) {
+        if (*str == '.') {
+            if (digits == 0) {
+                return false;
+            }
+            dots++;
+            digits = 0;
+        } else if (*str >= '0' && *str <= '9' && digits < 3) {
+            digits++;
+        } else {
+            return false;
+        }
+    }
+    return dots == 3 && digits > 0;
+}
 
 GprsSIM900::GprsSIM900(SIM900 *sim)
-        : sim(sim), multiplexed(false) {
+        : sim(sim), multiplexed(false), sendConnection(-1), sendRemaining(0), frameSize(0), frameRemaining(0),
+          sendFramed(0), sendAccepted(0), sending(false), sendFailed(false), framesHead(0), framesPending(0),
+          quickSend(false), deliveryConnection(-1), deliveryPending(0), deliveryStale(false), deliveryQueriedAt(0),
+          transparent(false), dataWrittenAt(0), resolvedOpen(false), persistentConnection(-1), persistentMode(NULL),
+          persistentAddress(NULL), persistentPort(0), keepalive(false), reconnects(0) {
+    learnTimeout(SIM900::LATENCY_ATTACH, GPRS_SIM900_CIICR_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_CONNECT, GPRS_SIM900_CIPSTART_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_SEND, GPRS_SIM900_SEND_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_CLOSE, GPRS_SIM900_CIPSTART_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_DNS, GPRS_SIM900_CDNSGIP_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_STATUS, GPRS_SIM900_CIPSTATUS_TIMEOUT);
+    learnTimeout(SIM900::LATENCY_ACK, GPRS_SIM900_CIPACK_TIMEOUT);
+    sim->onData(onData, this);
+    sim->onUnsolicited(SIM900::URC_CONNECT, onConnectionEvent, this);
+    sim->onUnsolicited(SIM900::URC_CLOSED, onConnectionEvent, this);
+    sim->onUnsolicited(SIM900::URC_PDP_DEACT, onBearerLost, this);
+    sim->onUnsolicited(SIM900::URC_DNS, onDnsResolved, this);
+    sim->onUnsolicited(SIM900::URC_SEND, onFrameSent, this);
+    memset(dnsCache, 0, sizeof(dnsCache));
+    memset(channelStates, CHANNEL_FREE, sizeof(channelStates));
+    memset(channelErrors, CHANNEL_NO_ERROR, sizeof(channelErrors));
+    memset(queuedRemaining, 0, sizeof(queuedRemaining));
+    openingChannel = 0;
+    queueActive = GPRS_SIM900_CONNECTIONS;
+    queueFrame = 0;
+    queueTurn = GPRS_SIM900_CONNECTIONS - 1;
+}
+
+void GprsSIM900::learnTimeout(unsigned char latencyClass, unsigned long initial) {
+    sim->getLatencyEstimator(latencyClass)->reset(initial, GPRS_SIM900_MIN_TIMEOUT,
+            initial * GPRS_SIM900_MAX_TIMEOUT_FACTOR);
+}
+
+int GprsSIM900::waitUntilReceive(const __FlashStringHelper *str, unsigned char latencyClass) {
+    sim->measureLatency(latencyClass);
+    return sim->waitUntilReceive(str, sim->getTimeout(latencyClass));
 }
 
 unsigned char GprsSIM900::begin(long bound) {
@@ -23,42 +82,74 @@ unsigned char GprsSIM900::begin(long bound) {
         return 0;
     }
     sim->setEcho(false);
-    return 1;
+
+    // A modem which was just powered needs the network before any IP command
+    return (unsigned char) sim->waitForCapability(SIM900::CAPABILITY_GPRS, SIM900_INITIALIZATION_TIMEOUT);
 }
 
 unsigned char GprsSIM900::useMultiplexer(bool use) {
     bool expected;
-    char command[] = "+CIPMUX=0";
-    if (use) {
-        command[8] = '1';
-    }
     multiplexed = use;
-    expected = sim->sendCommandExpecting(command, "OK", true);
+    expected = sim->sendCommandExpecting(use ? F("+CIPMUX=1") : F("+CIPMUX=0"), F("OK"), true);
     return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
 }
 
+unsigned char GprsSIM900::configure(bool use, const char *apn, const char *login, const char *password,
+        const char *primary, const char *secondary) {
+    CommandBatch batch;
+    batch.add(use ? F("+CIPMUX=1") : F("+CIPMUX=0"));
+    batch.add(F("+CIPHEAD=1"));
+    batch.add(F("+CSTT=\""));
+    batch.append(apn);
+    batch.append(F("\",\""));
+    batch.append(login);
+    batch.append(F("\",\""));
+    batch.append(password);
+    batch.append(F("\""));
+    if (primary != NULL) {
+        batch.add(F("+CDNSCFG=\""));
+        batch.append(primary);
+        batch.append(F("\",\""));
+        batch.append(secondary);
+        batch.append(F("\""));
+    }
+    if (batch.isOverflowed()) {
+        if (useMultiplexer(use) != GprsSIM900::OK || useDataHeader(true) != GprsSIM900::OK
+                || attach(apn, login, password) != GprsSIM900::OK) {
+            return GprsSIM900::ERROR;
+        }
+        return primary == NULL ? (unsigned char) GprsSIM900::OK : configureDns(primary, secondary);
+    }
+    multiplexed = use;
+    return (unsigned char) (sim->sendBatch(&batch) ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
 unsigned char GprsSIM900::attach(const char *apn, const char *login, const char *password) {
     bool expected;
-    sim->write("AT+CSTT=\"");
-    sim->write(apn);
-    sim->write("\",\"");
-    sim->write(login);
-    sim->write("\",\"");
-    sim->write(password);
-    expected = sim->sendCommandExpecting("\"", "OK");
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CSTT="));
+    command.appendQuoted(apn);
+    command.append(',');
+    command.appendQuoted(login);
+    command.append(',');
+    command.appendQuoted(password);
+    if (command.isOverflowed()) {
+        return GprsSIM900::COMMAND_TOO_LONG;
+    }
+    expected = sim->sendCommandExpecting(&command, F("OK"));
     return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
 }
 
 unsigned char GprsSIM900::bringUp() {
     bool expected;
-    expected = sim->sendCommandExpecting("+CIICR", "OK", true, GPRS_SIM900_CIICR_TIMEOUT);
+    sim->measureLatency(SIM900::LATENCY_ATTACH);
+    expected = sim->sendCommandExpecting(F("+CIICR"), F("OK"), true, sim->getTimeout(SIM900::LATENCY_ATTACH));
     return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
 }
 
 unsigned char GprsSIM900::obtainIp(unsigned char ip[4]) {
     const char* response;
     OperationResult result = GprsSIM900::ERROR;
-    unsigned int receivedBytes = sim->sendCommand("+CIFSR", true, GPRS_SIM900_CIICR_TIMEOUT);
+    unsigned int receivedBytes = sim->sendCommand(F("+CIFSR"), true, GPRS_SIM900_CIICR_TIMEOUT);
     if (receivedBytes > 0) {
         response = (const char*) sim->getLastResponse();
         if (parseIp(response, ip) == 4) {
@@ -73,161 +164,997 @@ unsigned char GprsSIM900::status() {
 }
 
 unsigned char GprsSIM900::status(char connection) {
-    ConnectionState state = GprsSIM900::ERROR_WHEN_QUERING;
-    int pos;
-    sim->write("AT+CIPSTATUS");
+    ResponseMatcher matcher(&GPRS_SIM900_STATE_AUTOMATON);
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSTATUS"));
     if (connection != (char) -1) {
-        sim->write('=');
-        sim->write('0' + connection);
+        command.append('=');
+        command.append((char) ('0' + connection));
     }
-    sim->sendCommandExpecting("", "OK");
-    pos = sim->waitUntilReceive("STATE", GPRS_SIM900_CIPSTATUS_TIMEOUT);
-    if (pos >= 0) {
-        if (sim->doesResponseContains("INITIAL")) {
-            state = GprsSIM900::IP_INITIAL;
-        } else if (sim->doesResponseContains("START")) {
-            state = GprsSIM900::IP_START;
-        } else if (sim->doesResponseContains("CONFIG")) {
-            state = GprsSIM900::IP_CONFIG;
-        } else if (sim->doesResponseContains("GPRSACT")) {
-            state = GprsSIM900::IP_GPRSACT;
-        } else if (sim->doesResponseContains("STATUS")) {
-            state = GprsSIM900::IP_STATUS;
-        } else if (sim->doesResponseContains("CONNECTING") || sim->doesResponseContains("LISTENING")) {
-            state = GprsSIM900::CONNECTING_OR_LISTENING;
-        } else if (sim->doesResponseContains("CONNECT OK")) {
-            state = GprsSIM900::CONNECT_OK;
-        } else if (sim->doesResponseContains("CLOSING")) {
-            state = GprsSIM900::CLOSING;
-        } else if (sim->doesResponseContains("CLOSED")) {
-            state = GprsSIM900::CLOSED;
-        } else if (sim->doesResponseContains("DEACT")) {
-            state = GprsSIM900::PDP_DEACT;
-        }
-    }
-    return state;
+    sim->sendCommandExpecting(&command, F("OK"));
+
+    // The state line comes after the OK, its token is matched as it arrives; the
+    // tokens carry the STATE: prefix, so the echoed AT+CIPSTATUS cannot match
+    sim->measureLatency(SIM900::LATENCY_STATUS);
+    sim->expectTokens(&matcher, sim->getTimeout(SIM900::LATENCY_STATUS));
+    if (sim->waitForCommand() == SIM900::COMMAND_OK) {
+        return matcher.getMatch();
+    }
+    return GprsSIM900::ERROR_WHEN_QUERING;
 }
 
 unsigned char GprsSIM900::configureDns(const char *primary, const char *secondary) {
     bool expected;
-    sim->write("AT+CDNSCFG=\"");
-    sim->write(primary);
-    sim->write("\",\"");
-    sim->write(secondary);
-    expected = sim->sendCommandExpecting("\"", "OK");
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CDNSCFG="));
+    command.appendQuoted(primary);
+    command.append(',');
+    command.appendQuoted(secondary);
+    if (command.isOverflowed()) {
+        return GprsSIM900::COMMAND_TOO_LONG;
+    }
+    expected = sim->sendCommandExpecting(&command, F("OK"));
     return expected ? GprsSIM900::OK : GprsSIM900::ERROR;
 }
 
 unsigned char GprsSIM900::open(char connection, const char *mode, const char *address, unsigned int port) {
-    int pos;
-    sim->write("AT+CIPSTART=");
+    unsigned char i = channelIndex(connection), result;
+    unsigned long start = millis(), timeout = sim->getTimeout(SIM900::LATENCY_CONNECT);
+    result = startOpen(connection, mode, address, port);
+    if (result != GprsSIM900::OK) {
+        return result;
+    }
+
+    // CONNECT OK or CONNECT FAIL comes a round trip after the OK
+    while (channelStates[i] == CHANNEL_CONNECTING && millis() - start < timeout) {
+        sim->poll();
+    }
+    if (channelStates[i] == CHANNEL_CONNECTING) {
+        sim->recordLatency(SIM900::LATENCY_CONNECT, SIM900::COMMAND_TIMEOUT, millis() - start);
+        channelStates[i] = CHANNEL_FAILED;
+        channelErrors[i] = CHANNEL_CONNECT_TIMEOUT;
+        return GprsSIM900::ERROR;
+    }
+    sim->recordLatency(SIM900::LATENCY_CONNECT,
+            channelStates[i] == CHANNEL_CONNECTED ? SIM900::COMMAND_OK : SIM900::COMMAND_FAILED, millis() - start);
+    return (unsigned char) (channelStates[i] == CHANNEL_CONNECTED ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+unsigned char GprsSIM900::startOpen(char connection, const char *mode, const char *address, unsigned int port) {
+    unsigned char i = channelIndex(connection), ip[4], j, result;
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSTART="));
+    if (i == GPRS_SIM900_CONNECTIONS) {
+        return GprsSIM900::ERROR;
+    }
     if (connection != (char) -1) {
-        sim->write('0' + connection);
-        sim->write(',');
-    }
-    sim->write('"');
-    sim->write(mode);
-    sim->write("\",\"");
-    sim->write(address);
-    sim->write("\",\"");
-    sim->print(port, DEC);
-    sim->sendCommand("\"");
-    pos = sim->waitUntilReceive("CONNECT", GPRS_SIM900_CIPSTART_TIMEOUT);
-    if (pos >= 0 && !sim->doesResponseContains("FAIL")) {
+        command.append((char) ('0' + connection));
+        command.append(',');
+    }
+    command.appendQuoted(mode);
+    command.append(',');
+
+    // A name too long for the cache is left to the modem
+    if (resolvedOpen && !isIpAddress(address) && strlen(address) < GPRS_SIM900_DNS_NAME_SIZE) {
+        result = resolve(address, ip);
+        if (result != GprsSIM900::OK) {
+            channelStates[i] = CHANNEL_FAILED;
+            channelErrors[i] = CHANNEL_CONNECT_FAILED;
+            return result;
+        }
+        command.append('"');
+        for (j = 0; j < 4; j++) {
+            if (j > 0) {
+                command.append('.');
+            }
+            command.appendNumber(ip[j]);
+        }
+        command.append('"');
+    } else {
+        command.appendQuoted(address);
+    }
+    command.append(F(",\""));
+    command.appendNumber(port);
+    command.append('"');
+    if (command.isOverflowed()) {
+        return GprsSIM900::COMMAND_TOO_LONG;
+    }
+    sim->waitForCommand();
+    channelStates[i] = CHANNEL_CONNECTING;
+    channelErrors[i] = CHANNEL_NO_ERROR;
+    openingChannel = i;
+    sim->setConnectPending(transparent);
+    sim->submitCommand(&command, F("OK"), SIM900_DEFAULT_COMMAND_TIMEOUT, onOpenSubmitted, this);
+    sim->waitForCommand();
+    return (unsigned char) (channelStates[i] == CHANNEL_FAILED ? GprsSIM900::ERROR : GprsSIM900::OK);
+}
+
+void GprsSIM900::onOpenSubmitted(SIM900 *sim, unsigned char result, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    if (result != SIM900::COMMAND_OK) {
+        sim->setConnectPending(false);
+        gprs->channelStates[gprs->openingChannel] = CHANNEL_FAILED;
+        gprs->channelErrors[gprs->openingChannel] = CHANNEL_CONNECT_FAILED;
+    }
+}
+
+void GprsSIM900::onConnectionEvent(SIM900 *sim, unsigned char code, char connection, const char *line,
+        void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    unsigned char i = gprs->channelIndex(connection);
+    if (i == GPRS_SIM900_CONNECTIONS) {
+        return;
+    }
+    if (code == SIM900::URC_CLOSED) {
+        if (gprs->channelStates[i] == CHANNEL_CONNECTED || gprs->channelStates[i] == CHANNEL_CONNECTING) {
+            gprs->channelStates[i] = CHANNEL_CLOSED;
+            gprs->channelErrors[i] = CHANNEL_CLOSED_BY_PEER;
+        }
+        return;
+    }
+    if (strstr_P(line, PSTR("FAIL")) != NULL) {
+        gprs->channelStates[i] = CHANNEL_FAILED;
+        gprs->channelErrors[i] = CHANNEL_CONNECT_FAILED;
+        return;
+    }
+
+    // A resumed connection keeps the bytes received before the escape
+    if (gprs->channelStates[i] != CHANNEL_CONNECTED && gprs->getReceiveBuffer(connection) != NULL) {
+        gprs->getReceiveBuffer(connection)->clear();
+    }
+    gprs->channelStates[i] = CHANNEL_CONNECTED;
+
+    // In transparent mode the modem is in data mode from the CONNECT on
+    if (gprs->transparent) {
+        sim->setDataMode(true);
+        gprs->dataWrittenAt = millis();
+    }
+}
+
+void GprsSIM900::onBearerLost(SIM900 *sim, unsigned char code, char connection, const char *line, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    unsigned char i;
+    for (i = 0; i < GPRS_SIM900_CONNECTIONS; i++) {
+        if (gprs->channelStates[i] == CHANNEL_CONNECTED || gprs->channelStates[i] == CHANNEL_CONNECTING) {
+            gprs->channelStates[i] = CHANNEL_CLOSED;
+            gprs->channelErrors[i] = CHANNEL_BEARER_LOST;
+        }
+    }
+}
+
+unsigned char GprsSIM900::channelIndex(char connection) {
+    if (connection == (char) -1 || !multiplexed) {
+        return 0;
+    }
+    return (unsigned char) connection < GPRS_SIM900_CONNECTIONS ? (unsigned char) connection : GPRS_SIM900_CONNECTIONS;
+}
+
+char GprsSIM900::allocate() {
+    unsigned char i;
+    if (!multiplexed) {
+        return -1;
+    }
+    for (i = 0; i < GPRS_SIM900_CONNECTIONS; i++) {
+        if (channelStates[i] == CHANNEL_FREE) {
+            channelStates[i] = CHANNEL_IDLE;
+            channelErrors[i] = CHANNEL_NO_ERROR;
+            return (char) i;
+        }
+    }
+    return -1;
+}
+
+void GprsSIM900::release(char connection) {
+    unsigned char i = channelIndex(connection);
+    if (i == GPRS_SIM900_CONNECTIONS) {
+        return;
+    }
+    if (channelStates[i] == CHANNEL_CONNECTED || channelStates[i] == CHANNEL_CONNECTING) {
+        close(connection);
+    }
+    queuedRemaining[i] = 0;
+    if (getReceiveBuffer(connection) != NULL) {
+        getReceiveBuffer(connection)->clear();
+    }
+    channelStates[i] = CHANNEL_FREE;
+    channelErrors[i] = CHANNEL_NO_ERROR;
+}
+
+unsigned char GprsSIM900::getChannelState(char connection) {
+    unsigned char i = channelIndex(connection);
+    return i < GPRS_SIM900_CONNECTIONS ? channelStates[i] : (unsigned char) CHANNEL_FREE;
+}
+
+unsigned char GprsSIM900::getChannelError(char connection) {
+    unsigned char i = channelIndex(connection);
+    return i < GPRS_SIM900_CONNECTIONS ? channelErrors[i] : (unsigned char) CHANNEL_NO_ERROR;
+}
+
+bool GprsSIM900::queueSend(char connection, const unsigned char *buf, unsigned int len) {
+    unsigned char i = channelIndex(connection);
+    if (i == GPRS_SIM900_CONNECTIONS || queuedRemaining[i] > 0 || queueActive == i
+            || (channelStates[i] != CHANNEL_CONNECTED && channelStates[i] != CHANNEL_CONNECTING)) {
+        return false;
+    }
+    queuedData[i] = buf;
+    queuedRemaining[i] = len;
+    channelErrors[i] = CHANNEL_NO_ERROR;
+    return true;
+}
+
+unsigned int GprsSIM900::getQueued(char connection) {
+    unsigned char i = channelIndex(connection);
+    return i < GPRS_SIM900_CONNECTIONS ? queuedRemaining[i] : 0;
+}
+
+void GprsSIM900::serviceQueue() {
+    unsigned char i, k;
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSEND="));
+    if (queueActive != GPRS_SIM900_CONNECTIONS || sending || sim->isBusy() || sim->isInDataMode()) {
+        return;
+    }
+    for (k = 1; k <= GPRS_SIM900_CONNECTIONS; k++) {
+        i = (queueTurn + k) % GPRS_SIM900_CONNECTIONS;
+        if (queuedRemaining[i] == 0 || channelStates[i] == CHANNEL_CONNECTING) {
+            continue;
+        }
+        if (channelStates[i] != CHANNEL_CONNECTED) {
+            failQueue(i);
+            continue;
+        }
+
+        // One frame, then the next connection gets its turn
+        queueTurn = i;
+        queueActive = i;
+        queueFrame = queuedRemaining[i] < GPRS_SIM900_MAX_SEND_SIZE ? queuedRemaining[i] : GPRS_SIM900_MAX_SEND_SIZE;
+        if (multiplexed) {
+            command.append((char) ('0' + i));
+            command.append(',');
+        }
+        command.appendNumber(queueFrame);
+        if (!sim->submitCommand(&command, F(">"), SIM900_DEFAULT_COMMAND_TIMEOUT, onQueuedPrompt, this)) {
+            queueActive = GPRS_SIM900_CONNECTIONS;
+        }
+        return;
+    }
+}
+
+void GprsSIM900::failQueue(unsigned char i) {
+    queuedRemaining[i] = 0;
+
+    // The first error is the one worth reporting, such as CLOSED_BY_PEER
+    if (channelErrors[i] == CHANNEL_NO_ERROR) {
+        channelErrors[i] = CHANNEL_SEND_FAILED;
+    }
+}
+
+void GprsSIM900::onQueuedPrompt(SIM900 *sim, unsigned char result, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    unsigned char i = gprs->queueActive;
+    bool expected;
+    if (result != SIM900::COMMAND_OK) {
+        gprs->queueActive = GPRS_SIM900_CONNECTIONS;
+        gprs->failQueue(i);
+        return;
+    }
+    sim->write(gprs->queuedData[i], gprs->queueFrame);
+    if (gprs->quickSend) {
+        expected = sim->expectResponse(F("DATA ACCEPT:"), sim->getTimeout(SIM900::LATENCY_SEND), onQueuedSent, gprs);
+    } else {
+        sim->measureLatency(SIM900::LATENCY_SEND);
+        expected = sim->expectResponse(F("SEND OK"), sim->getTimeout(SIM900::LATENCY_SEND), onQueuedSent, gprs);
+    }
+    if (!expected) {
+        gprs->queueActive = GPRS_SIM900_CONNECTIONS;
+        gprs->failQueue(i);
+    }
+}
+
+void GprsSIM900::onQueuedSent(SIM900 *sim, unsigned char result, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    unsigned char i = gprs->queueActive;
+    gprs->queueActive = GPRS_SIM900_CONNECTIONS;
+    if (result != SIM900::COMMAND_OK) {
+        gprs->failQueue(i);
+        return;
+    }
+
+    // Unless the connection was closed meanwhile, which dropped the queue
+    if (gprs->queuedRemaining[i] >= gprs->queueFrame) {
+        gprs->queuedData[i] += gprs->queueFrame;
+        gprs->queuedRemaining[i] -= gprs->queueFrame;
+    }
+    if (gprs->quickSend) {
+        gprs->deliveryConnection = gprs->multiplexed ? (char) i : (char) -1;
+        gprs->deliveryStale = true;
+    }
+}
+
+unsigned char GprsSIM900::waitForChannel(char connection, unsigned long timeout) {
+    unsigned char i = channelIndex(connection);
+    unsigned long start = millis();
+    if (i == GPRS_SIM900_CONNECTIONS) {
+        return GprsSIM900::ERROR;
+    }
+    while ((channelStates[i] == CHANNEL_CONNECTING || queuedRemaining[i] > 0 || queueActive == i)
+            && millis() - start < timeout) {
+        poll();
+    }
+    if (channelStates[i] == CHANNEL_CONNECTED && channelErrors[i] == CHANNEL_NO_ERROR && queuedRemaining[i] == 0
+            && queueActive != i) {
         return GprsSIM900::OK;
     }
-    return (unsigned char) GprsSIM900::ERROR;
+    return GprsSIM900::ERROR;
 }
 
 unsigned int GprsSIM900::send(char connection, unsigned char *buf, unsigned int len) {
-    bool ok;
-    int pos = -1;
-    unsigned int sent = 0;
-    sim->write("AT+CIPSEND=");
+    unsigned int sent;
+    if (beginSend(connection, len) != GprsSIM900::OK) {
+        return 0;
+    }
+    sent = write(buf, len);
+    return endSend() == GprsSIM900::OK ? sent : 0;
+}
+
+unsigned char GprsSIM900::beginSend(char connection, unsigned long len) {
+    if (sending) {
+        return GprsSIM900::ERROR;
+    }
+    sending = true;
+    sendFailed = false;
+    sendConnection = connection;
+    sendRemaining = len;
+    frameRemaining = 0;
+    sendFramed = 0;
+    sendAccepted = 0;
+    framesPending = 0;
+    return GprsSIM900::OK;
+}
+
+unsigned int GprsSIM900::write(const unsigned char *buf, unsigned int len) {
+    unsigned int n, written = 0;
+    if (sim->isInDataMode()) {
+        dataWrittenAt = millis();
+        return (unsigned int) sim->write(buf, len);
+    }
+    if (!sending) {
+        return 0;
+    }
+    while (written < len) {
+
+        // An open frame takes its bytes even once another failed, the modem waits for them
+        if (frameRemaining == 0) {
+            if (sendRemaining == 0 || sendFailed || !openFrame()) {
+                break;
+            }
+        }
+        n = len - written < frameRemaining ? len - written : frameRemaining;
+        sim->write(buf + written, n);
+        written += n;
+        frameRemaining -= n;
+        if (frameRemaining == 0) {
+            closeFrame();
+        }
+    }
+    return written;
+}
+
+unsigned int GprsSIM900::write(unsigned char c) {
+    return write(&c, 1);
+}
+
+unsigned int GprsSIM900::write(const __FlashStringHelper *str) {
+    const char *p = (const char *) str;
+    unsigned char buf[16];
+    unsigned int n, chunk, len = strlen_P(p), written = 0;
+    while (written < len) {
+        chunk = len - written < sizeof(buf) ? len - written : sizeof(buf);
+        memcpy_P(buf, p + written, chunk);
+        n = write(buf, chunk);
+        written += n;
+        if (n < chunk) {
+            break;
+        }
+    }
+    return written;
+}
+
+unsigned char GprsSIM900::endSend() {
+    if (!sending) {
+        return GprsSIM900::ERROR;
+    }
+
+    // The modem takes every byte the frame promised: nothing goes in place of the missing ones
+    if (frameRemaining > 0) {
+        return GprsSIM900::ERROR;
+    }
+    awaitFrames(0);
+    sending = false;
+    return sendFailed || sendRemaining > 0 ? GprsSIM900::ERROR : GprsSIM900::OK;
+}
+
+bool GprsSIM900::openFrame() {
+    unsigned int size = sendRemaining < GPRS_SIM900_MAX_SEND_SIZE ? (unsigned int) sendRemaining
+            : GPRS_SIM900_MAX_SEND_SIZE;
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSEND="));
+    awaitFrames(GPRS_SIM900_SEND_WINDOW - 1);
+    if (sendFailed) {
+        return false;
+    }
+    if (sendConnection != (char) -1) {
+        command.append((char) ('0' + sendConnection));
+        command.append(',');
+    }
+    command.appendNumber(size);
+
+    // The SEND OK of the frames before may come in the middle of the prompt, as URC_SEND
+    sim->setSendingFrame(true);
+    if (!sim->sendCommandExpecting(&command, F(">"))) {
+        sendFailed = true;
+        sim->setSendingFrame(framesPending > 0);
+        return false;
+    }
+    sendRemaining -= size;
+    frameSize = size;
+    frameRemaining = size;
+    return true;
+}
+
+void GprsSIM900::closeFrame() {
+
+    // The frame is on its way, its SEND OK is collected while the next one is written
+    sendFramed += frameSize;
+    framesWrittenAt[(framesHead + framesPending) % GPRS_SIM900_SEND_WINDOW] = millis();
+    framesPending++;
+    if (quickSend) {
+        deliveryConnection = sendConnection;
+    }
+}
+
+void GprsSIM900::awaitFrames(unsigned char pending) {
+    unsigned long latency;
+    while (framesPending > pending && !sendFailed) {
+        sim->poll();
+        latency = millis() - framesWrittenAt[framesHead];
+        if (framesPending > pending && latency >= sim->getTimeout(SIM900::LATENCY_SEND)) {
+            if (!quickSend) {
+                sim->recordLatency(SIM900::LATENCY_SEND, SIM900::COMMAND_TIMEOUT, latency);
+            }
+            sendFailed = true;
+        }
+    }
+
+    // What fails is not waited for any longer, a late SEND OK is left in a response
+    if (sendFailed) {
+        framesPending = 0;
+    }
+    sim->setSendingFrame(frameRemaining > 0 || framesPending > 0);
+}
+
+void GprsSIM900::onFrameSent(SIM900 *sim, unsigned char code, char connection, const char *line, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    unsigned long size = gprs->sendFramed - gprs->sendAccepted;
+    if (gprs->framesPending == 0) {
+        return;
+    }
+
+    // Only the last frame is shorter than the others, the oldest is as long as one or what is left
+    gprs->framesPending--;
+    if (strncmp_P(line, PSTR("SEND FAIL"), 9) == 0) {
+        gprs->sendFailed = true;
+    } else {
+        gprs->sendAccepted += size < GPRS_SIM900_MAX_SEND_SIZE ? size : GPRS_SIM900_MAX_SEND_SIZE;
+
+        // DATA ACCEPT does not wait for the peer, it is not measured into the send latency
+        if (gprs->quickSend) {
+            gprs->deliveryStale = true;
+        } else {
+            sim->recordLatency(SIM900::LATENCY_SEND, SIM900::COMMAND_OK,
+                    millis() - gprs->framesWrittenAt[gprs->framesHead]);
+        }
+    }
+    gprs->framesHead = (gprs->framesHead + 1) % GPRS_SIM900_SEND_WINDOW;
+    sim->setSendingFrame(gprs->frameRemaining > 0 || gprs->framesPending > 0);
+}
+
+unsigned char GprsSIM900::useDataHeader(bool use) {
+    bool expected;
+    expected = sim->sendCommandExpecting(use ? F("+CIPHEAD=1") : F("+CIPHEAD=0"), F("OK"), true);
+    return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+RingBuffer *GprsSIM900::getReceiveBuffer(char connection) {
+    unsigned char i = connection == (char) -1 ? 0 : (unsigned char) connection;
+    return i < GPRS_SIM900_RECEIVE_CONNECTIONS ? &receiveBuffers[i] : NULL;
+}
+
+RingBuffer *GprsSIM900::onData(SIM900 *sim, char connection, unsigned int length, void *context) {
+    return ((GprsSIM900 *) context)->getReceiveBuffer(connection);
+}
+
+int GprsSIM900::available(char connection) {
+    RingBuffer *buffer = getReceiveBuffer(connection);
+    if (buffer == NULL) {
+        return 0;
+    }
+    sim->poll();
+    return buffer->available();
+}
+
+int GprsSIM900::read(char connection, unsigned char *buf, unsigned int len) {
+    RingBuffer *buffer = getReceiveBuffer(connection);
+    unsigned int n = 0;
+    int c;
+    if (buffer == NULL) {
+        return 0;
+    }
+
+    // Each round makes room for the payload waiting behind the buffer
+    while (n < len) {
+        c = buffer->get();
+        if (c < 0) {
+            sim->poll();
+            c = buffer->get();
+            if (c < 0) {
+                break;
+            }
+        }
+        buf[n++] = (unsigned char) c;
+    }
+    return (int) n;
+}
+
+unsigned char GprsSIM900::useTransparentMode(bool use) {
+    bool expected;
+    if (use && multiplexed) {
+        return GprsSIM900::ERROR;
+    }
+    expected = sim->sendCommandExpecting(use ? F("+CIPMODE=1") : F("+CIPMODE=0"), F("OK"), true);
+    if (expected) {
+        transparent = use;
+    }
+    return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+unsigned char GprsSIM900::escape() {
+    if (!sim->isInDataMode()) {
+        return GprsSIM900::OK;
+    }
+    while (millis() - dataWrittenAt < GPRS_SIM900_ESCAPE_GUARD_TIME) {
+        sim->poll();
+    }
+
+    // The peer closed meanwhile, the modem is back in command mode
+    if (!sim->isInDataMode()) {
+        return GprsSIM900::ERROR;
+    }
+    sim->write((const uint8_t *) "+++", 3);
+
+    // Without an answer the modem already left data mode, the connection is gone
+    sim->setDataMode(false);
+    sim->expectResponse(F("OK"), GPRS_SIM900_ESCAPE_GUARD_TIME + SIM900_DEFAULT_COMMAND_TIMEOUT);
+    return (unsigned char) (sim->waitForCommand() == SIM900::COMMAND_OK ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+unsigned char GprsSIM900::resume() {
+    if (sim->isInDataMode()) {
+        return GprsSIM900::OK;
+    }
+    if (!transparent) {
+        return GprsSIM900::ERROR;
+    }
+
+    // CONNECT is taken as a connection event, which enters data mode
+    sim->setConnectPending(true);
+    sim->sendCommandExpecting(F("O"), F("CONNECT"), true);
+    sim->setConnectPending(false);
+    return (unsigned char) (sim->isInDataMode() ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+unsigned char GprsSIM900::useQuickSend(bool use) {
+    bool expected;
+    expected = sim->sendCommandExpecting(use ? F("+CIPQSEND=1") : F("+CIPQSEND=0"), F("OK"), true);
+    if (expected) {
+        quickSend = use;
+    }
+    return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
+}
+
+unsigned char GprsSIM900::useKeepalive(unsigned int idle, unsigned int interval, unsigned char count) {
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPTKA="));
+    if (idle == 0) {
+        command.append('0');
+    } else {
+        command.append(F("1,"));
+        command.appendNumber(idle);
+        command.append(',');
+        command.appendNumber(interval);
+        command.append(',');
+        command.appendNumber(count);
+    }
+    if (!sim->sendCommandExpecting(&command, F("OK"))) {
+        return GprsSIM900::ERROR;
+    }
+    keepalive = idle != 0;
+    return GprsSIM900::OK;
+}
+
+unsigned char GprsSIM900::usePersistentConnection(char connection, const char *mode, const char *address,
+        unsigned int port) {
+    if (channelIndex(connection) == GPRS_SIM900_CONNECTIONS) {
+        return GprsSIM900::ERROR;
+    }
+    persistentConnection = connection;
+    persistentMode = mode;
+    persistentAddress = address;
+    persistentPort = port;
+    reconnects = 0;
+
+    // Without keepalive a silent drop is only found out by the next send
+    useKeepalive(GPRS_SIM900_KEEPALIVE_IDLE, GPRS_SIM900_KEEPALIVE_INTERVAL, GPRS_SIM900_KEEPALIVE_COUNT);
+    return GprsSIM900::OK;
+}
+
+unsigned char GprsSIM900::connect() {
+    unsigned char i = channelIndex(persistentConnection);
+    if (persistentAddress == NULL) {
+        return GprsSIM900::ERROR;
+    }
+
+    // Takes in a CLOSED which came since the last call
+    sim->poll();
+    if (channelStates[i] == CHANNEL_CONNECTED) {
+        return GprsSIM900::OK;
+    }
+    if (channelStates[i] == CHANNEL_CLOSED || channelStates[i] == CHANNEL_FAILED) {
+        reconnects++;
+    }
+    return open(persistentConnection, persistentMode, persistentAddress, persistentPort);
+}
+
+unsigned int GprsSIM900::sendPersistent(unsigned char *buf, unsigned int len) {
+    unsigned int sent;
+    if (connect() != GprsSIM900::OK) {
+        return 0;
+    }
+    sent = send(persistentConnection, buf, len);
+    if (sent > 0 || sendAccepted > 0) {
+        return sent;
+    }
+
+    // The peer may have gone without the modem saying so yet
+    close(persistentConnection);
+    channelStates[channelIndex(persistentConnection)] = CHANNEL_CLOSED;
+    if (connect() != GprsSIM900::OK) {
+        return 0;
+    }
+    return send(persistentConnection, buf, len);
+}
+
+unsigned char GprsSIM900::endPersistentConnection() {
+    unsigned char i = channelIndex(persistentConnection), result = GprsSIM900::OK;
+    if (persistentAddress == NULL) {
+        return GprsSIM900::ERROR;
+    }
+    if (channelStates[i] == CHANNEL_CONNECTED || channelStates[i] == CHANNEL_CONNECTING) {
+        result = close(persistentConnection);
+    }
+    persistentAddress = NULL;
+    return result;
+}
+
+bool GprsSIM900::queryDelivery(char connection) {
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPACK"));
+    if (sim->isBusy()) {
+        return false;
+    }
     if (connection != (char) -1) {
-        sim->write('0' + connection);
-        sim->write(',');
+        command.append('=');
+        command.append((char) ('0' + connection));
     }
-    sim->print(len, DEC);
-    ok = sim->sendCommandExpecting("", ">");
-    if (ok) {
-        sent = (unsigned int) sim->write((const char *) buf, len);
-        pos = sim->waitUntilReceive("SEND OK", GPRS_SIM900_SEND_TIMEOUT);
+    deliveryConnection = connection;
+    deliveryQueriedAt = millis();
+    sim->measureLatency(SIM900::LATENCY_ACK);
+
+    // Waits for the final OK, the +CIPACK line stays in the response before it
+    return sim->submitCommand(&command, F("OK"), sim->getTimeout(SIM900::LATENCY_ACK), onDeliveryQueried, this);
+}
+
+void GprsSIM900::onDeliveryQueried(SIM900 *sim, unsigned char result, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    TransmittingState state;
+    const char *p;
+    if (result != SIM900::COMMAND_OK) {
+        return;
+    }
+    p = strstr_P((const char *) sim->getLastResponse(), PSTR("+CIPACK: "));
+
+    // < +CIPACK: 2,2,0
+    if (p != NULL && sscanf_P(p, PSTR("+CIPACK: %u,%u,%u"), &state.txlen, &state.acklen, &state.nacklen) == 3) {
+        gprs->deliveryPending = state.nacklen;
+        gprs->deliveryStale = false;
+    }
+}
+
+void GprsSIM900::poll() {
+    sim->poll();
+    serviceQueue();
+
+    // Not while a payload waits to be read, what would not fit behind the query is dropped
+    if (quickSend && !sending && (deliveryStale || deliveryPending > 0) && !sim->isBusy()
+            && !sim->isReceivingPayload() && millis() - deliveryQueriedAt >= GPRS_SIM900_DELIVERY_POLL_INTERVAL) {
+        queryDelivery(deliveryConnection);
+    }
+}
+
+unsigned char GprsSIM900::waitForDelivery(char connection, unsigned int unacknowledged, unsigned long timeout) {
+    unsigned long start = millis();
+    for (;;) {
+        sim->waitForCommand();
+        if (!queryDelivery(connection)) {
+            return GprsSIM900::ERROR;
+        }
+        if (sim->waitForCommand() != SIM900::COMMAND_OK) {
+            return GprsSIM900::ERROR;
+        }
+        if (!deliveryStale && deliveryPending <= unacknowledged) {
+            return GprsSIM900::OK;
+        }
+        if (millis() - start >= timeout) {
+            return GprsSIM900::ERROR;
+        }
+        while (millis() - deliveryQueriedAt < GPRS_SIM900_DELIVERY_POLL_INTERVAL) {
+            sim->poll();
+        }
     }
-    return pos >= 0 ? sent : 0;
 }
 
 unsigned char GprsSIM900::close(char connection) {
-    int pos;
-    sim->write("AT+CIPCLOSE=1");
+    bool expected;
+    unsigned char i = channelIndex(connection);
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPCLOSE="));
+    escape();
+    if (i < GPRS_SIM900_CONNECTIONS) {
+        queuedRemaining[i] = 0;
+
+        // Closed by the peer or with the bearer, the modem would only answer ERROR
+        if (channelStates[i] == CHANNEL_CLOSED) {
+            channelStates[i] = CHANNEL_IDLE;
+            return GprsSIM900::OK;
+        }
+    }
+
+    // Quick close: AT+CIPCLOSE=1 in single connection, AT+CIPCLOSE=<n>,1 in multi-IP
     if (connection != (char) -1) {
-        sim->write(',');
-        sim->write('0' + connection);
+        command.append((char) ('0' + connection));
+        command.append(',');
     }
-    sim->sendCommand();
-    pos = sim->waitUntilReceive("CLOSE OK", GPRS_SIM900_CIPSTART_TIMEOUT);
-    if (pos >= 0) {
-        return GprsSIM900::OK;
+    command.append('1');
+
+    // An ERROR, when the peer closed it meanwhile, ends the wait too
+    sim->measureLatency(SIM900::LATENCY_CLOSE);
+    expected = sim->sendCommandExpecting(&command, F("CLOSE OK"), sim->getTimeout(SIM900::LATENCY_CLOSE));
+    if (i < GPRS_SIM900_CONNECTIONS && channelStates[i] != CHANNEL_FREE) {
+        channelStates[i] = CHANNEL_IDLE;
     }
-    return GprsSIM900::ERROR;
+    return (unsigned char) (expected ? GprsSIM900::OK : GprsSIM900::ERROR);
 }
 
 unsigned char GprsSIM900::close() {
     return close(-1);
 }
 
-// TODO
 unsigned char GprsSIM900::resolve(const char *name, unsigned char ip[4]) {
-    OperationResult result = GprsSIM900::ERROR;
-    bool ok;
-    int pos;
-    const char* p;
-    sim->write("AT+CDNSGIP=\"");
-    sim->write(name);
-    ok = sim->sendCommandExpecting("\"", "OK");
-    if (ok) {
-        pos = sim->waitUntilReceive("+CDNSGIP: 1", GPRS_SIM900_CDNSGIP_TIMEOUT);
-        if (pos >= 0) {
-            pos = sim->waitUntilReceive("\",\"", GPRS_SIM900_CDNSGIP_TIMEOUT);
-            if (pos >= 0) {
-                p = (const char*) sim->getLastResponse();
-                if (parseIp(p + pos, ip) == 4) {
-                    result = GprsSIM900::OK;
-                }
+    unsigned int length = strlen(name);
+    unsigned char result;
+    GprsSIM900DnsEntry *entry = findDns(name, length);
+    if (entry == NULL) {
+        result = startResolve(name, &entry);
+        if (result != GprsSIM900::OK) {
+            return result;
+        }
+    }
+    waitForDns(entry);
+
+    // A timed out entry is dropped, and may have been taken since
+    if (!isEntryOf(entry, name, length) || entry->state != DNS_RESOLVED) {
+        return GprsSIM900::ERROR;
+    }
+    memcpy(ip, entry->ip, 4);
+    return GprsSIM900::OK;
+}
+
+unsigned char GprsSIM900::prefetch(const char * const *names, unsigned char count) {
+    GprsSIM900DnsEntry *entry;
+    unsigned char i, resolved = 0;
+    for (i = 0; i < count; i++) {
+        if (findDns(names[i], strlen(names[i])) == NULL) {
+            startResolve(names[i], &entry);
+        }
+    }
+    waitForDns(NULL);
+    for (i = 0; i < count; i++) {
+        entry = findDns(names[i], strlen(names[i]));
+        if (entry != NULL && entry->state == DNS_RESOLVED) {
+            resolved++;
+        }
+    }
+    return resolved;
+}
+
+void GprsSIM900::flushDnsCache() {
+    memset(dnsCache, 0, sizeof(dnsCache));
+}
+
+bool GprsSIM900::isEntryOf(GprsSIM900DnsEntry *entry, const char *name, unsigned int length) {
+    return length < sizeof(entry->name) && entry->name[length] == '\0'
+            && strncasecmp(entry->name, name, length) == 0;
+}
+
+GprsSIM900DnsEntry *GprsSIM900::findDns(const char *name, unsigned int length) {
+    unsigned char i;
+    GprsSIM900DnsEntry *entry;
+    for (i = 0; i < GPRS_SIM900_DNS_CACHE_SIZE; i++) {
+        entry = &dnsCache[i];
+        if (entry->state == DNS_EMPTY || !isEntryOf(entry, name, length)) {
+            continue;
+        }
+        if ((entry->state == DNS_RESOLVED && millis() - entry->at >= GPRS_SIM900_DNS_TTL)
+                || (entry->state == DNS_FAILED && millis() - entry->at >= GPRS_SIM900_DNS_NEGATIVE_TTL)) {
+            entry->state = DNS_EMPTY;
+            return NULL;
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+unsigned char GprsSIM900::startResolve(const char *name, GprsSIM900DnsEntry **entry) {
+    unsigned char i;
+    GprsSIM900DnsEntry *chosen = NULL;
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CDNSGIP="));
+    command.appendQuoted(name);
+    if (command.isOverflowed() || strlen(name) >= GPRS_SIM900_DNS_NAME_SIZE) {
+        return GprsSIM900::COMMAND_TOO_LONG;
+    }
+
+    // A free entry, else the one which was resolved or failed the longest ago
+    for (i = 0; i < GPRS_SIM900_DNS_CACHE_SIZE; i++) {
+        if (dnsCache[i].state == DNS_EMPTY) {
+            chosen = &dnsCache[i];
+            break;
+        }
+        if (dnsCache[i].state != DNS_PENDING && (chosen == NULL || millis() - dnsCache[i].at > millis() - chosen->at)) {
+            chosen = &dnsCache[i];
+        }
+    }
+    if (chosen == NULL) {
+        return GprsSIM900::ERROR;
+    }
+
+    // Pending before the command, the answer may come with its OK
+    strcpy(chosen->name, name);
+    chosen->state = DNS_PENDING;
+    chosen->at = millis();
+    if (!sim->sendCommandExpecting(&command, F("OK"))) {
+        chosen->state = DNS_EMPTY;
+        return GprsSIM900::ERROR;
+    }
+    *entry = chosen;
+    return GprsSIM900::OK;
+}
+
+void GprsSIM900::waitForDns(GprsSIM900DnsEntry *entry) {
+    unsigned long timeout = sim->getTimeout(SIM900::LATENCY_DNS);
+    unsigned char i;
+    bool pending = true;
+    while (pending) {
+        sim->poll();
+        pending = false;
+        for (i = 0; i < GPRS_SIM900_DNS_CACHE_SIZE; i++) {
+            if (dnsCache[i].state != DNS_PENDING || (entry != NULL && entry != &dnsCache[i])) {
+                continue;
+            }
+            if (millis() - dnsCache[i].at >= timeout) {
+                sim->recordLatency(SIM900::LATENCY_DNS, SIM900::COMMAND_TIMEOUT, millis() - dnsCache[i].at);
+                dnsCache[i].state = DNS_EMPTY;
+            } else {
+                pending = true;
             }
         }
     }
-    return result;
 }
 
+void GprsSIM900::onDnsResolved(SIM900 *sim, unsigned char code, char connection, const char *line, void *context) {
+    GprsSIM900 *gprs = (GprsSIM900 *) context;
+    GprsSIM900DnsEntry *entry = NULL;
+    const char *name, *end;
+    char address[16];
+    unsigned char i, length;
+    if (strncmp_P(line, PSTR("+CDNSGIP: 1,\""), 13) == 0) {
+        name = line + 13;
+        end = strchr(name, '"');
+        if (end == NULL) {
+            return;
+        }
+        entry = gprs->findDns(name, end - name);
+        if (entry == NULL || entry->state != DNS_PENDING) {
+            return;
+        }
+
+        // The first address only: ,"<ip>"[,"<ip2>"]
+        length = 0;
+        if (end[1] == ',' && end[2] == '"') {
+            for (end += 3; *end != '"' && *end != '\0' && length < sizeof(address) - 1; end++) {
+                address[length++] = *end;
+            }
+        }
+        address[length] = '\0';
+        sim->recordLatency(SIM900::LATENCY_DNS, SIM900::COMMAND_OK, millis() - entry->at);
+        if (isIpAddress(address)) {
+            parseIp(address, entry->ip);
+            entry->state = DNS_RESOLVED;
+        } else {
+            entry->state = DNS_FAILED;
+        }
+        entry->at = millis();
+        return;
+    }
+
+    // +CDNSGIP: 0,<error> does not tell the name: the modem answers in order
+    for (i = 0; i < GPRS_SIM900_DNS_CACHE_SIZE; i++) {
+        if (gprs->dnsCache[i].state == DNS_PENDING
+                && (entry == NULL || millis() - gprs->dnsCache[i].at > millis() - entry->at)) {
+            entry = &gprs->dnsCache[i];
+        }
+    }
+    if (entry != NULL) {
+        sim->recordLatency(SIM900::LATENCY_DNS, SIM900::COMMAND_FAILED, millis() - entry->at);
+        entry->state = DNS_FAILED;
+        entry->at = millis();
+    }
+}
+
+#ifndef GPRS_NO_SERVER
 unsigned char GprsSIM900::configureServer(unsigned char mode, unsigned int port) {
-    mode &= 0x01;
-    sim->write("AT+CIPSERVER=");
-    sim->print(mode, DEC);
-    sim->write(',');
-    sim->print(mode, DEC);
-    return sim->sendCommandExpecting("", "OK") ? GprsSIM900::OK : GprsSIM900::ERROR;
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSERVER="));
+    command.appendNumber(mode & 0x01);
+    command.append(',');
+    command.appendNumber(port);
+    return sim->sendCommandExpecting(&command, F("OK")) ? GprsSIM900::OK : GprsSIM900::ERROR;
 }
+#endif
 
 unsigned char GprsSIM900::shutdown() {
-    return sim->sendCommandExpecting("AT+CIPSHUT", "SHUT OK") ? GprsSIM900::OK : GprsSIM900::ERROR;
+    unsigned char i;
+    escape();
+    if (!sim->sendCommandExpecting(F("AT+CIPSHUT"), F("SHUT OK"))) {
+        return GprsSIM900::ERROR;
+    }
+
+    // Every connection is closed, the ids stay with whoever allocated them
+    for (i = 0; i < GPRS_SIM900_CONNECTIONS; i++) {
+        if (channelStates[i] != CHANNEL_FREE) {
+            channelStates[i] = CHANNEL_IDLE;
+        }
+        queuedRemaining[i] = 0;
+    }
+    return GprsSIM900::OK;
 }
 
 unsigned char GprsSIM900::getTransmittingState(char connection, void *stateStruct) {
     int pos;
     unsigned char *response;
     TransmittingState *state = (TransmittingState *) stateStruct;
-    sim->write("AT+CIPACK=");
+    StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPACK"));
     if (connection != (char) -1) {
-        sim->write(',');
-        sim->write('0' + connection);
+        command.append('=');
+        command.append((char) ('0' + connection));
     }
-    sim->sendCommand();
-    pos = sim->waitUntilReceive("+CIPACK", GPRS_SIM900_CIPACK_TIMEOUT);
+    sim->sendCommand(&command);
+    pos = waitUntilReceive(F("+CIPACK"), SIM900::LATENCY_ACK);
     if (pos >= 0) {
         response = sim->getLastResponse();
         // < +CIPACK: 2,2,0
-        sscanf((const char *) (response + pos), "+CIPACK: %d,%d,%d", &state->txlen, &state->acklen, &state->nacklen);
+        sscanf_P((const char *) (response + pos), PSTR("+CIPACK: %d,%d,%d"), &state->txlen, &state->acklen,
+                &state->nacklen);
         return GprsSIM900::OK;
     } else {
         state->txlen = state->acklen = state->nacklen = 0;
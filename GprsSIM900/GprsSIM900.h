@@ -10,6 +10,7 @@
  * <ul>
  *  <li>call init</li>
  *  <li>call useMultiplexer</li>
+ *  <li>call useDataHeader</li>
  *  <li>call attach</li>
  *  <li>call bringUp</li>
  *  <li>call obtainIp</li>
@@ -22,18 +23,112 @@
 #ifndef __ARDUINO_DRIVER_GSM_GPRS_SIM900_H__
 #define __ARDUINO_DRIVER_GSM_GPRS_SIM900_H__ 1
 
+#ifndef GPRS_SIM900_MAX_COMMAND_LENGHT
 #define GPRS_SIM900_MAX_COMMAND_LENGHT  64
+#endif
+
 #define GPRS_SIM900_CDNSGIP_TIMEOUT     5000UL
 #define GPRS_SIM900_CIICR_TIMEOUT       10000UL
 #define GPRS_SIM900_CIPSTART_TIMEOUT    5000UL
 #define GPRS_SIM900_SEND_TIMEOUT        10000UL
 #define GPRS_SIM900_CIPSTATUS_TIMEOUT   5000UL
 #define GPRS_SIM900_CIPACK_TIMEOUT      5000UL
+#define GPRS_SIM900_MIN_TIMEOUT         1000UL
+#define GPRS_SIM900_MAX_TIMEOUT_FACTOR  4
+
+#ifndef GPRS_SIM900_MAX_SEND_SIZE
+#define GPRS_SIM900_MAX_SEND_SIZE       1460
+#endif
+
+/**
+ * Frames of a payload written whose SEND OK is still awaited when the
+ * prompt of the next one is asked for.
+ */
+#ifndef GPRS_SIM900_SEND_WINDOW
+#define GPRS_SIM900_SEND_WINDOW         2
+#endif
+
+#define GPRS_SIM900_CONNECTIONS         8
+
+#ifndef GPRS_SIM900_RECEIVE_CONNECTIONS
+#define GPRS_SIM900_RECEIVE_CONNECTIONS 4
+#endif
+
+#ifndef GPRS_SIM900_RECEIVE_BUFFER_SIZE
+#define GPRS_SIM900_RECEIVE_BUFFER_SIZE 64
+#endif
+
+#ifndef GPRS_SIM900_ESCAPE_GUARD_TIME
+#define GPRS_SIM900_ESCAPE_GUARD_TIME   1000UL
+#endif
+
+#ifndef GPRS_SIM900_DELIVERY_POLL_INTERVAL
+#define GPRS_SIM900_DELIVERY_POLL_INTERVAL  250UL
+#endif
+
+#ifndef GPRS_SIM900_KEEPALIVE_IDLE
+#define GPRS_SIM900_KEEPALIVE_IDLE      60
+#endif
+
+#ifndef GPRS_SIM900_KEEPALIVE_INTERVAL
+#define GPRS_SIM900_KEEPALIVE_INTERVAL  30
+#endif
+
+#ifndef GPRS_SIM900_KEEPALIVE_COUNT
+#define GPRS_SIM900_KEEPALIVE_COUNT     3
+#endif
+
+/**
+ * The names the DNS cache holds, 41 bytes each with the default name size.
+ * prefetch() resolves at most as many names at once.
+ */
+#ifndef GPRS_SIM900_DNS_CACHE_SIZE
+#define GPRS_SIM900_DNS_CACHE_SIZE      2
+#endif
+
+/**
+ * The longest name the DNS cache takes, with its \0. open() leaves a
+ * longer one to the modem; the command line cannot carry more than
+ * GPRS_SIM900_MAX_COMMAND_LENGHT - 14 anyway.
+ */
+#ifndef GPRS_SIM900_DNS_NAME_SIZE
+#define GPRS_SIM900_DNS_NAME_SIZE       32
+#endif
+
+#ifndef GPRS_SIM900_DNS_TTL
+#define GPRS_SIM900_DNS_TTL             600000UL
+#endif
+
+#ifndef GPRS_SIM900_DNS_NEGATIVE_TTL
+#define GPRS_SIM900_DNS_NEGATIVE_TTL    30000UL
+#endif
 
 #include <Gprs.h>
 #include <SIM900.h>
 #include <stdlib.h>
 
+/**
+ * A name in the DNS cache.
+ */
+struct GprsSIM900DnsEntry {
+
+    /**
+     * The name, compared regardless of case.
+     */
+    char name[GPRS_SIM900_DNS_NAME_SIZE];
+
+    /**
+     * When it was resolved, failed, or was asked for while pending.
+     */
+    unsigned long at;
+    unsigned char ip[4];
+
+    /**
+     * One of GprsSIM900::DnsEntryState.
+     */
+    unsigned char state;
+};
+
 class GprsSIM900 : public Gprs {
     
     /**
@@ -45,15 +140,222 @@ class GprsSIM900 : public Gprs {
      * Multi connection.
      */
     bool multiplexed;
+
+    /**
+     * Sets up the latency class of a network command. The fixed timeout
+     * is used until the first latency is observed; the learned one is
+     * kept within [GPRS_SIM900_MIN_TIMEOUT, initial * GPRS_SIM900_MAX_TIMEOUT_FACTOR].
+     */
+    void learnTimeout(unsigned char latencyClass, unsigned long initial);
+
+    /**
+     * Waits for the final response of a network command, with the timeout
+     * learned for its class, and measures it into the class.
+     *
+     * @return              Where the response starts, -1 if not received.
+     */
+    int waitUntilReceive(const __FlashStringHelper *str, unsigned char latencyClass);
+
+    /**
+     * Payload being sent: its connection, the bytes not yet framed, the
+     * size of the open frame and the bytes it still takes, the bytes of
+     * the frames written in full and of those the modem accepted, and
+     * whether a frame failed.
+     */
+    char sendConnection;
+    unsigned long sendRemaining;
+    unsigned int frameSize;
+    unsigned int frameRemaining;
+    unsigned long sendFramed;
+    unsigned long sendAccepted;
+    bool sending;
+    bool sendFailed;
+
+    /**
+     * Frames written whose SEND OK has not come yet, oldest first from
+     * framesHead, with when each was written.
+     */
+    unsigned long framesWrittenAt[GPRS_SIM900_SEND_WINDOW];
+    unsigned char framesHead;
+    unsigned char framesPending;
+
+    /**
+     * Waits until fewer than GPRS_SIM900_SEND_WINDOW frames wait for
+     * their SEND OK, then asks for the prompt of the next frame, as long
+     * as the payload or GPRS_SIM900_MAX_SEND_SIZE.
+     *
+     * @return              false if a frame failed.
+     */
+    bool openFrame();
+
+    /**
+     * Counts the frame just written among those waiting for their SEND OK.
+     */
+    void closeFrame();
+
+    /**
+     * Waits until at most the given number of frames wait for their SEND
+     * OK, or one failed or timed out.
+     */
+    void awaitFrames(unsigned char pending);
+
+    /**
+     * Called with the SEND OK, SEND FAIL or DATA ACCEPT (quick send mode)
+     * of the oldest frame written.
+     */
+    static void onFrameSent(SIM900 *sim, unsigned char code, char connection, const char *line, void *context);
+
+    /**
+     * Quick send mode (+CIPQSEND=1).
+     */
+    bool quickSend;
+
+    /**
+     * Delivery of the bytes accepted in quick send mode: the connection
+     * they went to, the bytes not yet acknowledged by the peer as last
+     * reported by AT+CIPACK, whether bytes were accepted since, and when
+     * AT+CIPACK was last issued.
+     */
+    char deliveryConnection;
+    unsigned int deliveryPending;
+    bool deliveryStale;
+    unsigned long deliveryQueriedAt;
+
+    /**
+     * Called when the response of AT+CIPACK arrives or does not.
+     */
+    static void onDeliveryQueried(SIM900 *sim, unsigned char result, void *context);
+
+    /**
+     * Transparent mode (+CIPMODE=1), and when a byte was last written to
+     * the connection in data mode.
+     */
+    bool transparent;
+    unsigned long dataWrittenAt;
+
+    /**
+     * Bytes received on each connection, the single connection using the
+     * first buffer.
+     */
+    StaticRingBuffer<GPRS_SIM900_RECEIVE_BUFFER_SIZE> receiveBuffers[GPRS_SIM900_RECEIVE_CONNECTIONS];
+
+    /**
+     * Gives SIM900 the buffer of the connection a payload arrives on.
+     */
+    static RingBuffer *onData(SIM900 *sim, char connection, unsigned int length, void *context);
+
+    /**
+     * State and last error of each connection (one of ChannelState and
+     * ChannelError), the single connection using the first one.
+     */
+    unsigned char channelStates[GPRS_SIM900_CONNECTIONS];
+    unsigned char channelErrors[GPRS_SIM900_CONNECTIONS];
+
+    /**
+     * The connection AT+CIPSTART was issued for.
+     */
+    unsigned char openingChannel;
+
+    /**
+     * Sends queued on each connection: what is left to send and where it
+     * is. The connection a frame is being sent for (GPRS_SIM900_CONNECTIONS
+     * if none), its length, and the connection served last, so each one
+     * gets a frame in turn.
+     */
+    const unsigned char *queuedData[GPRS_SIM900_CONNECTIONS];
+    unsigned int queuedRemaining[GPRS_SIM900_CONNECTIONS];
+    unsigned char queueActive;
+    unsigned int queueFrame;
+    unsigned char queueTurn;
+
+    /**
+     * Index of a connection in the tables, GPRS_SIM900_CONNECTIONS if
+     * invalid. Without multi-IP connection there is only the first one.
+     */
+    unsigned char channelIndex(char connection);
+
+    /**
+     * Starts a frame of the next connection with something queued, if the
+     * modem is free.
+     */
+    void serviceQueue();
+
+    /**
+     * Fails what is queued on a connection.
+     */
+    void failQueue(unsigned char i);
+
+    /**
+     * Called when the prompt of a queued frame arrives or does not, and
+     * when its SEND OK arrives or does not.
+     */
+    static void onQueuedPrompt(SIM900 *sim, unsigned char result, void *context);
+    static void onQueuedSent(SIM900 *sim, unsigned char result, void *context);
+
+    /**
+     * Called when CIPSTART was refused.
+     */
+    static void onOpenSubmitted(SIM900 *sim, unsigned char result, void *context);
+
+    /**
+     * Tracks the connections from CONNECT OK, CONNECT FAIL and CLOSED.
+     */
+    static void onConnectionEvent(SIM900 *sim, unsigned char code, char connection, const char *line,
+            void *context);
+
+    /**
+     * Closes every connection when +PDP: DEACT tells the bearer is gone.
+     */
+    static void onBearerLost(SIM900 *sim, unsigned char code, char connection, const char *line, void *context);
+
+    /**
+     * Names resolved or being resolved, and whether open() connects to the
+     * address of a name rather than to the name.
+     */
+    GprsSIM900DnsEntry dnsCache[GPRS_SIM900_DNS_CACHE_SIZE];
+    bool resolvedOpen;
+
+    /**
+     * Tells if an entry holds a name, of the given length.
+     */
+    static bool isEntryOf(GprsSIM900DnsEntry *entry, const char *name, unsigned int length);
+
+    /**
+     * The entry of a name, NULL if it is not cached or expired.
+     */
+    GprsSIM900DnsEntry *findDns(const char *name, unsigned int length);
+
+    /**
+     * Asks the modem for a name, into a free or the oldest entry.
+     *
+     * @return              OperationResult
+     */
+    unsigned char startResolve(const char *name, GprsSIM900DnsEntry **entry);
+
+    /**
+     * Waits until an entry, or every entry if NULL, is no longer pending.
+     * Those which time out are dropped, not cached as failed.
+     */
+    void waitForDns(GprsSIM900DnsEntry *entry);
+
+    /**
+     * Fills the entry of +CDNSGIP.
+     */
+    static void onDnsResolved(SIM900 *sim, unsigned char code, char connection, const char *line, void *context);
+
+    /**
+     * The connection kept open by sendPersistent(), NULL address if none,
+     * whether TCP keepalive is on, and how many times it was reopened.
+     */
+    char persistentConnection;
+    const char *persistentMode;
+    const char *persistentAddress;
+    unsigned int persistentPort;
+    bool keepalive;
+    unsigned int reconnects;
     
 public:
     
-    enum OperationResult {
-        OK = 0,
-        ERROR = 1,
-        COMMAND_TOO_LONG = 2
-    };
-    
     enum DnsResolution {
         NOT_AUTHORIZATION = 0,
         INVALID_PARAMTER = 1,
@@ -79,6 +381,43 @@ public:
         ERROR_WHEN_QUERING = 0xff
     };
 
+    enum DnsEntryState {
+        DNS_EMPTY = 0,
+        DNS_PENDING = 1,
+        DNS_RESOLVED = 2,
+
+        // Cached for GPRS_SIM900_DNS_NEGATIVE_TTL, so it is not asked again
+        DNS_FAILED = 3
+    };
+
+    enum ChannelState {
+
+        // Not allocated
+        CHANNEL_FREE = 0,
+
+        // Allocated, or used without allocate(), and not connected
+        CHANNEL_IDLE = 1,
+        CHANNEL_CONNECTING = 2,
+        CHANNEL_CONNECTED = 3,
+
+        // Closed by the peer or the network
+        CHANNEL_CLOSED = 4,
+
+        // The connection could not be set up
+        CHANNEL_FAILED = 5
+    };
+
+    enum ChannelError {
+        CHANNEL_NO_ERROR = 0,
+        CHANNEL_CONNECT_FAILED = 1,
+        CHANNEL_CONNECT_TIMEOUT = 2,
+        CHANNEL_SEND_FAILED = 3,
+        CHANNEL_CLOSED_BY_PEER = 4,
+
+        // +PDP: DEACT, the connection cannot be reopened before a new bringUp()
+        CHANNEL_BEARER_LOST = 5
+    };
+
     struct TransmittingState {
         unsigned int txlen;
         unsigned int acklen;
@@ -98,10 +437,12 @@ public:
     virtual ~GprsSIM900() {}
 
     /**
-     * Initializes the device.
+     * Initializes the device, then waits up to SIM900_INITIALIZATION_TIMEOUT
+     * for the modem to attach to GPRS.
      * 
-     * @param           The bound rate to be used.
-     * @return          > 0 if success, 0 otherwise.
+     * @param           The bound rate to be used, or SIM900_AUTOBAUD.
+     * @return          > 0 if success, 0 if the modem did not start or did
+     *                  not attach in time.
      */
     unsigned char begin(long bound);
 
@@ -119,6 +460,29 @@ public:
      */
     unsigned char useMultiplexer(bool use);
 
+    /**
+     * Configures multi-IP connection, APN and optionally the DNS servers
+     * in a single command line.
+     *
+     * Should be called in IP INITIAL state, it replaces useMultiplexer,
+     * attach and configureDns calls. If the line would be too long for the
+     * batch, each setting is sent on its own.
+     *
+     * Example:
+     * > AT+CIPMUX=0;+CSTT="tim.br","tim","tim";+CDNSCFG="8.8.8.8","8.8.4.4"
+     * < OK
+     *
+     * @param use           0 disables multi IP connection and 1 enables.
+     * @param apn           The apn access point name.
+     * @param login         The GPRS user name.
+     * @param password      The GPRS password.
+     * @param primary       The primary DNS server, NULL to keep the current ones.
+     * @param secondary     The secondary DNS server.
+     * @return              OperationResult
+     */
+    unsigned char configure(bool use, const char *apn, const char *login, const char *password,
+            const char *primary = NULL, const char *secondary = NULL);
+
     /**
      * Start Task and Set APN, LOGIN, PASSWORD
      * 
@@ -286,13 +650,476 @@ public:
     /**
      * Send Data Through TCP or UDP Connection
      *
-     * @return
+     * A payload longer than GPRS_SIM900_MAX_SEND_SIZE is sent in several frames.
+     *
+     * @return              Number of bytes sent, 0 if it failed.
      */
     unsigned int send(char connection, unsigned char *buf, unsigned int len);
 
+    /**
+     * Starts sending a payload of known length, which does not need to be
+     * in RAM as a whole: its pieces are given with write(), from wherever
+     * they come (RAM, flash, a file, a sensor).
+     *
+     * The payload is cut in frames of at most GPRS_SIM900_MAX_SEND_SIZE
+     * bytes, each sent with its own AT+CIPSEND, and the pieces are written
+     * straight into them. The length is a promise: the modem takes every
+     * byte a frame was opened for. The prompt of the next frame is asked
+     * for as soon as a frame is written, without waiting for its SEND OK,
+     * up to GPRS_SIM900_SEND_WINDOW frames waiting for theirs.
+     *
+     * Example:
+     * > AT+CIPSEND=1460
+     * < >
+     * > data (1460 bytes)
+     * > AT+CIPSEND=540
+     * < >
+     * > data (540 bytes)
+     * < SEND OK
+     * < SEND OK
+     *
+     * @param connection    If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param len           Length of the whole payload.
+     * @return              OperationResult, ERROR if a payload is still being sent.
+     */
+    unsigned char beginSend(char connection, unsigned long len);
+
+    /**
+     * Sends the next piece of the payload. In data mode the bytes go
+     * straight to the peer, without beginSend().
+     *
+     * @param buf           The piece.
+     * @param len           Its length; what goes past the payload length is not sent.
+     * @return              Number of bytes sent, less than len if a frame failed.
+     */
+    unsigned int write(const unsigned char *buf, unsigned int len);
+
+    /**
+     * Sends the next byte of the payload.
+     *
+     * @param c
+     * @return              1 if sent, 0 otherwise.
+     */
+    unsigned int write(unsigned char c);
+
+    /**
+     * Sends the next piece of the payload, stored in flash.
+     *
+     * @param str           The \0 terminated piece.
+     * @return              Number of bytes sent.
+     */
+    unsigned int write(const __FlashStringHelper *str);
+
+    /**
+     * Waits for the SEND OK of the frames written and ends the payload.
+     *
+     * Ending a payload before all of it was written is an error of the
+     * caller. Between frames it fails the payload. Within a frame it fails
+     * and sends nothing: the modem still waits for the rest of the frame,
+     * to be given with write() before endSend() is called again.
+     *
+     * @return              OperationResult.
+     */
+    unsigned char endSend();
+
+    /**
+     * Bytes of the last payload the modem accepted, a frame at a time: on
+     * a failed send, where a new connection could take it up again.
+     *
+     * @return
+     */
+    inline unsigned long getAccepted() {
+        return sendAccepted;
+    }
+
+    /**
+     * Select Data Transmitting Mode
+     *
+     * In quick send mode a frame is done as soon as the modem buffered it
+     * (DATA ACCEPT) instead of when the peer acknowledged it (SEND OK),
+     * so the next frame starts one network round trip earlier. Delivery
+     * is then followed in the background with AT+CIPACK, see poll() and
+     * waitForDelivery().
+     *
+     * Example:
+     * > AT+CIPQSEND=1
+     * < OK
+     * > AT+CIPSEND=512
+     * < >
+     * > data (512 bytes)
+     * < DATA ACCEPT:512
+     *
+     * @param   use         true for quick send mode, false for normal mode.
+     * @return              OperationResult
+     */
+    unsigned char useQuickSend(bool use);
+
+    /**
+     * Add an IP Head at the Beginning of a Package Received
+     *
+     * Needed to receive in single connection mode, where the modem would
+     * otherwise mix the payloads with the responses; in multi-IP mode they
+     * always come with a +RECEIVE header. configure() enables it.
+     *
+     * Example:
+     * > AT+CIPHEAD=1
+     * < OK
+     * ...
+     * < +IPD,5:hello
+     *
+     * @param   use         true to add the header.
+     * @return              OperationResult
+     */
+    unsigned char useDataHeader(bool use);
+
+    /**
+     * Number of received bytes waiting to be read from a connection.
+     *
+     * @param connection    If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return
+     */
+    int available(char connection);
+
+    /**
+     * Reads the bytes received from a connection, without waiting for
+     * more. The payloads come with their headers parsed off, but a
+     * payload is not delimited from the next one: a protocol on top
+     * tells where a message ends.
+     *
+     * Example:
+     * < +IPD,5:hello
+     * < +RECEIVE,0,5:
+     * < hello
+     *
+     * @param connection    If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param buf           Where to store them.
+     * @param len           Room in buf.
+     * @return              Number of bytes read.
+     */
+    int read(char connection, unsigned char *buf, unsigned int len);
+
+    /**
+     * Tells if a connection was closed by the peer or the network, from
+     * its CLOSED or +PDP: DEACT.
+     *
+     * @param connection    If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return
+     */
+    inline bool isClosed(char connection) {
+        return getChannelState(connection) == CHANNEL_CLOSED;
+    }
+
+    /**
+     * The buffer of a connection, for its overflow counters.
+     *
+     * @param connection    If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return              NULL if the connection has no buffer.
+     */
+    RingBuffer *getReceiveBuffer(char connection);
+
+    /**
+     * Select TCPIP Application Mode
+     *
+     * In transparent mode the connection opened next is a raw byte stream:
+     * once it is up the modem is in data mode, where write() goes straight
+     * to the peer and read() gives what the peer sent, without AT+CIPSEND
+     * framing. Only a single connection (+CIPMUX=0) can be transparent,
+     * and the mode is selected before the connection is opened.
+     *
+     * Example:
+     * > AT+CIPMODE=1
+     * < OK
+     * > AT+CIPSTART="TCP","dalmirdasilva.com","3000"
+     * < OK
+     * <
+     * < CONNECT
+     *
+     * @param   use         true for transparent mode, false for normal mode.
+     * @return              OperationResult
+     */
+    unsigned char useTransparentMode(bool use);
+
+    /**
+     * Switches from data mode to command mode, the connection staying up.
+     *
+     * The +++ escape is only told from data by the silence around it: it
+     * waits until nothing was written for GPRS_SIM900_ESCAPE_GUARD_TIME,
+     * and the modem answers OK after the same silence. Bytes received and
+     * not read by then are taken as responses, so read them first.
+     *
+     * Example:
+     * > +++
+     * < OK
+     *
+     * @return              OperationResult, ERROR if the peer closed the
+     *                      connection while waiting, or the modem did not
+     *                      answer.
+     */
+    unsigned char escape();
+
+    /**
+     * Switches back from command mode to the data mode of the connection.
+     *
+     * Example:
+     * > ATO
+     * < CONNECT
+     *
+     * @return              OperationResult
+     */
+    unsigned char resume();
+
+    /**
+     * Tells if the transparent connection is in data mode. A peer close,
+     * seen by read(), available() or poll() in the data, ends it.
+     *
+     * @return
+     */
+    inline bool isInDataMode() {
+        return sim->isInDataMode();
+    }
+
+    /**
+     * Bytes received from the transparent connection, in data mode.
+     *
+     * @return
+     */
+    inline int available() {
+        return sim->available();
+    }
+
+    /**
+     * Reads a byte received from the transparent connection, in data mode.
+     *
+     * @return              The byte, -1 if none.
+     */
+    inline int read() {
+        return sim->read();
+    }
+
+    /**
+     * Issues AT+CIPACK without waiting for it; its response updates the
+     * delivery state when it arrives.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return              false if a command is in progress.
+     */
+    bool queryDelivery(char connection);
+
+    /**
+     * Runs the command engine, sends what is queued and, in quick send
+     * mode, asks for the delivery of the bytes accepted so far, every
+     * GPRS_SIM900_DELIVERY_POLL_INTERVAL ms until all are acknowledged,
+     * unless a received payload waits to be read. To be called from the
+     * main loop.
+     */
+    void poll();
+
+    /**
+     * Waits until at most the given number of bytes sent to a connection
+     * are not yet acknowledged by the peer.
+     *
+     * @param   connection      If multi-IP connection (+CIPMUX=1)
+     *                          0..7 the connection number, -1 otherwise.
+     * @param   unacknowledged  Watermark, 0 to wait for all of them.
+     * @param   timeout         Milliseconds.
+     * @return                  OperationResult, ERROR on timeout.
+     */
+    unsigned char waitForDelivery(char connection, unsigned int unacknowledged, unsigned long timeout);
+
+    /**
+     * Bytes not yet acknowledged by the peer, as last reported.
+     */
+    inline unsigned int getUnacknowledged() {
+        return deliveryPending;
+    }
+
+    /**
+     * Whether bytes were accepted since the delivery was last reported.
+     */
+    inline bool isDeliveryStale() {
+        return deliveryStale;
+    }
+
+    /**
+     * Starts up a connection without waiting for it: returns once the
+     * modem took AT+CIPSTART, and the connection becomes
+     * CHANNEL_CONNECTED or CHANNEL_FAILED when CONNECT OK or CONNECT FAIL
+     * arrives. Several connections can be set up at once this way.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param   mode        "TCP" or "UDP".
+     * @param   address     Remote server IP address or domain name.
+     * @param   port        Remote server port
+     * @return              OperationResult
+     */
+    unsigned char startOpen(char connection, const char *mode, const char *address, unsigned int port);
+
+    /**
+     * Allocates a free multi-IP connection number.
+     *
+     * @return              0..7, -1 if none is free or not in multi-IP mode.
+     */
+    char allocate();
+
+    /**
+     * Closes a connection, if up, drops what is queued and received on
+     * it, and frees its number.
+     *
+     * @param   connection  The connection number.
+     */
+    void release(char connection);
+
+    /**
+     * State of a connection, as tracked from the responses and the
+     * unsolicited result codes; see status() to ask the modem.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return              ChannelState
+     */
+    unsigned char getChannelState(char connection);
+
+    /**
+     * Last error of a connection, cleared when it is opened or sent on again.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return              ChannelError
+     */
+    unsigned char getChannelError(char connection);
+
+    /**
+     * Queues a send on a connection and returns: poll() sends it, a
+     * frame of at most GPRS_SIM900_MAX_SEND_SIZE bytes at a time, each
+     * connection with something queued getting a frame in turn, so that
+     * a large send does not hold the others back. The buffer must stay
+     * untouched until nothing is queued on the connection anymore.
+     *
+     * A connection still being set up keeps its queue until it is up; a
+     * failed frame drops the rest and sets CHANNEL_SEND_FAILED.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param   buf         The payload.
+     * @param   len         Its length.
+     * @return              false if a send is already queued on it or it
+     *                      is neither connected nor connecting.
+     */
+    bool queueSend(char connection, const unsigned char *buf, unsigned int len);
+
+    /**
+     * Bytes queued on a connection and not sent yet, including the frame
+     * being sent.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @return
+     */
+    unsigned int getQueued(char connection);
+
+    /**
+     * Waits until a connection is no longer being set up and has nothing
+     * queued.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param   timeout     Milliseconds.
+     * @return              OperationResult, OK if it is up without error.
+     */
+    unsigned char waitForChannel(char connection, unsigned long timeout);
+
+    /**
+     * Turns TCP keepalive of the module on or off, for the connections
+     * opened afterwards. Not every firmware has it.
+     *
+     * Example:
+     * > AT+CIPTKA=1,60,30,3
+     * < OK
+     *
+     * @param   idle        Seconds without traffic before the first probe,
+     *                      0 to turn keepalive off.
+     * @param   interval    Seconds between probes.
+     * @param   count       Probes left unanswered before the connection is
+     *                      dropped (and reported CLOSED).
+     * @return              OperationResult, ERROR if the firmware lacks it.
+     */
+    unsigned char useKeepalive(unsigned int idle, unsigned int interval, unsigned char count);
+
+    /**
+     * Whether the module keeps the connections alive with TCP keepalive.
+     *
+     * @return
+     */
+    inline bool isKeepaliveEnabled() {
+        return keepalive;
+    }
+
+    /**
+     * Sets the connection sendPersistent() keeps open instead of opening
+     * and closing one per payload, and turns on TCP keepalive (with
+     * GPRS_SIM900_KEEPALIVE_IDLE, _INTERVAL and _COUNT) when the firmware
+     * has it. Nothing is opened until it is needed.
+     *
+     * The strings are not copied and must outlive the connection.
+     *
+     * @param   connection  If multi-IP connection (+CIPMUX=1)
+     *                      0..7 the connection number, -1 otherwise.
+     * @param   mode        "TCP" or "UDP".
+     * @param   address     The remote address or domain name.
+     * @param   port        The remote port.
+     * @return              OperationResult
+     */
+    unsigned char usePersistentConnection(char connection, const char *mode, const char *address, unsigned int port);
+
+    /**
+     * Opens the persistent connection unless it is up, so that closes by
+     * the peer, the network or keepalive are recovered from lazily.
+     *
+     * @return              OperationResult
+     */
+    unsigned char connect();
+
+    /**
+     * Sends over the persistent connection, opening it first if needed. A
+     * send failing on a connection whose close was not reported yet is done
+     * again, once on a new connection, only if the modem accepted none of
+     * it: once a frame went out, sending it whole again would deliver its
+     * head twice, and the rest alone would reach the peer without it. The
+     * caller then decides, from getAccepted().
+     *
+     * @return              Number of bytes sent, 0 if it failed.
+     */
+    unsigned int sendPersistent(unsigned char *buf, unsigned int len);
+
+    /**
+     * Closes the persistent connection and forgets it.
+     *
+     * @return              OperationResult
+     */
+    unsigned char endPersistentConnection();
+
+    /**
+     * How many times the persistent connection was opened again after it
+     * was lost.
+     *
+     * @return
+     */
+    inline unsigned int getReconnects() {
+        return reconnects;
+    }
+
     /**
      * Close TCP or UDP Connection
      * 
+     * A connection in data mode is escaped first.
+     *
      * Example:
      * > AT+CIPCLOSE=1[,connection]
      * < CLOSE OK
@@ -313,18 +1140,51 @@ public:
     /**
      * Query the IP Address of Given Domain Name
      * 
+     * The answer is cached for GPRS_SIM900_DNS_TTL ms, a failure for
+     * GPRS_SIM900_DNS_NEGATIVE_TTL ms, so the same name is not asked again
+     * in the meantime.
+     *
      * Example:
      * > AT+CDNSGIP="www.google.com"
      * < OK
      * <
      * < +CDNSGIP: 1,"www.google.com","64.233.186.99"
      *
-     * @return  DnsResolution
+     * @return  OperationResult
      * @param   name    Domain name. Should contains less than 256 bytes
      * @param   ip      4-byte-long array where the ip will be placed
      */
     unsigned char resolve(const char *name, unsigned char ip[4]);
+
+    /**
+     * Resolves the names not cached yet at once, all the queries being
+     * sent before the first answer is waited for, so they share one round
+     * trip. At most GPRS_SIM900_DNS_CACHE_SIZE names stay cached.
+     *
+     * @param   names       The names.
+     * @param   count       How many.
+     * @return              How many of them are resolved.
+     */
+    unsigned char prefetch(const char * const *names, unsigned char count);
+
+    /**
+     * Drops every cached name, after the network was changed for instance.
+     */
+    void flushDnsCache();
+
+    /**
+     * Has open() and startOpen() resolve names through the cache and
+     * connect to the address, instead of having the modem resolve them for
+     * every connection.
+     *
+     * @param use
+     */
+    inline void useResolvedAddresses(bool use) {
+        resolvedOpen = use;
+    }
     
+#ifndef GPRS_NO_SERVER
+
     /**
      * Configure Module as Server
      * 
@@ -341,6 +1201,7 @@ public:
      * @return 
      */
     unsigned char configureServer(unsigned char mode, unsigned int port);
+#endif
 
     /**
      * Deactivate GPRS PDP Context
@@ -0,0 +1,270 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * GprsSIM900Automata.h
+ *
+ * Automata of the token tables of GprsSIM900Tokens.h, generated by
+ * "make automata". Do not edit.
+ *
+ * A state is { first edge, edges, fail, token, match }.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_GPRS_SIM900_AUTOMATA_H__
+#define __ARDUINO_DRIVER_GSM_GPRS_SIM900_AUTOMATA_H__ 1
+
+#include "GprsSIM900Tokens.h"
+
+/**
+ * 14 tokens of GPRS_SIM900_STATE_TOKENS, 118 states.
+ */
+static_assert(sizeof(GPRS_SIM900_STATE_TOKENS) / sizeof(ResponseToken) == 14,
+        "GPRS_SIM900_STATE_TOKENS changed, run make automata");
+
+static const ResponseState GPRS_SIM900_STATE_STATES[] PROGMEM = {
+    { 0, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 0 "" */
+    { 1, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 1 "S" */
+    { 2, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 2 "ST" */
+    { 3, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 3 "STA" */
+    { 4, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 4 "STAT" */
+    { 5, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 5 "STATE" */
+    { 6, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 6 "STATE:" */
+    { 7, 6, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 7 "STATE: " */
+    { 13, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 8 "STATE: I" */
+    { 14, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 9 "STATE: IP" */
+    { 15, 4, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 10 "STATE: IP " */
+    { 19, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 11 "STATE: IP I" */
+    { 20, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 12 "STATE: IP IN" */
+    { 21, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 13 "STATE: IP INI" */
+    { 22, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 14 "STATE: IP INIT" */
+    { 23, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 15 "STATE: IP INITI" */
+    { 24, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 16 "STATE: IP INITIA" */
+    { 25, 0, 0, 0, 0 }, /* 17 "STATE: IP INITIAL" */
+    { 25, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 18 "STATE: IP S" */
+    { 26, 1, 2, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 19 "STATE: IP ST" */
+    { 27, 2, 3, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 20 "STATE: IP STA" */
+    { 29, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 21 "STATE: IP STAR" */
+    { 30, 0, 0, 1, 1 }, /* 22 "STATE: IP START" */
+    { 30, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 23 "STATE: IP C" */
+    { 31, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 24 "STATE: IP CO" */
+    { 32, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 25 "STATE: IP CON" */
+    { 33, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 26 "STATE: IP CONF" */
+    { 34, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 27 "STATE: IP CONFI" */
+    { 35, 0, 0, 2, 2 }, /* 28 "STATE: IP CONFIG" */
+    { 35, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 29 "STATE: IP G" */
+    { 36, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 30 "STATE: IP GP" */
+    { 37, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 31 "STATE: IP GPR" */
+    { 38, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 32 "STATE: IP GPRS" */
+    { 39, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 33 "STATE: IP GPRSA" */
+    { 40, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 34 "STATE: IP GPRSAC" */
+    { 41, 0, 0, 3, 3 }, /* 35 "STATE: IP GPRSACT" */
+    { 41, 1, 4, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 36 "STATE: IP STAT" */
+    { 42, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 37 "STATE: IP STATU" */
+    { 43, 0, 1, 4, 4 }, /* 38 "STATE: IP STATUS" */
+    { 43, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 39 "STATE: T" */
+    { 44, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 40 "STATE: TC" */
+    { 45, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 41 "STATE: TCP" */
+    { 46, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 42 "STATE: TCP " */
+    { 47, 2, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 43 "STATE: TCP C" */
+    { 49, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 44 "STATE: TCP CO" */
+    { 50, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 45 "STATE: TCP CON" */
+    { 51, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 46 "STATE: TCP CONN" */
+    { 52, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 47 "STATE: TCP CONNE" */
+    { 53, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 48 "STATE: TCP CONNEC" */
+    { 54, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 49 "STATE: TCP CONNECT" */
+    { 55, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 50 "STATE: TCP CONNECTI" */
+    { 56, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 51 "STATE: TCP CONNECTIN" */
+    { 57, 0, 0, 5, 5 }, /* 52 "STATE: TCP CONNECTING" */
+    { 57, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 53 "STATE: U" */
+    { 58, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 54 "STATE: UD" */
+    { 59, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 55 "STATE: UDP" */
+    { 60, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 56 "STATE: UDP " */
+    { 61, 2, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 57 "STATE: UDP C" */
+    { 63, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 58 "STATE: UDP CO" */
+    { 64, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 59 "STATE: UDP CON" */
+    { 65, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 60 "STATE: UDP CONN" */
+    { 66, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 61 "STATE: UDP CONNE" */
+    { 67, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 62 "STATE: UDP CONNEC" */
+    { 68, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 63 "STATE: UDP CONNECT" */
+    { 69, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 64 "STATE: UDP CONNECTI" */
+    { 70, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 65 "STATE: UDP CONNECTIN" */
+    { 71, 0, 0, 6, 6 }, /* 66 "STATE: UDP CONNECTING" */
+    { 71, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 67 "STATE: S" */
+    { 72, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 68 "STATE: SE" */
+    { 73, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 69 "STATE: SER" */
+    { 74, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 70 "STATE: SERV" */
+    { 75, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 71 "STATE: SERVE" */
+    { 76, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 72 "STATE: SERVER" */
+    { 77, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 73 "STATE: SERVER " */
+    { 78, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 74 "STATE: SERVER L" */
+    { 79, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 75 "STATE: SERVER LI" */
+    { 80, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 76 "STATE: SERVER LIS" */
+    { 81, 1, 2, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 77 "STATE: SERVER LIST" */
+    { 82, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 78 "STATE: SERVER LISTE" */
+    { 83, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 79 "STATE: SERVER LISTEN" */
+    { 84, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 80 "STATE: SERVER LISTENI" */
+    { 85, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 81 "STATE: SERVER LISTENIN" */
+    { 86, 0, 0, 7, 7 }, /* 82 "STATE: SERVER LISTENING" */
+    { 86, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 83 "STATE: C" */
+    { 87, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 84 "STATE: CO" */
+    { 88, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 85 "STATE: CON" */
+    { 89, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 86 "STATE: CONN" */
+    { 90, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 87 "STATE: CONNE" */
+    { 91, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 88 "STATE: CONNEC" */
+    { 92, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 89 "STATE: CONNECT" */
+    { 93, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 90 "STATE: CONNECT " */
+    { 94, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 91 "STATE: CONNECT O" */
+    { 95, 0, 0, 8, 8 }, /* 92 "STATE: CONNECT OK" */
+    { 95, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 93 "STATE: TCP CL" */
+    { 96, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 94 "STATE: TCP CLO" */
+    { 97, 2, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 95 "STATE: TCP CLOS" */
+    { 99, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 96 "STATE: TCP CLOSI" */
+    { 100, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 97 "STATE: TCP CLOSIN" */
+    { 101, 0, 0, 9, 9 }, /* 98 "STATE: TCP CLOSING" */
+    { 101, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 99 "STATE: UDP CL" */
+    { 102, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 100 "STATE: UDP CLO" */
+    { 103, 2, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 101 "STATE: UDP CLOS" */
+    { 105, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 102 "STATE: UDP CLOSI" */
+    { 106, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 103 "STATE: UDP CLOSIN" */
+    { 107, 0, 0, 10, 10 }, /* 104 "STATE: UDP CLOSING" */
+    { 107, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 105 "STATE: TCP CLOSE" */
+    { 108, 0, 0, 11, 11 }, /* 106 "STATE: TCP CLOSED" */
+    { 108, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 107 "STATE: UDP CLOSE" */
+    { 109, 0, 0, 12, 12 }, /* 108 "STATE: UDP CLOSED" */
+    { 109, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 109 "STATE: P" */
+    { 110, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 110 "STATE: PD" */
+    { 111, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 111 "STATE: PDP" */
+    { 112, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 112 "STATE: PDP " */
+    { 113, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 113 "STATE: PDP D" */
+    { 114, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 114 "STATE: PDP DE" */
+    { 115, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 115 "STATE: PDP DEA" */
+    { 116, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 116 "STATE: PDP DEAC" */
+    { 117, 0, 0, 13, 13 } /* 117 "STATE: PDP DEACT" */
+};
+
+static const ResponseEdge GPRS_SIM900_STATE_EDGES[] PROGMEM = {
+    { 'S', 1 },
+    { 'T', 2 },
+    { 'A', 3 },
+    { 'T', 4 },
+    { 'E', 5 },
+    { ':', 6 },
+    { ' ', 7 },
+    { 'C', 83 },
+    { 'I', 8 },
+    { 'P', 109 },
+    { 'S', 67 },
+    { 'T', 39 },
+    { 'U', 53 },
+    { 'P', 9 },
+    { ' ', 10 },
+    { 'C', 23 },
+    { 'G', 29 },
+    { 'I', 11 },
+    { 'S', 18 },
+    { 'N', 12 },
+    { 'I', 13 },
+    { 'T', 14 },
+    { 'I', 15 },
+    { 'A', 16 },
+    { 'L', 17 },
+    { 'T', 19 },
+    { 'A', 20 },
+    { 'R', 21 },
+    { 'T', 36 },
+    { 'T', 22 },
+    { 'O', 24 },
+    { 'N', 25 },
+    { 'F', 26 },
+    { 'I', 27 },
+    { 'G', 28 },
+    { 'P', 30 },
+    { 'R', 31 },
+    { 'S', 32 },
+    { 'A', 33 },
+    { 'C', 34 },
+    { 'T', 35 },
+    { 'U', 37 },
+    { 'S', 38 },
+    { 'C', 40 },
+    { 'P', 41 },
+    { ' ', 42 },
+    { 'C', 43 },
+    { 'L', 93 },
+    { 'O', 44 },
+    { 'N', 45 },
+    { 'N', 46 },
+    { 'E', 47 },
+    { 'C', 48 },
+    { 'T', 49 },
+    { 'I', 50 },
+    { 'N', 51 },
+    { 'G', 52 },
+    { 'D', 54 },
+    { 'P', 55 },
+    { ' ', 56 },
+    { 'C', 57 },
+    { 'L', 99 },
+    { 'O', 58 },
+    { 'N', 59 },
+    { 'N', 60 },
+    { 'E', 61 },
+    { 'C', 62 },
+    { 'T', 63 },
+    { 'I', 64 },
+    { 'N', 65 },
+    { 'G', 66 },
+    { 'E', 68 },
+    { 'R', 69 },
+    { 'V', 70 },
+    { 'E', 71 },
+    { 'R', 72 },
+    { ' ', 73 },
+    { 'L', 74 },
+    { 'I', 75 },
+    { 'S', 76 },
+    { 'T', 77 },
+    { 'E', 78 },
+    { 'N', 79 },
+    { 'I', 80 },
+    { 'N', 81 },
+    { 'G', 82 },
+    { 'O', 84 },
+    { 'N', 85 },
+    { 'N', 86 },
+    { 'E', 87 },
+    { 'C', 88 },
+    { 'T', 89 },
+    { ' ', 90 },
+    { 'O', 91 },
+    { 'K', 92 },
+    { 'O', 94 },
+    { 'S', 95 },
+    { 'E', 105 },
+    { 'I', 96 },
+    { 'N', 97 },
+    { 'G', 98 },
+    { 'O', 100 },
+    { 'S', 101 },
+    { 'E', 107 },
+    { 'I', 102 },
+    { 'N', 103 },
+    { 'G', 104 },
+    { 'D', 106 },
+    { 'D', 108 },
+    { 'D', 110 },
+    { 'P', 111 },
+    { ' ', 112 },
+    { 'D', 113 },
+    { 'E', 114 },
+    { 'A', 115 },
+    { 'C', 116 },
+    { 'T', 117 }
+};
+
+static const ResponseAutomaton GPRS_SIM900_STATE_AUTOMATON PROGMEM = {
+    GPRS_SIM900_STATE_TOKENS, GPRS_SIM900_STATE_STATES, GPRS_SIM900_STATE_EDGES
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_GPRS_SIM900_AUTOMATA_H__ */
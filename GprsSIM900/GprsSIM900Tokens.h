@@ -0,0 +1,55 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * GprsSIM900Tokens.h
+ *
+ * Token tables of the GPRS responses, the sources of GprsSIM900Automata.h.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_GPRS_SIM900_TOKENS_H__
+#define __ARDUINO_DRIVER_GSM_GPRS_SIM900_TOKENS_H__ 1
+
+#include <Arduino.h>
+#include <ResponseMatcher.h>
+#include "GprsSIM900.h"
+
+/**
+ * The states AT+CIPSTATUS reports, with the prefix of their line: the
+ * echoed command (AT+CIPSTATUS) and the connection lines (C: ...,"CLOSED")
+ * must not match.
+ */
+static const char GPRS_SIM900_STATE_INITIAL[] PROGMEM = "STATE: IP INITIAL";
+static const char GPRS_SIM900_STATE_START[] PROGMEM = "STATE: IP START";
+static const char GPRS_SIM900_STATE_CONFIG[] PROGMEM = "STATE: IP CONFIG";
+static const char GPRS_SIM900_STATE_GPRSACT[] PROGMEM = "STATE: IP GPRSACT";
+static const char GPRS_SIM900_STATE_STATUS[] PROGMEM = "STATE: IP STATUS";
+static const char GPRS_SIM900_STATE_TCP_CONNECTING[] PROGMEM = "STATE: TCP CONNECTING";
+static const char GPRS_SIM900_STATE_UDP_CONNECTING[] PROGMEM = "STATE: UDP CONNECTING";
+static const char GPRS_SIM900_STATE_LISTENING[] PROGMEM = "STATE: SERVER LISTENING";
+static const char GPRS_SIM900_STATE_CONNECT_OK[] PROGMEM = "STATE: CONNECT OK";
+static const char GPRS_SIM900_STATE_TCP_CLOSING[] PROGMEM = "STATE: TCP CLOSING";
+static const char GPRS_SIM900_STATE_UDP_CLOSING[] PROGMEM = "STATE: UDP CLOSING";
+static const char GPRS_SIM900_STATE_TCP_CLOSED[] PROGMEM = "STATE: TCP CLOSED";
+static const char GPRS_SIM900_STATE_UDP_CLOSED[] PROGMEM = "STATE: UDP CLOSED";
+static const char GPRS_SIM900_STATE_DEACT[] PROGMEM = "STATE: PDP DEACT";
+
+static const ResponseToken GPRS_SIM900_STATE_TOKENS[] PROGMEM = {
+    { GPRS_SIM900_STATE_INITIAL, GprsSIM900::IP_INITIAL },
+    { GPRS_SIM900_STATE_START, GprsSIM900::IP_START },
+    { GPRS_SIM900_STATE_CONFIG, GprsSIM900::IP_CONFIG },
+    { GPRS_SIM900_STATE_GPRSACT, GprsSIM900::IP_GPRSACT },
+    { GPRS_SIM900_STATE_STATUS, GprsSIM900::IP_STATUS },
+    { GPRS_SIM900_STATE_TCP_CONNECTING, GprsSIM900::CONNECTING_OR_LISTENING },
+    { GPRS_SIM900_STATE_UDP_CONNECTING, GprsSIM900::CONNECTING_OR_LISTENING },
+    { GPRS_SIM900_STATE_LISTENING, GprsSIM900::CONNECTING_OR_LISTENING },
+    { GPRS_SIM900_STATE_CONNECT_OK, GprsSIM900::CONNECT_OK },
+    { GPRS_SIM900_STATE_TCP_CLOSING, GprsSIM900::CLOSING },
+    { GPRS_SIM900_STATE_UDP_CLOSING, GprsSIM900::CLOSING },
+    { GPRS_SIM900_STATE_TCP_CLOSED, GprsSIM900::CLOSED },
+    { GPRS_SIM900_STATE_UDP_CLOSED, GprsSIM900::CLOSED },
+    { GPRS_SIM900_STATE_DEACT, GprsSIM900::PDP_DEACT }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_GPRS_SIM900_TOKENS_H__ */
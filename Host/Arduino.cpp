@@ -0,0 +1,29 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Arduino.cpp
+ *
+ * Minimal Arduino API for building the driver on a Linux host.
+ *
+ * Time functions live in Clock.cpp, so a build can link another clock.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_ARDUINO_CPP__
+#define __ARDUINO_DRIVER_GSM_HOST_ARDUINO_CPP__ 1
+
+#include "Arduino.h"
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+char *itoa(int value, char *str, int radix) {
+    snprintf(str, 8 * sizeof(int) + 2, radix == 16 ? "%x" : "%d", value);
+    return str;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_ARDUINO_CPP__ */
@@ -0,0 +1,68 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Arduino.h
+ *
+ * Minimal Arduino API for building the driver on a Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_ARDUINO_H__
+#define __ARDUINO_DRIVER_GSM_HOST_ARDUINO_H__ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HIGH                                    0x1
+#define LOW                                     0x0
+#define INPUT                                   0x0
+#define OUTPUT                                  0x1
+
+#define DEC                                     10
+#define HEX                                     16
+
+// Flash and RAM are the same thing on the host
+#define PROGMEM
+#define PGM_P                                   const char *
+#define PSTR(s)                                 (s)
+#define pgm_read_byte(p)                        (*(const uint8_t *) (p))
+#define pgm_read_word(p)                        (*(const uint16_t *) (p))
+#define pgm_read_dword(p)                       (*(const uint32_t *) (p))
+#define pgm_read_ptr(p)                         (*(void * const *) (p))
+#define strlen_P                                strlen
+#define strcmp_P                                strcmp
+#define strncmp_P                               strncmp
+#define strstr_P                                strstr
+#define sscanf_P                                sscanf
+#define memcpy_P                                memcpy
+
+// Nothing interrupts the host process
+#define noInterrupts()
+#define interrupts()
+
+class __FlashStringHelper;
+#define F(s)                                    (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+
+typedef uint8_t byte;
+
+unsigned long millis();
+
+unsigned long micros();
+
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+void digitalWrite(uint8_t pin, uint8_t value);
+
+char *itoa(int value, char *str, int radix);
+
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_ARDUINO_H__ */
@@ -0,0 +1,44 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Clock.cpp
+ *
+ * Wall clock time functions for the Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_CLOCK_CPP__
+#define __ARDUINO_DRIVER_GSM_HOST_CLOCK_CPP__ 1
+
+#include "Arduino.h"
+#include <time.h>
+
+static unsigned long long monotonicMicros() {
+    struct timespec now;
+    static unsigned long long start = 0;
+    unsigned long long us;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = (unsigned long long) now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+    if (start == 0) {
+        start = us;
+    }
+    return us - start;
+}
+
+unsigned long millis() {
+    return (unsigned long) (monotonicMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long) monotonicMicros();
+}
+
+void delay(unsigned long ms) {
+    struct timespec duration;
+    duration.tv_sec = ms / 1000;
+    duration.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&duration, NULL);
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_CLOCK_CPP__ */
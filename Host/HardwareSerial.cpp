@@ -0,0 +1,48 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * HardwareSerial.cpp
+ *
+ * The console of the Linux host, seen as the Arduino Serial port.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_CPP__
+#define __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_CPP__ 1
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud) {
+}
+
+void HardwareSerial::end() {
+}
+
+int HardwareSerial::available() {
+    return 0;
+}
+
+int HardwareSerial::read() {
+    return -1;
+}
+
+int HardwareSerial::peek() {
+    return -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+    return fwrite(buf, 1, len, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_CPP__ */
@@ -0,0 +1,41 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * HardwareSerial.h
+ *
+ * The console of the Linux host, seen as the Arduino Serial port.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_H__
+#define __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_H__ 1
+
+#include "Stream.h"
+
+class HardwareSerial: public Stream {
+
+public:
+
+    void begin(unsigned long baud);
+
+    void end();
+
+    virtual int available();
+
+    virtual int read();
+
+    virtual int peek();
+
+    virtual size_t write(uint8_t c);
+
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    virtual void flush();
+
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_HARDWARE_SERIAL_H__ */
@@ -0,0 +1,120 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Print.cpp
+ *
+ * Arduino Print class for the Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_PRINT_CPP__
+#define __ARDUINO_DRIVER_GSM_HOST_PRINT_CPP__ 1
+
+#include "Arduino.h"
+
+size_t Print::write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (len--) {
+        n += write(*buf++);
+    }
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        char digit = n % base;
+        n /= base;
+        *--p = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while (n > 0);
+    return write(p);
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+    return write((const char *) str);
+}
+
+size_t Print::print(const char *str) {
+    return write(str);
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t) c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+    return printNumber(n, base);
+}
+
+size_t Print::print(int n, int base) {
+    return print((long) n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+    return printNumber(n, base);
+}
+
+size_t Print::print(long n, int base) {
+    if (base == 10 && n < 0) {
+        return write('-') + printNumber(-n, 10);
+    }
+    return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *str) {
+    return print(str) + println();
+}
+
+size_t Print::println(const char *str) {
+    return print(str) + println();
+}
+
+size_t Print::println(char c) {
+    return print(c) + println();
+}
+
+size_t Print::println(unsigned char n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(double n, int digits) {
+    return print(n, digits) + println();
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_PRINT_CPP__ */
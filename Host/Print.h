@@ -0,0 +1,66 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Print.h
+ *
+ * Arduino Print class for the Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_PRINT_H__
+#define __ARDUINO_DRIVER_GSM_HOST_PRINT_H__ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class __FlashStringHelper;
+
+class Print {
+
+    size_t printNumber(unsigned long n, uint8_t base);
+
+public:
+
+    virtual ~Print() {
+    }
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    size_t write(const char *str) {
+        return str == NULL ? 0 : write((const uint8_t *) str, strlen(str));
+    }
+
+    size_t write(const char *buf, size_t len) {
+        return write((const uint8_t *) buf, len);
+    }
+
+    virtual void flush() {
+    }
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = 10);
+    size_t print(int n, int base = 10);
+    size_t print(unsigned int n, int base = 10);
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(double n, int digits = 2);
+
+    size_t println();
+    size_t println(const __FlashStringHelper *str);
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(unsigned char n, int base = 10);
+    size_t println(int n, int base = 10);
+    size_t println(unsigned int n, int base = 10);
+    size_t println(long n, int base = 10);
+    size_t println(unsigned long n, int base = 10);
+    size_t println(double n, int digits = 2);
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_PRINT_H__ */
@@ -0,0 +1,27 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Stream.h
+ *
+ * Arduino Stream class for the Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_STREAM_H__
+#define __ARDUINO_DRIVER_GSM_HOST_STREAM_H__ 1
+
+#include "Print.h"
+
+class Stream: public Print {
+
+public:
+
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    virtual int peek() = 0;
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_STREAM_H__ */
@@ -0,0 +1,17 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * WString.h
+ *
+ * Arduino string helpers for the Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HOST_WSTRING_H__
+#define __ARDUINO_DRIVER_GSM_HOST_WSTRING_H__ 1
+
+#include <string.h>
+#include <stdlib.h>
+
+#endif /* __ARDUINO_DRIVER_GSM_HOST_WSTRING_H__ */
@@ -0,0 +1,410 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * HttpClient.cpp
+ *
+ * HTTP/1.1 client over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HTTP_CLIENT_CPP__
+#define __ARDUINO_DRIVER_GSM_HTTP_CLIENT_CPP__ 1
+
+#include "HttpClient.h"
+#include <WString.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+HttpClient::HttpClient(Gprs *gprs, const char *host, unsigned int port, char connection)
+        : gprs(gprs), connection(connection), host(host), port(port), connected(false), keepAlive(true),
+          reusable(false), state(RESPONSE_IDLE), status(0), contentLength(-1), remaining(0), chunked(false),
+          headRequest(false), lineLength(0), headerHandler(NULL), headerContext(NULL), measuring(false), measured(0),
+          writeFailed(false) {
+}
+
+void HttpClient::onHeader(HttpHeaderHandler handler, void *context) {
+    headerHandler = handler;
+    headerContext = context;
+}
+
+unsigned char HttpClient::request(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+        unsigned char count, const unsigned char *body, unsigned int length) {
+    return start(method, path, headers, count, body != NULL ? (long) length : -2L, body);
+}
+
+unsigned char HttpClient::requestChunked(const __FlashStringHelper *method, const char *path,
+        const HttpHeader *headers, unsigned char count, HttpBodyWriter writer, void *context) {
+    unsigned char result = start(method, path, headers, count, -1L, NULL);
+    if (result != OK) {
+        return result;
+    }
+    while (!writeFailed && writer(this, context)) {
+    }
+
+    // The last chunk is empty
+    if (!writeFailed && gprs->beginSend(connection, 5) == Gprs::OK) {
+        emit(F("0\r\n\r\n"));
+        writeFailed = gprs->endSend() != Gprs::OK || writeFailed;
+    } else {
+        writeFailed = true;
+    }
+    if (writeFailed) {
+        disconnect();
+        state = RESPONSE_IDLE;
+        return SEND_FAILED;
+    }
+    return OK;
+}
+
+bool HttpClient::writeChunk(const unsigned char *buf, unsigned int len) {
+    unsigned long size = 4;
+    unsigned int n = len;
+    if (writeFailed) {
+        return false;
+    }
+
+    // An empty chunk would end the body
+    if (len == 0) {
+        return true;
+    }
+    for (; n > 0; n >>= 4) {
+        size++;
+    }
+    if (gprs->beginSend(connection, size + len) != Gprs::OK) {
+        writeFailed = true;
+        return false;
+    }
+    emitNumber(len, 16);
+    emit(F("\r\n"));
+    if (gprs->write(buf, len) != len) {
+        writeFailed = true;
+    }
+    emit(F("\r\n"));
+    if (gprs->endSend() != Gprs::OK) {
+        writeFailed = true;
+    }
+    return !writeFailed;
+}
+
+unsigned char HttpClient::start(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+        unsigned char count, long bodyLength, const unsigned char *body) {
+    unsigned long length;
+    unsigned char attempt;
+    bool reused;
+    finish(HTTP_CLIENT_TIMEOUT);
+    for (attempt = 0; attempt < 2; attempt++) {
+        reused = connected;
+        if (connect() != OK) {
+            return CONNECT_FAILED;
+        }
+        measuring = true;
+        measured = 0;
+        emitHead(method, path, headers, count, bodyLength);
+        measuring = false;
+        length = measured + (body != NULL ? (unsigned long) bodyLength : 0);
+        writeFailed = false;
+        if (gprs->beginSend(connection, length) == Gprs::OK) {
+            emitHead(method, path, headers, count, bodyLength);
+            if (body != NULL && !writeFailed
+                    && gprs->write(body, (unsigned int) bodyLength) != (unsigned int) bodyLength) {
+                writeFailed = true;
+            }
+            writeFailed = gprs->endSend() != Gprs::OK || writeFailed;
+        } else {
+            writeFailed = true;
+        }
+        if (!writeFailed) {
+            state = RESPONSE_STATUS;
+            status = 0;
+            contentLength = -1;
+            chunked = false;
+            headRequest = strcmp_P("HEAD", (const char *) method) == 0;
+            lineLength = 0;
+            reusable = keepAlive;
+            return OK;
+        }
+
+        // Only a kept connection may have been closed by the server meanwhile
+        disconnect();
+        if (!reused) {
+            break;
+        }
+    }
+    return SEND_FAILED;
+}
+
+void HttpClient::emitHead(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+        unsigned char count, long bodyLength) {
+    unsigned char i;
+    emit(method);
+    emit(F(" "));
+    emit(path);
+    emit(F(" HTTP/1.1\r\nHost: "));
+    emit(host);
+    if (port != 80) {
+        emit(F(":"));
+        emitNumber(port, 10);
+    }
+    emit(F("\r\n"));
+    for (i = 0; i < count; i++) {
+        emit(headers[i].name);
+        emit(F(": "));
+        emit(headers[i].value);
+        emit(F("\r\n"));
+    }
+    if (!keepAlive) {
+        emit(F("Connection: close\r\n"));
+    }
+    if (bodyLength >= 0) {
+        emit(F("Content-Length: "));
+        emitNumber((unsigned long) bodyLength, 10);
+        emit(F("\r\n"));
+    } else if (bodyLength == -1) {
+        emit(F("Transfer-Encoding: chunked\r\n"));
+    }
+    emit(F("\r\n"));
+}
+
+void HttpClient::emit(const char *str) {
+    unsigned int len = strlen(str);
+    if (measuring) {
+        measured += len;
+    } else if (!writeFailed && gprs->write((const unsigned char *) str, len) != len) {
+        writeFailed = true;
+    }
+}
+
+void HttpClient::emit(const __FlashStringHelper *str) {
+    unsigned int len = strlen_P((const char *) str);
+    if (measuring) {
+        measured += len;
+    } else if (!writeFailed && gprs->write(str) != len) {
+        writeFailed = true;
+    }
+}
+
+void HttpClient::emitNumber(unsigned long n, unsigned char base) {
+    char digits[11];
+    unsigned char i = sizeof(digits) - 1, digit;
+    digits[i] = '\0';
+    do {
+        digit = (unsigned char) (n % base);
+        digits[--i] = (char) (digit < 10 ? '0' + digit : 'a' + digit - 10);
+        n /= base;
+    } while (n > 0);
+    emit(digits + i);
+}
+
+unsigned char HttpClient::connect() {
+    if (connected) {
+        return OK;
+    }
+    if (gprs->open(connection, "TCP", host, port) != Gprs::OK) {
+        return CONNECT_FAILED;
+    }
+    connected = true;
+    return OK;
+}
+
+void HttpClient::disconnect() {
+    if (connected) {
+        gprs->close(connection);
+        connected = false;
+    }
+}
+
+void HttpClient::close() {
+    disconnect();
+    state = RESPONSE_IDLE;
+}
+
+unsigned char HttpClient::awaitResponse(unsigned long timeout) {
+    unsigned long start = millis();
+    unsigned char c;
+    while (state == RESPONSE_STATUS || state == RESPONSE_HEADERS) {
+        if (gprs->read(connection, &c, 1) > 0) {
+            feed(c);
+        } else if (millis() - start >= timeout) {
+            close();
+            return TIMEOUT;
+        }
+    }
+    if (state == RESPONSE_IDLE) {
+        return ERROR;
+    }
+    return status == 0 ? (unsigned char) BAD_RESPONSE : (unsigned char) OK;
+}
+
+int HttpClient::read(unsigned char *buf, unsigned int len) {
+    unsigned int n = 0, want;
+    unsigned char c;
+    int got;
+    while (n < len && state != RESPONSE_IDLE && state != RESPONSE_DONE) {
+        if (state != RESPONSE_BODY && state != RESPONSE_CHUNK_DATA && state != RESPONSE_UNTIL_CLOSE) {
+            if (gprs->read(connection, &c, 1) <= 0) {
+                break;
+            }
+            feed(c);
+            continue;
+        }
+        want = len - n;
+        if (state != RESPONSE_UNTIL_CLOSE && remaining < want) {
+            want = (unsigned int) remaining;
+        }
+        got = gprs->read(connection, buf + n, want);
+        if (got <= 0) {
+
+            // Once what the connection brought is read, its close ends the body
+            if (state == RESPONSE_UNTIL_CLOSE && gprs->isClosed(connection)) {
+                endResponse();
+            }
+            break;
+        }
+        n += got;
+        if (state == RESPONSE_UNTIL_CLOSE) {
+            continue;
+        }
+        remaining -= got;
+        if (remaining == 0) {
+            if (state == RESPONSE_BODY) {
+                endResponse();
+            } else {
+                state = RESPONSE_CHUNK_END;
+            }
+        }
+    }
+    return (int) n;
+}
+
+unsigned char HttpClient::finish(unsigned long timeout) {
+    unsigned char scratch[16], result;
+    unsigned long start = millis();
+    if (state == RESPONSE_IDLE || state == RESPONSE_DONE) {
+        return OK;
+    }
+    if (state == RESPONSE_STATUS || state == RESPONSE_HEADERS) {
+        result = awaitResponse(timeout);
+        if (result != OK) {
+            return result;
+        }
+    }
+    while (state != RESPONSE_DONE && state != RESPONSE_IDLE) {
+        if (read(scratch, sizeof(scratch)) > 0) {
+            start = millis();
+        } else if (millis() - start >= timeout) {
+            close();
+            return TIMEOUT;
+        }
+    }
+    return OK;
+}
+
+void HttpClient::feed(unsigned char c) {
+
+    // The CRLF after the data of a chunk
+    if (state == RESPONSE_CHUNK_END) {
+        if (c == '\n') {
+            state = RESPONSE_CHUNK_SIZE;
+        }
+        return;
+    }
+    if (c == '\n') {
+        if (lineLength > 0 && line[lineLength - 1] == '\r') {
+            lineLength--;
+        }
+        line[lineLength] = '\0';
+        takeLine();
+        lineLength = 0;
+        return;
+    }
+    if (lineLength < HTTP_CLIENT_LINE_SIZE - 1) {
+        line[lineLength++] = (char) c;
+    }
+}
+
+void HttpClient::takeLine() {
+    char *value;
+    unsigned char i;
+    switch (state) {
+    case RESPONSE_STATUS:
+
+        // HTTP/1.x <status> <reason>
+        if (lineLength < 12 || strncmp_P(line, PSTR("HTTP/1."), 7) != 0) {
+            status = 0;
+            reusable = false;
+            endResponse();
+            return;
+        }
+        if (line[7] == '0') {
+            reusable = false;
+        }
+        status = atoi(line + 9);
+        state = RESPONSE_HEADERS;
+        return;
+    case RESPONSE_HEADERS:
+        if (lineLength > 0) {
+            if (headerHandler != NULL) {
+                headerHandler(this, line, headerContext);
+            }
+            for (i = 0; i < lineLength; i++) {
+                line[i] = (char) tolower(line[i]);
+            }
+            value = strchr(line, ':');
+            if (value == NULL) {
+                return;
+            }
+            for (value++; *value == ' '; value++) {
+            }
+            if (strncmp_P(line, PSTR("content-length:"), 15) == 0) {
+                contentLength = atol(value);
+            } else if (strncmp_P(line, PSTR("transfer-encoding:"), 18) == 0) {
+                chunked = strstr_P(value, PSTR("chunked")) != NULL;
+            } else if (strncmp_P(line, PSTR("connection:"), 11) == 0 && strncmp_P(value, PSTR("close"), 5) == 0) {
+                reusable = false;
+            }
+            return;
+        }
+
+        // 1xx responses, like 100 Continue, are followed by the real one
+        if (status / 100 == 1) {
+            state = RESPONSE_STATUS;
+            return;
+        }
+        if (headRequest || status == 204 || status == 304) {
+            endResponse();
+        } else if (chunked) {
+            state = RESPONSE_CHUNK_SIZE;
+        } else if (contentLength >= 0) {
+            remaining = (unsigned long) contentLength;
+            state = RESPONSE_BODY;
+            if (remaining == 0) {
+                endResponse();
+            }
+        } else {
+            reusable = false;
+            state = RESPONSE_UNTIL_CLOSE;
+        }
+        return;
+    case RESPONSE_CHUNK_SIZE:
+
+        // <hex size>[;extensions]
+        remaining = strtoul(line, NULL, 16);
+        state = remaining > 0 ? RESPONSE_CHUNK_DATA : RESPONSE_TRAILERS;
+        return;
+    case RESPONSE_TRAILERS:
+        if (lineLength == 0) {
+            endResponse();
+        }
+        return;
+    }
+}
+
+void HttpClient::endResponse() {
+    state = RESPONSE_DONE;
+    if (!reusable) {
+        disconnect();
+    }
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_HTTP_CLIENT_CPP__ */
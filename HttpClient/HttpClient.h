@@ -0,0 +1,313 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * HttpClient.h
+ *
+ * HTTP/1.1 client over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_HTTP_CLIENT_H__
+#define __ARDUINO_DRIVER_GSM_HTTP_CLIENT_H__ 1
+
+#include <Arduino.h>
+#include <Gprs.h>
+
+#ifndef HTTP_CLIENT_LINE_SIZE
+#define HTTP_CLIENT_LINE_SIZE           32
+#endif
+
+#define HTTP_CLIENT_TIMEOUT             10000UL
+
+/**
+ * A request header. Both strings stay in the caller's memory.
+ */
+struct HttpHeader {
+    const char *name;
+    const char *value;
+};
+
+class HttpClient;
+
+/**
+ * Produces the body of a chunked request, a writeChunk() at a time.
+ *
+ * @return              true while there is more to write.
+ */
+typedef bool (*HttpBodyWriter)(HttpClient *client, void *context);
+
+/**
+ * Receives each response header line, cut to HTTP_CLIENT_LINE_SIZE - 1
+ * characters.
+ */
+typedef void (*HttpHeaderHandler)(HttpClient *client, const char *line, void *context);
+
+/**
+ * Requests are written straight into the send frames of the connection,
+ * piece by piece, and responses are parsed as they are read: neither is
+ * ever held as a whole, only one line of the response is.
+ *
+ * The connection is kept from one request to the next, unless the server
+ * or useKeepAlive(false) says otherwise. A request failing on a kept
+ * connection, closed by the server meanwhile, is sent again on a new one.
+ */
+class HttpClient {
+
+    Gprs *gprs;
+    char connection;
+    const char *host;
+    unsigned int port;
+
+    /**
+     * Whether the connection is believed open, whether the next requests
+     * ask to keep it, and whether the current response allows to.
+     */
+    bool connected;
+    bool keepAlive;
+    bool reusable;
+
+    /**
+     * Parsing of the response: one of ResponseState, the status, the
+     * announced length (-1 if none), what is left of the body or of the
+     * current chunk, whether the body is chunked, and whether the request
+     * was a HEAD, whose response has no body whatever its headers say.
+     */
+    unsigned char state;
+    int status;
+    long contentLength;
+    unsigned long remaining;
+    bool chunked;
+    bool headRequest;
+
+    /**
+     * The line being read.
+     */
+    char line[HTTP_CLIENT_LINE_SIZE];
+    unsigned char lineLength;
+
+    HttpHeaderHandler headerHandler;
+    void *headerContext;
+
+    /**
+     * Head writing: whether it is only measured, its length so far, and
+     * whether a piece could not be sent. Also set by a failed chunk.
+     */
+    bool measuring;
+    unsigned long measured;
+    bool writeFailed;
+
+    /**
+     * Opens the connection unless it is believed open.
+     *
+     * @return              Result
+     */
+    unsigned char connect();
+
+    /**
+     * Closes the connection if it is believed open.
+     */
+    void disconnect();
+
+    /**
+     * Measures or writes the head of a request.
+     *
+     * @param   bodyLength  The Content-Length, -1 for a chunked body, -2
+     *                      for none.
+     */
+    void emitHead(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+            unsigned char count, long bodyLength);
+    void emit(const char *str);
+    void emit(const __FlashStringHelper *str);
+    void emitNumber(unsigned long n, unsigned char base);
+
+    /**
+     * Sends a request head, and a body if any, in one payload, on a new
+     * connection if the kept one turns out to be closed.
+     *
+     * @return              Result
+     */
+    unsigned char start(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+            unsigned char count, long bodyLength, const unsigned char *body);
+
+    /**
+     * Parses a byte of the response outside of the body.
+     */
+    void feed(unsigned char c);
+
+    /**
+     * Parses a complete status, header or chunk line.
+     */
+    void takeLine();
+
+    /**
+     * Ends the response, closing the connection unless it can be kept.
+     */
+    void endResponse();
+
+public:
+
+    enum Result {
+        OK = 0,
+        ERROR = 1,
+        CONNECT_FAILED = 2,
+        SEND_FAILED = 3,
+        TIMEOUT = 4,
+
+        // Not an HTTP/1.x response
+        BAD_RESPONSE = 5
+    };
+
+    enum ResponseState {
+
+        // No request sent
+        RESPONSE_IDLE = 0,
+        RESPONSE_STATUS = 1,
+        RESPONSE_HEADERS = 2,
+
+        // Content-Length bytes
+        RESPONSE_BODY = 3,
+        RESPONSE_CHUNK_SIZE = 4,
+        RESPONSE_CHUNK_DATA = 5,
+        RESPONSE_CHUNK_END = 6,
+        RESPONSE_TRAILERS = 7,
+
+        // Neither length nor chunks: the body ends with the connection
+        RESPONSE_UNTIL_CLOSE = 8,
+        RESPONSE_DONE = 9
+    };
+
+    /**
+     * Public constructor.
+     *
+     * @param gprs          The GPRS connection, brought up.
+     * @param host          The server name, also sent as Host. It is not
+     *                      copied.
+     * @param port          The server port.
+     * @param connection    The connection, -1 in single connection mode.
+     */
+    HttpClient(Gprs *gprs, const char *host, unsigned int port, char connection);
+
+    /**
+     * Asks the server to keep the connection for the next request
+     * (HTTP/1.1 default), or to close it after the response.
+     *
+     * @param use
+     */
+    inline void useKeepAlive(bool use) {
+        keepAlive = use;
+    }
+
+    /**
+     * Sets the handler the response header lines are given to.
+     */
+    void onHeader(HttpHeaderHandler handler, void *context);
+
+    /**
+     * Sends a request, with a body of known length or none, and returns
+     * once it is sent. What is left of the previous response is skipped.
+     *
+     * Example:
+     * > POST /log HTTP/1.1
+     * > Host: example.com
+     * > Content-Length: 5
+     * >
+     * > hello
+     *
+     * @param   method      F("GET"), F("POST")...
+     * @param   path        The path and query.
+     * @param   headers     Headers sent after Host, NULL if none.
+     * @param   count       How many.
+     * @param   body        The body, NULL if none.
+     * @param   length      Its length.
+     * @return              Result
+     */
+    unsigned char request(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+            unsigned char count, const unsigned char *body, unsigned int length);
+
+    /**
+     * Sends a GET request.
+     *
+     * @return              Result
+     */
+    inline unsigned char get(const char *path) {
+        return request(F("GET"), path, NULL, 0, NULL, 0);
+    }
+
+    /**
+     * Sends a request whose body, of unknown length, is written by the
+     * writer with writeChunk() (Transfer-Encoding: chunked). The writer is
+     * called until it returns false.
+     *
+     * @return              Result
+     */
+    unsigned char requestChunked(const __FlashStringHelper *method, const char *path, const HttpHeader *headers,
+            unsigned char count, HttpBodyWriter writer, void *context);
+
+    /**
+     * Sends a chunk of the body, from a HttpBodyWriter.
+     *
+     * @return              false if it could not be sent.
+     */
+    bool writeChunk(const unsigned char *buf, unsigned int len);
+
+    /**
+     * Waits for the status line and the headers of the response.
+     *
+     * @param   timeout     Milliseconds.
+     * @return              Result
+     */
+    unsigned char awaitResponse(unsigned long timeout);
+
+    /**
+     * The status of the response, 0 before it is known.
+     *
+     * @return
+     */
+    inline int getStatus() {
+        return status;
+    }
+
+    /**
+     * The Content-Length of the response, -1 if it has none.
+     *
+     * @return
+     */
+    inline long getContentLength() {
+        return contentLength;
+    }
+
+    /**
+     * Whether the whole body was read.
+     *
+     * @return
+     */
+    inline bool isComplete() {
+        return state == RESPONSE_DONE;
+    }
+
+    /**
+     * Reads the body received so far, without the chunk framing and
+     * without waiting for more.
+     *
+     * @return              Number of bytes read.
+     */
+    int read(unsigned char *buf, unsigned int len);
+
+    /**
+     * Reads and drops the rest of the response. A body without length or
+     * chunks only ends when the server closes the connection; silence
+     * before that is a TIMEOUT, the body may be cut.
+     *
+     * @param   timeout     Milliseconds without anything received.
+     * @return              Result
+     */
+    unsigned char finish(unsigned long timeout);
+
+    /**
+     * Closes the connection.
+     */
+    void close();
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_HTTP_CLIENT_H__ */
@@ -0,0 +1,47 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * Lzss.h
+ *
+ * Stream format shared by LzssEncoder and LzssDecoder.
+ *
+ * The stream is a sequence of codes, most significant bit first:
+ *
+ * <ul>
+ *  <li>1, then 8 bits: a literal byte</li>
+ *  <li>0, then 8 bits of distance d (1 to 255) and 4 bits of length l: the
+ *  l + LZSS_MIN_MATCH bytes found d bytes back</li>
+ *  <li>0, then a distance of 0: a flush, the rest of the byte is padding</li>
+ * </ul>
+ *
+ * The window goes on across flushes, so a record flushed alone still
+ * refers to the ones before.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LZSS_H__
+#define __ARDUINO_DRIVER_GSM_LZSS_H__ 1
+
+#define LZSS_WINDOW_BITS                8
+#define LZSS_LENGTH_BITS                4
+
+/**
+ * Farthest distance a match refers to, and its bounds in length. A match
+ * of 2 bytes takes 13 bits instead of 18 as literals.
+ */
+#define LZSS_WINDOW_SIZE                ((1 << LZSS_WINDOW_BITS) - 1)
+#define LZSS_MIN_MATCH                  2
+#define LZSS_MAX_MATCH                  ((1 << LZSS_LENGTH_BITS) - 1 + LZSS_MIN_MATCH)
+
+/**
+ * Receives the bytes coming out of the encoder or the decoder.
+ *
+ * @param buf           The bytes.
+ * @param len           How many.
+ * @param context       The opaque pointer given with the sink.
+ * @return              false to fail the write which produced them.
+ */
+typedef bool (*LzssSink)(const unsigned char *buf, unsigned int len, void *context);
+
+#endif /* __ARDUINO_DRIVER_GSM_LZSS_H__ */
@@ -0,0 +1,104 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LzssDecoder.cpp
+ *
+ * Streaming LZSS decompressor, the counterpart of LzssEncoder.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LZSS_DECODER_CPP__
+#define __ARDUINO_DRIVER_GSM_LZSS_DECODER_CPP__ 1
+
+#include "LzssDecoder.h"
+
+LzssDecoder::LzssDecoder(LzssSink sink, void *context)
+        : sink(sink), context(context) {
+    reset();
+}
+
+void LzssDecoder::reset() {
+    memset(window, 0, sizeof(window));
+    head = 0;
+    state = DECODE_TAG;
+    value = 0;
+    count = 0;
+    distance = 0;
+    outputLength = 0;
+    failed = false;
+    total = 0;
+}
+
+bool LzssDecoder::write(const unsigned char *buf, unsigned int len) {
+    unsigned int i;
+    unsigned char bit;
+    for (i = 0; i < len && !failed; i++) {
+        for (bit = 8; bit-- > 0;) {
+            if (feed((buf[i] >> bit) & 1)) {
+                break;
+            }
+        }
+    }
+    emit();
+    return !failed;
+}
+
+bool LzssDecoder::feed(unsigned char bit) {
+    unsigned char n;
+    value = (value << 1) | bit;
+    count++;
+    switch (state) {
+    case DECODE_TAG:
+        state = bit ? DECODE_LITERAL : DECODE_DISTANCE;
+        break;
+    case DECODE_LITERAL:
+        if (count < 8) {
+            return false;
+        }
+        put((unsigned char) value);
+        state = DECODE_TAG;
+        break;
+    case DECODE_DISTANCE:
+        if (count < LZSS_WINDOW_BITS) {
+            return false;
+        }
+        distance = (unsigned char) value;
+        state = distance == 0 ? DECODE_TAG : DECODE_LENGTH;
+        value = 0;
+        count = 0;
+        return distance == 0;
+    case DECODE_LENGTH:
+        if (count < LZSS_LENGTH_BITS) {
+            return false;
+        }
+
+        // The match may run over the bytes it produces, so it is copied a byte at a time
+        for (n = (unsigned char) (value + LZSS_MIN_MATCH); n > 0; n--) {
+            put(window[(unsigned char) (head - distance)]);
+        }
+        state = DECODE_TAG;
+        break;
+    }
+    value = 0;
+    count = 0;
+    return false;
+}
+
+void LzssDecoder::put(unsigned char c) {
+    window[head++] = c;
+    output[outputLength++] = c;
+    total++;
+    if (outputLength == LZSS_DECODER_OUTPUT_SIZE) {
+        emit();
+    }
+}
+
+void LzssDecoder::emit() {
+    if (outputLength > 0 && !failed) {
+        failed = !sink(output, outputLength, context);
+    }
+    outputLength = 0;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_LZSS_DECODER_CPP__ */
@@ -0,0 +1,109 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LzssDecoder.h
+ *
+ * Streaming LZSS decompressor, the counterpart of LzssEncoder.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LZSS_DECODER_H__
+#define __ARDUINO_DRIVER_GSM_LZSS_DECODER_H__ 1
+
+#include <Arduino.h>
+#include "Lzss.h"
+
+/**
+ * The decoded bytes gathered before they go to the sink.
+ */
+#ifndef LZSS_DECODER_OUTPUT_SIZE
+#define LZSS_DECODER_OUTPUT_SIZE        32
+#endif
+
+/**
+ * Decompresses a stream as it comes, in pieces cut anywhere, on the
+ * server side as well as on the MCU: a window of 256 bytes and the output
+ * buffer, no heap.
+ */
+class LzssDecoder {
+
+    enum DecodeState {
+        DECODE_TAG = 0,
+        DECODE_LITERAL = 1,
+        DECODE_DISTANCE = 2,
+        DECODE_LENGTH = 3
+    };
+
+    LzssSink sink;
+    void *context;
+
+    /**
+     * The last bytes decoded, head wrapping with its type.
+     */
+    unsigned char window[1 << LZSS_WINDOW_BITS];
+    unsigned char head;
+
+    /**
+     * The field being read: its bits so far and how many, and the
+     * distance of the match whose length comes next.
+     */
+    unsigned char state;
+    unsigned int value;
+    unsigned char count;
+    unsigned char distance;
+
+    unsigned char output[LZSS_DECODER_OUTPUT_SIZE];
+    unsigned char outputLength;
+    bool failed;
+
+    unsigned long total;
+
+    /**
+     * Reads a bit of the stream.
+     *
+     * @return              true after a flush, the rest of the byte being
+     *                      padding.
+     */
+    bool feed(unsigned char bit);
+
+    void put(unsigned char c);
+
+    void emit();
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param sink          Where the decoded bytes go.
+     * @param context       Given back to the sink.
+     */
+    LzssDecoder(LzssSink sink, void *context);
+
+    /**
+     * Starts a new stream.
+     */
+    void reset();
+
+    /**
+     * Decompresses bytes of the stream, handing what they give to the
+     * sink before returning.
+     *
+     * @param buf
+     * @param len
+     * @return              false if the sink failed, since the last reset.
+     */
+    bool write(const unsigned char *buf, unsigned int len);
+
+    /**
+     * Bytes decoded since the last reset.
+     *
+     * @return
+     */
+    inline unsigned long getTotal() {
+        return total;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_LZSS_DECODER_H__ */
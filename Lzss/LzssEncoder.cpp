@@ -0,0 +1,143 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LzssEncoder.cpp
+ *
+ * Streaming LZSS compressor with a 255-byte window.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LZSS_ENCODER_CPP__
+#define __ARDUINO_DRIVER_GSM_LZSS_ENCODER_CPP__ 1
+
+#include "LzssEncoder.h"
+
+LzssEncoder::LzssEncoder(LzssSink sink, void *context)
+        : sink(sink), context(context) {
+    reset();
+}
+
+void LzssEncoder::reset() {
+    position = 0;
+    filled = 0;
+    bits = 0;
+    bitCount = 0;
+    outputLength = 0;
+    pending = false;
+    failed = false;
+    totalIn = 0;
+    totalOut = 0;
+}
+
+bool LzssEncoder::write(const unsigned char *buf, unsigned int len) {
+    unsigned int n;
+    while (len > 0 && !failed) {
+        if (filled == LZSS_ENCODER_BUFFER_SIZE) {
+            slide();
+        }
+        n = LZSS_ENCODER_BUFFER_SIZE - filled;
+        if (len < n) {
+            n = len;
+        }
+        memcpy(buffer + filled, buf, n);
+        filled += n;
+        buf += n;
+        len -= n;
+        totalIn += n;
+        pending = true;
+
+        // Only with a whole lookahead is the longest match found
+        while (filled - position >= LZSS_MAX_MATCH) {
+            encodeNext();
+        }
+    }
+    return !failed;
+}
+
+bool LzssEncoder::flush() {
+    unsigned char padding;
+    if (!pending) {
+        return !failed;
+    }
+    while (position < filled) {
+        encodeNext();
+    }
+
+    // A distance of 0 marks the flush, the decoder skips to the next byte
+    putBits(0, 1 + LZSS_WINDOW_BITS);
+    if (bitCount > 0) {
+        padding = 8 - bitCount;
+        putBits(0, padding);
+    }
+    emit();
+    pending = false;
+    return !failed;
+}
+
+void LzssEncoder::encodeNext() {
+    const unsigned char *p = buffer + position, *q;
+    unsigned int available = filled - position, start, candidate, length, bestLength = 0, bestDistance = 0;
+    if (available > LZSS_MAX_MATCH) {
+        available = LZSS_MAX_MATCH;
+    }
+    start = position > LZSS_WINDOW_SIZE ? position - LZSS_WINDOW_SIZE : 0;
+
+    // The nearest candidates first, the byte after the best match so far ruling most out at once
+    for (candidate = position; candidate-- > start;) {
+        q = buffer + candidate;
+        if (q[bestLength] != p[bestLength] || q[0] != p[0]) {
+            continue;
+        }
+        for (length = 0; length < available && q[length] == p[length]; length++) {
+        }
+        if (length > bestLength) {
+            bestLength = length;
+            bestDistance = position - candidate;
+            if (length == available) {
+                break;
+            }
+        }
+    }
+    if (bestLength >= LZSS_MIN_MATCH) {
+        putBits(0, 1);
+        putBits(bestDistance, LZSS_WINDOW_BITS);
+        putBits(bestLength - LZSS_MIN_MATCH, LZSS_LENGTH_BITS);
+        position += bestLength;
+    } else {
+        putBits(0x100 | *p, 1 + 8);
+        position++;
+    }
+}
+
+void LzssEncoder::slide() {
+    unsigned int drop = position > LZSS_WINDOW_SIZE ? position - LZSS_WINDOW_SIZE : 0;
+    memmove(buffer, buffer + drop, filled - drop);
+    position -= drop;
+    filled -= drop;
+}
+
+void LzssEncoder::putBits(unsigned int value, unsigned char count) {
+    while (count-- > 0) {
+        bits = (unsigned char) ((bits << 1) | ((value >> count) & 1));
+        if (++bitCount < 8) {
+            continue;
+        }
+        output[outputLength++] = bits;
+        totalOut++;
+        bits = 0;
+        bitCount = 0;
+        if (outputLength == LZSS_ENCODER_OUTPUT_SIZE) {
+            emit();
+        }
+    }
+}
+
+void LzssEncoder::emit() {
+    if (outputLength > 0 && !failed) {
+        failed = !sink(output, outputLength, context);
+    }
+    outputLength = 0;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_LZSS_ENCODER_CPP__ */
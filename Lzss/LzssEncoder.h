@@ -0,0 +1,145 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LzssEncoder.h
+ *
+ * Streaming LZSS compressor with a 255-byte window.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LZSS_ENCODER_H__
+#define __ARDUINO_DRIVER_GSM_LZSS_ENCODER_H__ 1
+
+#include <Arduino.h>
+#include "Lzss.h"
+
+/**
+ * The window and the bytes waiting to be encoded, at least
+ * LZSS_WINDOW_SIZE + 2 * LZSS_MAX_MATCH. More costs RAM and saves moves.
+ */
+#ifndef LZSS_ENCODER_BUFFER_SIZE
+#define LZSS_ENCODER_BUFFER_SIZE        320
+#endif
+
+/**
+ * The encoded bytes gathered before they go to the sink.
+ */
+#ifndef LZSS_ENCODER_OUTPUT_SIZE
+#define LZSS_ENCODER_OUTPUT_SIZE        32
+#endif
+
+/**
+ * Compresses a stream, a write at a time, to a sink, without the heap:
+ * about LZSS_ENCODER_BUFFER_SIZE + LZSS_ENCODER_OUTPUT_SIZE bytes in all.
+ *
+ * The last LZSS_MAX_MATCH bytes written wait for the ones after them, so
+ * their match is the longest; flush() encodes them, at the cost of two
+ * bytes at most, when a message has to go out whole.
+ */
+class LzssEncoder {
+
+    LzssSink sink;
+    void *context;
+
+    /**
+     * The window, up to position, then the bytes not encoded yet, up to
+     * filled.
+     */
+    unsigned char buffer[LZSS_ENCODER_BUFFER_SIZE];
+    unsigned int position;
+    unsigned int filled;
+
+    /**
+     * The bits of the byte being encoded, and how many.
+     */
+    unsigned char bits;
+    unsigned char bitCount;
+
+    unsigned char output[LZSS_ENCODER_OUTPUT_SIZE];
+    unsigned char outputLength;
+
+    /**
+     * Whether something was written since the last flush, and whether the
+     * sink failed.
+     */
+    bool pending;
+    bool failed;
+
+    unsigned long totalIn;
+    unsigned long totalOut;
+
+    /**
+     * Encodes the byte at position, or the longest match of it in the
+     * window.
+     */
+    void encodeNext();
+
+    /**
+     * Drops the bytes beyond the window, to make room.
+     */
+    void slide();
+
+    /**
+     * Appends the count low bits of value to the stream.
+     */
+    void putBits(unsigned int value, unsigned char count);
+
+    /**
+     * Hands the encoded bytes to the sink.
+     */
+    void emit();
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param sink          Where the encoded bytes go.
+     * @param context       Given back to the sink.
+     */
+    LzssEncoder(LzssSink sink, void *context);
+
+    /**
+     * Starts a new stream, for a new connection for instance; so must the
+     * decoder.
+     */
+    void reset();
+
+    /**
+     * Compresses bytes.
+     *
+     * @param buf
+     * @param len
+     * @return              false if the sink failed, since the last reset.
+     */
+    bool write(const unsigned char *buf, unsigned int len);
+
+    /**
+     * Encodes what is waiting and hands it to the sink, so the decoder
+     * gets everything written so far.
+     *
+     * @return              false if the sink failed, since the last reset.
+     */
+    bool flush();
+
+    /**
+     * Bytes written since the last reset.
+     *
+     * @return
+     */
+    inline unsigned long getTotalIn() {
+        return totalIn;
+    }
+
+    /**
+     * Bytes encoded since the last reset.
+     *
+     * @return
+     */
+    inline unsigned long getTotalOut() {
+        return totalOut;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_LZSS_ENCODER_H__ */
@@ -0,0 +1,171 @@
+/**
+ * Compresses the record formats the sketches send, the way they send them,
+ * and reports the ratio and the throughput of LzssEncoder and LzssDecoder.
+ * The stream decoded is checked against what was written.
+ *
+ * On a board, the figures come out on Serial at 115200 bps. On the Linux
+ * host:
+ *
+ * $ make compression
+ */
+
+#include <Arduino.h>
+#include <LzssEncoder.h>
+#include <LzssDecoder.h>
+
+#define COMPRESSION_RECORDS             200
+#define COMPRESSION_BATCH               16
+#define COMPRESSION_FORMATS             3
+
+// The host runs the corpus over and over, for its clock to tell something
+#ifdef ARDUINO
+#define COMPRESSION_ROUNDS              1
+#else
+#define COMPRESSION_ROUNDS              200
+#endif
+
+/**
+ * The decoder the encoder feeds, the hashes of what went in and of what
+ * came out, and the time spent decoding.
+ */
+struct CompressionRun {
+    LzssDecoder *decoder;
+    unsigned long inHash;
+    unsigned long outHash;
+    unsigned long decodeMicros;
+};
+
+static const char formatCsv[] PROGMEM = "csv";
+static const char formatKeyValue[] PROGMEM = "key=value";
+static const char formatJson[] PROGMEM = "json";
+static const char * const formatNames[COMPRESSION_FORMATS] PROGMEM = { formatCsv, formatKeyValue, formatJson };
+
+/**
+ * FNV-1a.
+ */
+static unsigned long hashBytes(unsigned long hash, const unsigned char *buf, unsigned int len) {
+    unsigned int i;
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ buf[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool toDecoder(const unsigned char *buf, unsigned int len, void *context) {
+    CompressionRun *run = (CompressionRun *) context;
+    unsigned long start = micros();
+    bool written = run->decoder->write(buf, len);
+    run->decodeMicros += micros() - start;
+    return written;
+}
+
+static bool checkDecoded(const unsigned char *buf, unsigned int len, void *context) {
+    CompressionRun *run = (CompressionRun *) context;
+    run->outHash = hashBytes(run->outHash, buf, len);
+    return true;
+}
+
+/**
+ * Formats the n-th record of a sensor whose readings drift slowly: a CSV
+ * line as logged, a key=value line as queued, a JSON object as published.
+ */
+static int formatRecord(char *record, unsigned char format, unsigned int n) {
+    unsigned long timestamp = 1700000000UL + n * 30UL;
+    int temperature = 215 + (int) ((n * 7) % 23), humidity = 40 + (int) ((n * 3) % 9);
+    int voltage = 371 - (int) (n / 40);
+    switch (format) {
+    case 0:
+        return snprintf(record, 80, "%lu,%d.%d,%d,%d.%02d\n", timestamp, temperature / 10, temperature % 10,
+                humidity, voltage / 100, voltage % 100);
+    case 1:
+        return snprintf(record, 80, "t=%d.%d,h=%d,v=%d.%02d,%04u\n", temperature / 10, temperature % 10, humidity,
+                voltage / 100, voltage % 100, n);
+    default:
+        return snprintf(record, 80, "{\"id\":\"node-7\",\"ts\":%lu,\"t\":%d.%d,\"h\":%d,\"v\":%d.%02d}", timestamp,
+                temperature / 10, temperature % 10, humidity, voltage / 100, voltage % 100);
+    }
+}
+
+/**
+ * Compresses the records of a format, flushing after every batch of them,
+ * and prints the figures.
+ */
+static bool measure(unsigned char format, unsigned int batch) {
+    char record[80];
+    unsigned int n, round;
+    unsigned long start, encodeMicros = 0, in = 0, out = 0;
+    int len;
+    CompressionRun run;
+    LzssDecoder decoder(checkDecoded, &run);
+    LzssEncoder encoder(toDecoder, &run);
+    run.decoder = &decoder;
+    run.decodeMicros = 0;
+    for (round = 0; round < COMPRESSION_ROUNDS; round++) {
+        run.inHash = 2166136261UL;
+        run.outHash = 2166136261UL;
+        encoder.reset();
+        decoder.reset();
+        for (n = 0; n < COMPRESSION_RECORDS; n++) {
+            len = formatRecord(record, format, n);
+            run.inHash = hashBytes(run.inHash, (const unsigned char *) record, len);
+            start = micros();
+            encoder.write((const unsigned char *) record, len);
+            if ((n + 1) % batch == 0) {
+                encoder.flush();
+            }
+            encodeMicros += micros() - start;
+        }
+        start = micros();
+        if (!encoder.flush()) {
+            return false;
+        }
+        encodeMicros += micros() - start;
+        if (run.outHash != run.inHash || decoder.getTotal() != encoder.getTotalIn()) {
+            return false;
+        }
+        in += encoder.getTotalIn();
+        out += encoder.getTotalOut();
+    }
+
+    // The decoder runs within the encoder, through its sink
+    encodeMicros -= run.decodeMicros;
+    Serial.print((const __FlashStringHelper *) pgm_read_ptr(&formatNames[format]));
+    Serial.print(batch == 1 ? F(", a flush each: ") : F(", a flush per 16: "));
+    Serial.print(in / COMPRESSION_ROUNDS);
+    Serial.print(F(" B -> "));
+    Serial.print(out / COMPRESSION_ROUNDS);
+    Serial.print(F(" B, ratio "));
+    Serial.print((double) in / out);
+    Serial.print(F(", encode "));
+    Serial.print((unsigned long) (in * 1000000.0 / (encodeMicros > 0 ? encodeMicros : 1)));
+    Serial.print(F(" B/s, decode "));
+    Serial.print((unsigned long) (in * 1000000.0 / (run.decodeMicros > 0 ? run.decodeMicros : 1)));
+    Serial.println(F(" B/s"));
+    return true;
+}
+
+void setup() {
+    unsigned char format;
+    Serial.begin(115200);
+    Serial.print(F("lzss: encoder "));
+    Serial.print((unsigned int) sizeof(LzssEncoder));
+    Serial.print(F(" B, decoder "));
+    Serial.print((unsigned int) sizeof(LzssDecoder));
+    Serial.println(F(" B"));
+    for (format = 0; format < COMPRESSION_FORMATS; format++) {
+        if (!measure(format, 1) || !measure(format, COMPRESSION_BATCH)) {
+            Serial.println(F("decoded stream differs"));
+        }
+    }
+    Serial.flush();
+}
+
+void loop() {
+}
+
+#ifndef ARDUINO
+int main() {
+    setup();
+    return 0;
+}
+#endif
@@ -0,0 +1,39 @@
+/**
+ * Compresses or decompresses a stream on a Linux host, the server side of
+ * the payloads LzssEncoder sends.
+ *
+ * $ make host
+ * $ build/host/lzss < records.csv > records.lzss
+ * $ build/host/lzss -d < records.lzss
+ */
+
+#include <Arduino.h>
+#include <LzssEncoder.h>
+#include <LzssDecoder.h>
+
+static bool writeOut(const unsigned char *buf, unsigned int len, void *context) {
+    return fwrite(buf, 1, len, stdout) == len;
+}
+
+int main(int argc, char **argv) {
+    unsigned char buf[256];
+    size_t n;
+    bool decompress = argc > 1 && strcmp(argv[1], "-d") == 0, ok = true;
+    LzssEncoder encoder(writeOut, NULL);
+    LzssDecoder decoder(writeOut, NULL);
+    if (argc > 2 || (argc == 2 && !decompress)) {
+        fprintf(stderr, "Usage: %s [-d] < input > output\n", argv[0]);
+        return 2;
+    }
+    while (ok && (n = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+        ok = decompress ? decoder.write(buf, (unsigned int) n) : encoder.write(buf, (unsigned int) n);
+    }
+    if (ok && !decompress) {
+        ok = encoder.flush();
+    }
+    if (!ok || ferror(stdin) || fflush(stdout) != 0) {
+        fprintf(stderr, "%s: cannot write the output\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
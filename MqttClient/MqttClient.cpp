@@ -0,0 +1,550 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * MqttClient.cpp
+ *
+ * MQTT 3.1.1 client over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_MQTT_CLIENT_CPP__
+#define __ARDUINO_DRIVER_GSM_MQTT_CLIENT_CPP__ 1
+
+#include "MqttClient.h"
+#include <WString.h>
+
+// Protocol name and level of MQTT 3.1.1
+static const unsigned char MQTT_CLIENT_PROTOCOL[] PROGMEM = { 0, 4, 'M', 'Q', 'T', 'T', 4 };
+
+MqttClient::MqttClient(Gprs *gprs, char connection)
+        : gprs(gprs), connection(connection), connected(false), returnCode(0), keepAlive(0), lastSentAt(0),
+          pinging(false), pingSentAt(0), queued(0), acking(false), frames(0), nextPacketId(1), header(0), remaining(0),
+          decoding(0), shift(0), receivedLength(0), receiveState(RECEIVE_HEADER), messageLength(0), lastAck(0),
+          lastAckId(0), lastAckCode(0), messageHandler(NULL), messageContext(NULL), publishedHandler(NULL),
+          publishedContext(NULL) {
+    memset(inFlight, 0, sizeof(inFlight));
+}
+
+void MqttClient::onMessage(MqttMessageHandler handler, void *context) {
+    messageHandler = handler;
+    messageContext = context;
+}
+
+void MqttClient::onPublished(MqttPublishedHandler handler, void *context) {
+    publishedHandler = handler;
+    publishedContext = context;
+}
+
+unsigned char MqttClient::connect(const char *host, unsigned int port, const char *clientId, const char *user,
+        const char *password, unsigned int keepAlive) {
+    unsigned long len = sizeof(MQTT_CLIENT_PROTOCOL) + 3 + 2 + strlen(clientId);
+    unsigned char *p, flags = 0x02, result, i;
+    if (user != NULL) {
+        len += 2 + strlen(user);
+        flags |= 0x80;
+    }
+    if (password != NULL) {
+        len += 2 + strlen(password);
+        flags |= 0x40;
+    }
+    if (connected) {
+        disconnect();
+    }
+    queued = 0;
+    receiveState = RECEIVE_HEADER;
+    pinging = false;
+    p = reserve(1 + lengthSize(len) + len);
+    if (p == NULL) {
+        return TOO_LONG;
+    }
+
+    // CONNECT, with a clean session
+    *p++ = MQTT_CONNECT << 4;
+    p += encodeLength(p, len);
+    memcpy_P(p, MQTT_CLIENT_PROTOCOL, sizeof(MQTT_CLIENT_PROTOCOL));
+    p += sizeof(MQTT_CLIENT_PROTOCOL);
+    *p++ = flags;
+    *p++ = (unsigned char) (keepAlive >> 8);
+    *p++ = (unsigned char) keepAlive;
+    p += encodeString(p, clientId);
+    if (user != NULL) {
+        p += encodeString(p, user);
+    }
+    if (password != NULL) {
+        p += encodeString(p, password);
+    }
+    queued = p - queue;
+    this->keepAlive = keepAlive;
+    if (gprs->open(connection, "TCP", host, port) != Gprs::OK) {
+        queued = 0;
+        return CONNECT_FAILED;
+    }
+    connected = true;
+    if (flush() != OK) {
+        return SEND_FAILED;
+    }
+    result = waitFor(MQTT_CONNACK, 0, MQTT_CLIENT_TIMEOUT);
+    if (result != OK) {
+        lost();
+        return result;
+    }
+    returnCode = lastAckCode;
+    if (returnCode != 0) {
+        lost();
+        return REFUSED;
+    }
+
+    // What was in flight when the connection was lost goes again
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        if (inFlight[i].packetId != 0 && !resend(&inFlight[i])) {
+            return SEND_FAILED;
+        }
+    }
+    return flush();
+}
+
+unsigned char MqttClient::publish(const char *topic, const unsigned char *payload, unsigned int len,
+        unsigned char qos, bool retain) {
+    unsigned long rest = 2 + strlen(topic) + len, size;
+    unsigned char *p;
+    InFlight *slot = NULL;
+    if (!connected) {
+        return NOT_CONNECTED;
+    }
+    if (qos > 0) {
+        qos = 1;
+        rest += 2;
+
+        // A slot frees once its PUBACK comes, or once it is given up
+        slot = freeSlot();
+        if (slot == NULL) {
+            return IN_FLIGHT_FULL;
+        }
+    }
+    size = 1 + lengthSize(rest) + rest;
+    if (size > (slot != NULL ? MQTT_CLIENT_IN_FLIGHT_SIZE : MQTT_CLIENT_QUEUE_SIZE)) {
+        return TOO_LONG;
+    }
+    p = reserve((unsigned int) size);
+    if (p == NULL) {
+        return SEND_FAILED;
+    }
+    *p++ = (unsigned char) ((MQTT_PUBLISH << 4) | (qos << 1) | (retain ? 1 : 0));
+    p += encodeLength(p, rest);
+    p += encodeString(p, topic);
+    if (slot != NULL) {
+        slot->packetId = takePacketId();
+        slot->sent = false;
+        slot->retries = 0;
+        *p++ = (unsigned char) (slot->packetId >> 8);
+        *p++ = (unsigned char) slot->packetId;
+    }
+    memcpy(p, payload, len);
+    if (slot != NULL) {
+        slot->length = (unsigned int) size;
+        memcpy(slot->packet, queue + queued, slot->length);
+    }
+    queued += (unsigned int) size;
+    return OK;
+}
+
+unsigned char MqttClient::flush() {
+    unsigned char i;
+    if (queued == 0) {
+        return OK;
+    }
+    if (!connected) {
+        return NOT_CONNECTED;
+    }
+    if (gprs->beginSend(connection, queued) != Gprs::OK || gprs->write(queue, queued) != queued
+            || gprs->endSend() != Gprs::OK) {
+        lost();
+        return SEND_FAILED;
+    }
+    frames++;
+    queued = 0;
+    acking = false;
+    lastSentAt = millis();
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        if (inFlight[i].packetId != 0 && !inFlight[i].sent) {
+            inFlight[i].sent = true;
+            inFlight[i].sentAt = lastSentAt;
+        }
+    }
+    return OK;
+}
+
+unsigned char MqttClient::subscribe(const char *filter, unsigned char qos) {
+    unsigned long rest = 2 + 2 + strlen(filter) + 1, size = 1 + lengthSize(rest) + rest;
+    unsigned int packetId;
+    unsigned char *p, result;
+    if (!connected) {
+        return NOT_CONNECTED;
+    }
+    if (size > MQTT_CLIENT_QUEUE_SIZE) {
+        return TOO_LONG;
+    }
+    p = reserve((unsigned int) size);
+    if (p == NULL) {
+        return SEND_FAILED;
+    }
+    packetId = takePacketId();
+
+    // SUBSCRIBE has its reserved bits set to 0010
+    *p++ = (MQTT_SUBSCRIBE << 4) | 0x02;
+    p += encodeLength(p, rest);
+    *p++ = (unsigned char) (packetId >> 8);
+    *p++ = (unsigned char) packetId;
+    p += encodeString(p, filter);
+    *p = qos > 0 ? 1 : 0;
+    queued += (unsigned int) size;
+    if (flush() != OK) {
+        return SEND_FAILED;
+    }
+    result = waitFor(MQTT_SUBACK, packetId, MQTT_CLIENT_TIMEOUT);
+    if (result != OK) {
+        return result;
+    }
+    return lastAckCode == 0x80 ? (unsigned char) REFUSED : (unsigned char) OK;
+}
+
+unsigned char MqttClient::ping() {
+    unsigned char *p;
+    if (!connected) {
+        return NOT_CONNECTED;
+    }
+    p = reserve(2);
+    if (p == NULL) {
+        return SEND_FAILED;
+    }
+    p[0] = MQTT_PINGREQ << 4;
+    p[1] = 0;
+    queued += 2;
+    if (flush() != OK) {
+        return SEND_FAILED;
+    }
+    pinging = true;
+    pingSentAt = lastSentAt;
+    return waitFor(MQTT_PINGRESP, 0, MQTT_CLIENT_TIMEOUT);
+}
+
+unsigned char MqttClient::disconnect() {
+    unsigned char *p, result = OK;
+    if (!connected) {
+        return NOT_CONNECTED;
+    }
+    p = reserve(2);
+    if (p == NULL) {
+        return SEND_FAILED;
+    }
+    p[0] = MQTT_DISCONNECT << 4;
+    p[1] = 0;
+    queued += 2;
+    if (flush() != OK) {
+        result = SEND_FAILED;
+    }
+    lost();
+    return result;
+}
+
+void MqttClient::loop() {
+    unsigned long now;
+    unsigned char *p;
+    if (!connected) {
+        return;
+    }
+    receive();
+
+    // The PUBACKs of what was read and the PUBLISH sent again go together, with whatever is queued
+    if ((expire() || acking) && flush() != OK) {
+        return;
+    }
+    now = millis();
+    if (!connected || keepAlive == 0) {
+        return;
+    }
+
+    // No PINGRESP within the keep alive, the broker or the path is gone; other
+    // packets sent meanwhile do not count
+    if (pinging) {
+        if (now - pingSentAt >= keepAlive * 1000UL) {
+            lost();
+        }
+        return;
+    }
+
+    // Pings at three quarters of the keep alive, so it comes in time
+    if (now - lastSentAt >= keepAlive * 750UL) {
+        p = reserve(2);
+        if (p == NULL) {
+            return;
+        }
+        p[0] = MQTT_PINGREQ << 4;
+        p[1] = 0;
+        queued += 2;
+        if (flush() == OK) {
+            pinging = true;
+            pingSentAt = lastSentAt;
+        }
+    }
+}
+
+unsigned char MqttClient::getInFlight() {
+    unsigned char i, count = 0;
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        if (inFlight[i].packetId != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+unsigned char *MqttClient::reserve(unsigned int size) {
+    if (size > MQTT_CLIENT_QUEUE_SIZE) {
+        return NULL;
+    }
+    if (queued + size > MQTT_CLIENT_QUEUE_SIZE && flush() != OK) {
+        return NULL;
+    }
+    return queue + queued;
+}
+
+void MqttClient::receive() {
+    unsigned char buf[16];
+    int n, i;
+    while (connected && (n = gprs->read(connection, buf, sizeof(buf))) > 0) {
+        for (i = 0; i < n; i++) {
+            feed(buf[i]);
+        }
+    }
+}
+
+void MqttClient::lost() {
+    unsigned char i;
+    if (connected) {
+        gprs->close(connection);
+        connected = false;
+    }
+    queued = 0;
+    acking = false;
+    pinging = false;
+
+    // The packets in flight are kept, to be sent again after connect()
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        inFlight[i].sent = false;
+    }
+}
+
+unsigned char MqttClient::waitFor(unsigned char type, unsigned int packetId, unsigned long timeout) {
+    unsigned long start = millis();
+    lastAck = 0;
+    while (lastAck != type || lastAckId != packetId) {
+        receive();
+        if (!connected) {
+            return NOT_CONNECTED;
+        }
+        if (millis() - start >= timeout) {
+            return TIMEOUT;
+        }
+    }
+    return OK;
+}
+
+void MqttClient::feed(unsigned char c) {
+    switch (receiveState) {
+    case RECEIVE_HEADER:
+        header = c;
+        decoding = 0;
+        shift = 0;
+        receiveState = RECEIVE_LENGTH;
+        return;
+    case RECEIVE_LENGTH:
+
+        // Seven bits per byte, least significant first, the top bit set while more follow
+        decoding |= (unsigned long) (c & 0x7f) << shift;
+        shift += 7;
+        if (c & 0x80) {
+            if (shift > 21) {
+                lost();
+            }
+            return;
+        }
+        remaining = decoding;
+        receivedLength = 0;
+        if (remaining == 0) {
+            receiveState = RECEIVE_HEADER;
+            takePacket();
+        } else {
+            receiveState = RECEIVE_BODY;
+        }
+        return;
+    case RECEIVE_BODY:
+        if (receivedLength < MQTT_CLIENT_RECEIVE_SIZE) {
+            received[receivedLength++] = c;
+        }
+        if (--remaining == 0) {
+            receiveState = RECEIVE_HEADER;
+            takePacket();
+        }
+        return;
+    }
+}
+
+void MqttClient::takePacket() {
+    unsigned char type = header >> 4, qos, i, *p;
+    unsigned int packetId = receivedLength >= 2 ? (received[0] << 8) | received[1] : 0, topicLength, at;
+    switch (type) {
+    case MQTT_CONNACK:
+
+        // <session present>, <return code>
+        lastAckId = 0;
+        lastAckCode = receivedLength >= 2 ? received[1] : 0xff;
+        break;
+    case MQTT_PUBACK:
+        lastAckId = packetId;
+        for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+            if (inFlight[i].packetId == packetId) {
+                inFlight[i].packetId = 0;
+                if (publishedHandler != NULL) {
+                    publishedHandler(this, packetId, true, publishedContext);
+                }
+                break;
+            }
+        }
+        break;
+    case MQTT_SUBACK:
+        lastAckId = packetId;
+        lastAckCode = receivedLength >= 3 ? received[2] : 0x80;
+        break;
+    case MQTT_PINGRESP:
+        lastAckId = 0;
+        pinging = false;
+        break;
+    case MQTT_PUBLISH:
+
+        // <topic length><topic>[<packet id>]<payload>
+        qos = (header >> 1) & 0x03;
+        topicLength = packetId;
+        at = 2 + topicLength;
+        if (qos > 0) {
+            packetId = at + 2 <= receivedLength ? (received[at] << 8) | received[at + 1] : 0;
+            at += 2;
+        }
+        if (at <= receivedLength && messageHandler != NULL) {
+
+            // The topic moves over its length, to be terminated in place
+            memmove(received, received + 2, topicLength);
+            received[topicLength] = '\0';
+            messageLength = decoding - at;
+            messageHandler(this, (const char *) received, received + at, receivedLength - at, messageContext);
+        }
+
+        // A cut payload was told to the handler, but a message whose topic did
+        // not fit never reached it, and is left unacknowledged (packet id 0)
+        if (qos > 0 && packetId != 0) {
+            p = reserve(4);
+            if (p != NULL) {
+                p[0] = MQTT_PUBACK << 4;
+                p[1] = 2;
+                p[2] = (unsigned char) (packetId >> 8);
+                p[3] = (unsigned char) packetId;
+                queued += 4;
+                acking = true;
+            }
+        }
+        return;
+    default:
+        return;
+    }
+    lastAck = type;
+}
+
+bool MqttClient::expire() {
+    unsigned long now = millis();
+    unsigned char i;
+    unsigned int packetId;
+    bool resent = false;
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        packetId = inFlight[i].packetId;
+        if (packetId == 0 || !inFlight[i].sent || now - inFlight[i].sentAt < MQTT_CLIENT_ACK_TIMEOUT) {
+            continue;
+        }
+        if (inFlight[i].retries < MQTT_CLIENT_RETRIES) {
+            if (!resend(&inFlight[i])) {
+                return false;
+            }
+            inFlight[i].retries++;
+            resent = true;
+            continue;
+        }
+        inFlight[i].packetId = 0;
+        if (publishedHandler != NULL) {
+            publishedHandler(this, packetId, false, publishedContext);
+        }
+    }
+    return resent;
+}
+
+bool MqttClient::resend(InFlight *slot) {
+    unsigned char *p = reserve(slot->length);
+    if (p == NULL) {
+        return false;
+    }
+
+    // The same packet, DUP set
+    memcpy(p, slot->packet, slot->length);
+    p[0] |= 0x08;
+    queued += slot->length;
+    slot->sent = false;
+    return true;
+}
+
+MqttClient::InFlight *MqttClient::freeSlot() {
+    unsigned char i;
+    for (i = 0; i < MQTT_CLIENT_IN_FLIGHT; i++) {
+        if (inFlight[i].packetId == 0) {
+            return &inFlight[i];
+        }
+    }
+    return NULL;
+}
+
+unsigned int MqttClient::takePacketId() {
+    unsigned int packetId = nextPacketId;
+
+    // Packet ids are never 0
+    nextPacketId = nextPacketId == 65535 ? 1 : nextPacketId + 1;
+    return packetId;
+}
+
+unsigned char MqttClient::encodeLength(unsigned char *buf, unsigned long len) {
+    unsigned char n = 0;
+    do {
+        buf[n] = (unsigned char) (len & 0x7f);
+        len >>= 7;
+        if (len > 0) {
+            buf[n] |= 0x80;
+        }
+        n++;
+    } while (len > 0);
+    return n;
+}
+
+unsigned char MqttClient::lengthSize(unsigned long len) {
+    unsigned char n = 1;
+    for (len >>= 7; len > 0; len >>= 7) {
+        n++;
+    }
+    return n;
+}
+
+unsigned int MqttClient::encodeString(unsigned char *buf, const char *str) {
+    unsigned int len = strlen(str);
+    buf[0] = (unsigned char) (len >> 8);
+    buf[1] = (unsigned char) len;
+    memcpy(buf + 2, str, len);
+    return len + 2;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_MQTT_CLIENT_CPP__ */
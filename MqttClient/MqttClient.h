@@ -0,0 +1,446 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * MqttClient.h
+ *
+ * MQTT 3.1.1 client over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_MQTT_CLIENT_H__
+#define __ARDUINO_DRIVER_GSM_MQTT_CLIENT_H__ 1
+
+#include <Arduino.h>
+#include <Gprs.h>
+
+/**
+ * The queue the PUBLISH packets are encoded into until they are sent
+ * together, in one frame: at most MQTT_CLIENT_FRAME_SIZE. The closer to
+ * it, the fewer frames, on boards with the RAM.
+ */
+#ifndef MQTT_CLIENT_QUEUE_SIZE
+#define MQTT_CLIENT_QUEUE_SIZE          256
+#endif
+
+/**
+ * Largest payload the modem takes in one AT+CIPSEND.
+ */
+#ifndef MQTT_CLIENT_FRAME_SIZE
+#define MQTT_CLIENT_FRAME_SIZE          1460
+#endif
+
+/**
+ * QoS 1 packets sent and not acknowledged yet that are tracked.
+ */
+#ifndef MQTT_CLIENT_IN_FLIGHT
+#define MQTT_CLIENT_IN_FLIGHT           4
+#endif
+
+/**
+ * Largest QoS 1 PUBLISH packet, kept in its in flight slot until its
+ * PUBACK so that it can be sent again.
+ */
+#ifndef MQTT_CLIENT_IN_FLIGHT_SIZE
+#define MQTT_CLIENT_IN_FLIGHT_SIZE      64
+#endif
+
+/**
+ * Times a QoS 1 PUBLISH is sent again, once MQTT_CLIENT_ACK_TIMEOUT passed
+ * without its PUBACK, before it is given up.
+ */
+#ifndef MQTT_CLIENT_RETRIES
+#define MQTT_CLIENT_RETRIES             3
+#endif
+
+/**
+ * Received packet, topic and payload of a PUBLISH, beyond which it is
+ * cut.
+ */
+#ifndef MQTT_CLIENT_RECEIVE_SIZE
+#define MQTT_CLIENT_RECEIVE_SIZE        64
+#endif
+
+#define MQTT_CLIENT_TIMEOUT             10000UL
+#define MQTT_CLIENT_ACK_TIMEOUT         20000UL
+
+class MqttClient;
+
+/**
+ * Receives the messages published to the subscribed topics. Both strings
+ * are only valid during the call.
+ *
+ * @param topic         The topic, terminated.
+ * @param payload       The payload, cut to what fits the receive buffer:
+ *                      client->getMessageLength() tells its full length.
+ * @param len           Its length.
+ * @param context       The opaque pointer given with the handler.
+ */
+typedef void (*MqttMessageHandler)(MqttClient *client, const char *topic, const unsigned char *payload,
+        unsigned int len, void *context);
+
+/**
+ * Tells what became of a QoS 1 PUBLISH: acknowledged, or given up once
+ * sent MQTT_CLIENT_RETRIES more times without a PUBACK.
+ */
+typedef void (*MqttPublishedHandler)(MqttClient *client, unsigned int packetId, bool acknowledged, void *context);
+
+/**
+ * The PUBLISH packets are encoded into a queue and sent together, in one
+ * AT+CIPSEND frame: the queue is sent when the next one does not fit, by
+ * flush(), and before any other packet. The PUBACK of the messages
+ * received join the queue too, sent by the next flush() or at the end of
+ * loop().
+ *
+ * The QoS 1 packets wait for their PUBACK in a table of
+ * MQTT_CLIENT_IN_FLIGHT entries, each keeping its packet; publishing one
+ * more while the table is full returns IN_FLIGHT_FULL at once, to be
+ * tried again after loop(). A packet without its PUBACK within
+ * MQTT_CLIENT_ACK_TIMEOUT is sent again with DUP set, and so are all of
+ * them after a reconnect: QoS 1 is delivered at least once.
+ */
+class MqttClient {
+
+    /**
+     * A QoS 1 packet waiting for its PUBACK, sent or still queued, the
+     * times it was sent again, and the packet itself.
+     */
+    struct InFlight {
+        unsigned int packetId;
+        unsigned long sentAt;
+        bool sent;
+        unsigned char retries;
+        unsigned int length;
+        unsigned char packet[MQTT_CLIENT_IN_FLIGHT_SIZE];
+    };
+
+    enum ReceiveState {
+        RECEIVE_HEADER = 0,
+        RECEIVE_LENGTH = 1,
+        RECEIVE_BODY = 2
+    };
+
+    Gprs *gprs;
+    char connection;
+    bool connected;
+
+    /**
+     * The CONNACK return code, and the keep alive, in seconds.
+     */
+    unsigned char returnCode;
+    unsigned int keepAlive;
+
+    /**
+     * When a packet was last sent, for the keep alive, whether a PINGRESP
+     * is awaited and since when.
+     */
+    unsigned long lastSentAt;
+    bool pinging;
+    unsigned long pingSentAt;
+
+    static_assert(MQTT_CLIENT_QUEUE_SIZE <= MQTT_CLIENT_FRAME_SIZE, "The MQTT queue does not fit in a frame");
+    static_assert(MQTT_CLIENT_IN_FLIGHT_SIZE <= MQTT_CLIENT_QUEUE_SIZE, "An in flight packet does not fit the queue");
+
+    /**
+     * The packets waiting to be sent, how many bytes, whether PUBACKs are
+     * among them, and the frames sent so far.
+     */
+    unsigned char queue[MQTT_CLIENT_QUEUE_SIZE];
+    unsigned int queued;
+    bool acking;
+    unsigned long frames;
+
+    InFlight inFlight[MQTT_CLIENT_IN_FLIGHT];
+    unsigned int nextPacketId;
+
+    /**
+     * The packet being received: its first byte, its remaining length,
+     * the length being decoded and the shift of its next digit, what is
+     * kept of it and how much of it is left to come.
+     */
+    unsigned char header;
+    unsigned long remaining;
+    unsigned long decoding;
+    unsigned char shift;
+    unsigned char received[MQTT_CLIENT_RECEIVE_SIZE];
+    unsigned int receivedLength;
+    unsigned char receiveState;
+
+    /**
+     * The full payload length of the message being handled.
+     */
+    unsigned long messageLength;
+
+    /**
+     * The last acknowledgement received, for the packets waited for: its
+     * type, its packet id and the code it carries (the CONNACK return code
+     * or the SUBACK granted QoS).
+     */
+    unsigned char lastAck;
+    unsigned int lastAckId;
+    unsigned char lastAckCode;
+
+    MqttMessageHandler messageHandler;
+    void *messageContext;
+    MqttPublishedHandler publishedHandler;
+    void *publishedContext;
+
+    /**
+     * Makes room for a packet at the end of the queue, sending the queue
+     * if it does not fit.
+     *
+     * @param size          Size of the packet.
+     * @return              Where to encode it, NULL if it does not fit the
+     *                      queue or the queue could not be sent.
+     */
+    unsigned char *reserve(unsigned int size);
+
+    /**
+     * Reads what was received so far.
+     */
+    void receive();
+
+    /**
+     * Closes a connection which failed, giving up what is queued. The
+     * QoS 1 packets in flight are kept, sent again by the next connect().
+     */
+    void lost();
+
+    /**
+     * Waits for an acknowledgement.
+     *
+     * @param type          The packet type, e.g. MQTT_CONNACK.
+     * @param packetId      Its packet id, 0 if it has none.
+     * @return              Result
+     */
+    unsigned char waitFor(unsigned char type, unsigned int packetId, unsigned long timeout);
+
+    /**
+     * Parses a received byte.
+     */
+    void feed(unsigned char c);
+
+    /**
+     * Acts on a complete received packet.
+     */
+    void takePacket();
+
+    /**
+     * Queues again, with DUP set, the QoS 1 packets which waited too long
+     * for their PUBACK, and gives up those sent too many times.
+     *
+     * @return              Whether a packet was queued again.
+     */
+    bool expire();
+
+    /**
+     * Queues a QoS 1 packet in flight again, with DUP set.
+     *
+     * @return              false if the queue could not be sent to make
+     *                      room for it.
+     */
+    bool resend(InFlight *slot);
+
+    /**
+     * A free slot of the in flight table, NULL if none.
+     */
+    InFlight *freeSlot();
+
+    unsigned int takePacketId();
+
+    /**
+     * Writes the remaining length of a packet.
+     *
+     * @return              Number of bytes written, up to 4.
+     */
+    static unsigned char encodeLength(unsigned char *buf, unsigned long len);
+
+    static unsigned char lengthSize(unsigned long len);
+
+    /**
+     * Writes a string with its 16 bits length.
+     *
+     * @return              Number of bytes written.
+     */
+    static unsigned int encodeString(unsigned char *buf, const char *str);
+
+public:
+
+    enum Result {
+        OK = 0,
+        ERROR = 1,
+        CONNECT_FAILED = 2,
+
+        // The broker refused the connection, see getReturnCode()
+        REFUSED = 3,
+        SEND_FAILED = 4,
+        TIMEOUT = 5,
+
+        // The packet does not fit the queue or the buffer it is built in
+        TOO_LONG = 6,
+        NOT_CONNECTED = 7,
+
+        // Every QoS 1 slot waits for its PUBACK, see loop()
+        IN_FLIGHT_FULL = 8
+    };
+
+    enum PacketType {
+        MQTT_CONNECT = 1,
+        MQTT_CONNACK = 2,
+        MQTT_PUBLISH = 3,
+        MQTT_PUBACK = 4,
+        MQTT_SUBSCRIBE = 8,
+        MQTT_SUBACK = 9,
+        MQTT_PINGREQ = 12,
+        MQTT_PINGRESP = 13,
+        MQTT_DISCONNECT = 14
+    };
+
+    /**
+     * Public constructor.
+     *
+     * @param gprs          The GPRS connection, brought up.
+     * @param connection    The connection, -1 in single connection mode.
+     */
+    MqttClient(Gprs *gprs, char connection);
+
+    /**
+     * Opens the connection to the broker and sends CONNECT, with a clean
+     * session, then waits for CONNACK. The QoS 1 packets still in flight
+     * are then sent again.
+     *
+     * @param host          The broker.
+     * @param port          Its port, 1883 usually.
+     * @param clientId      The client identifier.
+     * @param user          The user name, NULL if none.
+     * @param password      The password, NULL if none.
+     * @param keepAlive     Seconds, 0 to disable.
+     * @return              Result
+     */
+    unsigned char connect(const char *host, unsigned int port, const char *clientId, const char *user,
+            const char *password, unsigned int keepAlive);
+
+    /**
+     * Queues a PUBLISH, sending the queue first if it does not fit. A QoS
+     * 1 one takes a slot in the in flight table, and at most
+     * MQTT_CLIENT_IN_FLIGHT_SIZE bytes.
+     *
+     * @param topic
+     * @param payload
+     * @param len
+     * @param qos           0 or 1.
+     * @param retain
+     * @return              Result, IN_FLIGHT_FULL without waiting if no
+     *                      slot is free.
+     */
+    unsigned char publish(const char *topic, const unsigned char *payload, unsigned int len, unsigned char qos,
+            bool retain = false);
+
+    /**
+     * Sends the queued packets, in one frame.
+     *
+     * @return              Result
+     */
+    unsigned char flush();
+
+    /**
+     * Subscribes to a topic filter and waits for SUBACK.
+     *
+     * @param filter
+     * @param qos           The maximum QoS asked, 0 or 1.
+     * @return              Result, REFUSED if the broker refused it.
+     */
+    unsigned char subscribe(const char *filter, unsigned char qos);
+
+    /**
+     * Sends PINGREQ and waits for PINGRESP.
+     *
+     * @return              Result
+     */
+    unsigned char ping();
+
+    /**
+     * Reads and acts on what the broker sent, sends the PUBACK of what it
+     * read with the queue, sends again the PUBLISH waiting too long for
+     * their PUBACK and pings when the keep alive asks to. To be called
+     * often.
+     */
+    void loop();
+
+    /**
+     * Sends the queue, then DISCONNECT, and closes the connection.
+     *
+     * @return              Result
+     */
+    unsigned char disconnect();
+
+    /**
+     * Sets the handler of the received messages.
+     */
+    void onMessage(MqttMessageHandler handler, void *context);
+
+    /**
+     * Sets the handler told about the QoS 1 PUBLISH packets.
+     */
+    void onPublished(MqttPublishedHandler handler, void *context);
+
+    inline bool isConnected() {
+        return connected;
+    }
+
+    /**
+     * The return code of the last CONNACK.
+     *
+     * @return
+     */
+    inline unsigned char getReturnCode() {
+        return returnCode;
+    }
+
+    /**
+     * The packet id of the last QoS 1 PUBLISH.
+     *
+     * @return
+     */
+    inline unsigned int getLastPacketId() {
+        return nextPacketId == 1 ? 65535 : nextPacketId - 1;
+    }
+
+    /**
+     * Number of QoS 1 packets waiting for their PUBACK.
+     *
+     * @return
+     */
+    unsigned char getInFlight();
+
+    /**
+     * Bytes queued.
+     *
+     * @return
+     */
+    inline unsigned int getQueued() {
+        return queued;
+    }
+
+    /**
+     * The payload length of the message being handled, as published: more
+     * than the handler was given when it was cut to MQTT_CLIENT_RECEIVE_SIZE.
+     * Only meaningful within the message handler.
+     *
+     * @return
+     */
+    inline unsigned long getMessageLength() {
+        return messageLength;
+    }
+
+    /**
+     * Number of frames sent.
+     *
+     * @return
+     */
+    inline unsigned long getFrames() {
+        return frames;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_MQTT_CLIENT_H__ */
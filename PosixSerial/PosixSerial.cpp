@@ -0,0 +1,134 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * PosixSerial.cpp
+ *
+ * Serial transport over a termios device or pseudo-terminal, to run the
+ * driver on a Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_POSIX_SERIAL_CPP__
+#define __ARDUINO_DRIVER_GSM_POSIX_SERIAL_CPP__ 1
+
+#include "PosixSerial.h"
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+static speed_t baudToSpeed(unsigned long baud) {
+    switch (baud) {
+    case 1200:
+        return B1200;
+    case 2400:
+        return B2400;
+    case 4800:
+        return B4800;
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    default:
+        return B0;
+    }
+}
+
+PosixSerial::PosixSerial(const char *path)
+        : path(path), fd(-1), peeked(-1) {
+}
+
+PosixSerial::~PosixSerial() {
+    end();
+}
+
+void PosixSerial::begin(unsigned long baud) {
+    struct termios options;
+    speed_t speed = baudToSpeed(baud);
+    if (fd < 0) {
+        fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0) {
+            return;
+        }
+    }
+    if (tcgetattr(fd, &options) == 0) {
+        cfmakeraw(&options);
+        options.c_cflag |= CLOCAL | CREAD;
+        if (speed != B0) {
+            cfsetispeed(&options, speed);
+            cfsetospeed(&options, speed);
+        }
+        tcsetattr(fd, TCSANOW, &options);
+    }
+    peeked = -1;
+}
+
+void PosixSerial::end() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int PosixSerial::available() {
+    int n = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &n) < 0) {
+        n = 0;
+    }
+    return n + (peeked >= 0 ? 1 : 0);
+}
+
+int PosixSerial::read() {
+    unsigned char c;
+    int p = peeked;
+    if (p >= 0) {
+        peeked = -1;
+        return p;
+    }
+    if (fd < 0 || ::read(fd, &c, 1) != 1) {
+        return -1;
+    }
+    return c;
+}
+
+int PosixSerial::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+size_t PosixSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t PosixSerial::write(const uint8_t *buf, size_t len) {
+    size_t written = 0;
+    ssize_t n;
+    while (fd >= 0 && written < len) {
+        n = ::write(fd, buf + written, len - written);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0) {
+
+            // Non-blocking descriptor, wait until there is room again
+            usleep(1000);
+        }
+    }
+    return written;
+}
+
+void PosixSerial::flush() {
+    if (fd >= 0) {
+        tcdrain(fd);
+    }
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_POSIX_SERIAL_CPP__ */
@@ -0,0 +1,84 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * PosixSerial.h
+ *
+ * Serial transport over a termios device or pseudo-terminal, to run the
+ * driver on a Linux host.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_POSIX_SERIAL_H__
+#define __ARDUINO_DRIVER_GSM_POSIX_SERIAL_H__ 1
+
+#include <Arduino.h>
+
+class PosixSerial: public Stream {
+
+    /**
+     * Path of the device, e.g. /dev/ttyUSB0 or /dev/pts/3.
+     */
+    const char *path;
+
+    /**
+     * File descriptor, -1 while closed.
+     */
+    int fd;
+
+    /**
+     * Byte read by peek(), -1 if none.
+     */
+    int peeked;
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param path          Path of the device.
+     */
+    PosixSerial(const char *path);
+
+    virtual ~PosixSerial();
+
+    /**
+     * Opens the device in raw mode.
+     *
+     * A baud rate the device does not support is ignored, which is
+     * what happens on pseudo-terminals.
+     *
+     * @param baud          The baud rate.
+     */
+    void begin(unsigned long baud);
+
+    /**
+     * Closes the device.
+     */
+    void end();
+
+    /**
+     * Tells if the device is open.
+     *
+     * @return
+     */
+    inline bool isOpen() {
+        return fd >= 0;
+    }
+
+    virtual int available();
+
+    virtual int read();
+
+    virtual int peek();
+
+    virtual size_t write(uint8_t c);
+
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    virtual void flush();
+
+    using Print::write;
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_POSIX_SERIAL_H__ */
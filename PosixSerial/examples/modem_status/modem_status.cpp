@@ -0,0 +1,31 @@
+/**
+ * Queries a SIM900 attached to a serial port (or a pseudo-terminal) of a
+ * Linux host.
+ *
+ * $ make host
+ * $ build/host/modem_status /dev/ttyUSB0 19200
+ */
+
+#include <Arduino.h>
+#include <SIM900.h>
+#include <GprsSIM900.h>
+
+int main(int argc, char **argv) {
+    unsigned char state;
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <device> [baud]\n", argv[0]);
+        return 2;
+    }
+    PosixSerial serial(argv[1]);
+    SIM900 sim(&serial);
+    GprsSIM900 gprs(&sim);
+    if (!gprs.begin(argc > 2 ? atol(argv[2]) : 19200)) {
+        Serial.println(F("Cannot initialize the modem."));
+        return 1;
+    }
+    state = gprs.status();
+    Serial.print(F("Connection state: "));
+    Serial.println(state);
+    Serial.flush();
+    return state == GprsSIM900::ERROR_WHEN_QUERING ? 1 : 0;
+}
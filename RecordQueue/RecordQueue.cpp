@@ -0,0 +1,79 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * RecordQueue.cpp
+ *
+ * Coalesces small records into full frames over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RECORD_QUEUE_CPP__
+#define __ARDUINO_DRIVER_GSM_RECORD_QUEUE_CPP__ 1
+
+#include "RecordQueue.h"
+
+RecordQueue::RecordQueue(Gprs *gprs, char connection)
+        : gprs(gprs), connection(connection), queued(0), records(0), oldestAt(0), maxAge(RECORD_QUEUE_MAX_AGE),
+          frames(0), sentRecords(0) {
+}
+
+unsigned char RecordQueue::append(const unsigned char *record, unsigned int len) {
+    if (len > RECORD_QUEUE_SIZE) {
+        return TOO_LONG;
+    }
+    if (queued + len > RECORD_QUEUE_SIZE && flush() != OK) {
+        return SEND_FAILED;
+    }
+    if (queued == 0) {
+        oldestAt = millis();
+    }
+    memcpy(arena + queued, record, len);
+    queued += len;
+    records++;
+
+    // A full arena goes at once, instead of with the next record. The record
+    // is in: if the arena could not go, it is kept for the next flush
+    if (queued == RECORD_QUEUE_SIZE) {
+        flush();
+    } else {
+        poll();
+    }
+    return OK;
+}
+
+unsigned char RecordQueue::poll() {
+    if (queued > 0 && millis() - oldestAt >= maxAge) {
+        return flush();
+    }
+    return OK;
+}
+
+unsigned char RecordQueue::flush() {
+    unsigned int accepted;
+    if (queued == 0) {
+        return OK;
+    }
+    if (gprs->beginSend(connection, queued) != Gprs::OK) {
+        return SEND_FAILED;
+    }
+    gprs->write(arena, queued);
+    if (gprs->endSend() != Gprs::OK) {
+
+        // The peer has what the modem took: only the rest is kept
+        accepted = (unsigned int) gprs->getAccepted();
+        if (accepted > 0 && accepted < queued) {
+            queued -= accepted;
+            memmove(arena, arena + accepted, queued);
+            frames++;
+        }
+        return SEND_FAILED;
+    }
+    frames++;
+    sentRecords += records;
+    queued = 0;
+    records = 0;
+    return OK;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_RECORD_QUEUE_CPP__ */
@@ -0,0 +1,170 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * RecordQueue.h
+ *
+ * Coalesces small records into full frames over a Gprs connection.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RECORD_QUEUE_H__
+#define __ARDUINO_DRIVER_GSM_RECORD_QUEUE_H__ 1
+
+#include <Arduino.h>
+#include <Gprs.h>
+
+/**
+ * The arena the records are appended to, sent as one frame once full: at
+ * most RECORD_QUEUE_FRAME_SIZE.
+ */
+#ifndef RECORD_QUEUE_SIZE
+#define RECORD_QUEUE_SIZE               512
+#endif
+
+/**
+ * Largest payload the modem takes in one AT+CIPSEND.
+ */
+#ifndef RECORD_QUEUE_FRAME_SIZE
+#define RECORD_QUEUE_FRAME_SIZE         1460
+#endif
+
+/**
+ * Default age of the oldest record at which the arena is sent, however
+ * full, in milliseconds.
+ */
+#ifndef RECORD_QUEUE_MAX_AGE
+#define RECORD_QUEUE_MAX_AGE            60000UL
+#endif
+
+/**
+ * Records, sensor readings of a few tens of bytes each, are appended to an
+ * arena which is sent in one AT+CIPSEND: when the next record does not
+ * fit, when the oldest one waited for the maximum age, or when flush() is
+ * called for urgent data. The link then carries full frames instead of
+ * one command, prompt and SEND OK per record.
+ *
+ * The records are sent as they were appended, back to back: they carry
+ * their own framing, a line each for instance. What the modem did not
+ * take stays queued, and goes first with the next flush; what it took is
+ * not sent again.
+ */
+class RecordQueue {
+
+    Gprs *gprs;
+    char connection;
+
+    unsigned char arena[RECORD_QUEUE_SIZE];
+    unsigned int queued;
+    unsigned int records;
+
+    /**
+     * When the oldest record queued was appended, and the age at which it
+     * is sent.
+     */
+    unsigned long oldestAt;
+    unsigned long maxAge;
+
+    unsigned long frames;
+    unsigned long sentRecords;
+
+    static_assert(RECORD_QUEUE_SIZE <= RECORD_QUEUE_FRAME_SIZE, "The record arena does not fit in a frame");
+
+public:
+
+    enum Result {
+        OK = 0,
+        ERROR = 1,
+
+        // The record is longer than the arena
+        TOO_LONG = 2,
+
+        // The arena could not be sent, it is kept
+        SEND_FAILED = 3
+    };
+
+    /**
+     * Public constructor.
+     *
+     * @param gprs          The GPRS connection, brought up.
+     * @param connection    The connection, opened, -1 in single connection
+     *                      mode.
+     */
+    RecordQueue(Gprs *gprs, char connection);
+
+    /**
+     * Appends a record, sending the arena first if it does not fit, and
+     * after if it is full or its oldest record is too old.
+     *
+     * @param record
+     * @param len
+     * @return              Result, OK once the record is appended, even if
+     *                      the arena could not be sent after it;
+     *                      SEND_FAILED if the record was not appended for
+     *                      the arena could not be sent before it.
+     */
+    unsigned char append(const unsigned char *record, unsigned int len);
+
+    /**
+     * Sends the arena when its oldest record is too old. To be called
+     * often, between appends which may not come in time.
+     *
+     * @return              Result
+     */
+    unsigned char poll();
+
+    /**
+     * Sends the arena now.
+     *
+     * @return              Result, SEND_FAILED with the bytes the modem did
+     *                      not take kept.
+     */
+    unsigned char flush();
+
+    /**
+     * Sets the age of the oldest record at which the arena is sent.
+     *
+     * @param maxAge        Milliseconds, 0 to send each record at once.
+     */
+    inline void setMaxAge(unsigned long maxAge) {
+        this->maxAge = maxAge;
+    }
+
+    /**
+     * Bytes queued.
+     *
+     * @return
+     */
+    inline unsigned int getQueued() {
+        return queued;
+    }
+
+    /**
+     * Records queued, one partly sent included.
+     *
+     * @return
+     */
+    inline unsigned int getRecords() {
+        return records;
+    }
+
+    /**
+     * Number of frames sent.
+     *
+     * @return
+     */
+    inline unsigned long getFrames() {
+        return frames;
+    }
+
+    /**
+     * Number of records sent.
+     *
+     * @return
+     */
+    inline unsigned long getSentRecords() {
+        return sentRecords;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_RECORD_QUEUE_H__ */
@@ -0,0 +1,82 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CommandBatch.cpp
+ *
+ * Several extended commands sent on a single command line.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_COMMAND_BATCH_CPP__
+#define __ARDUINO_DRIVER_GSM_COMMAND_BATCH_CPP__ 1
+
+#include "CommandBatch.h"
+
+CommandBatch::CommandBatch() {
+    clear();
+}
+
+void CommandBatch::clear() {
+    line.clear();
+    line.append(F("AT"));
+    count = 0;
+    overflowed = false;
+    cut = 0;
+}
+
+bool CommandBatch::open() {
+    if (count >= COMMAND_BATCH_MAX_COMMANDS || (count > 0 && !line.append(';'))) {
+        overflowed = true;
+        return false;
+    }
+    offsets[count] = line.size();
+    statuses[count] = NOT_RUN;
+    count++;
+    return true;
+}
+
+bool CommandBatch::add(const char *command) {
+    return open() && line.append(command);
+}
+
+bool CommandBatch::add(const __FlashStringHelper *command) {
+    return open() && line.append(command);
+}
+
+bool CommandBatch::append(const char *text) {
+    if (count == 0) {
+        overflowed = true;
+        return false;
+    }
+    return line.append(text);
+}
+
+bool CommandBatch::append(const __FlashStringHelper *text) {
+    if (count == 0) {
+        overflowed = true;
+        return false;
+    }
+    return line.append(text);
+}
+
+const char *CommandBatch::isolate(unsigned char index) {
+    restore();
+    if (index >= count) {
+        return NULL;
+    }
+    if (index + 1 < count) {
+        cut = offsets[index + 1] - 1;
+        line.c_str()[cut] = '\0';
+    }
+    return line.c_str() + offsets[index];
+}
+
+void CommandBatch::restore() {
+    if (cut > 0) {
+        line.c_str()[cut] = ';';
+        cut = 0;
+    }
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_COMMAND_BATCH_CPP__ */
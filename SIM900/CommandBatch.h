@@ -0,0 +1,184 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CommandBatch.h
+ *
+ * Several extended commands sent on a single command line.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_COMMAND_BATCH_H__
+#define __ARDUINO_DRIVER_GSM_COMMAND_BATCH_H__ 1
+
+#include <Arduino.h>
+#include "CommandBuilder.h"
+
+#define COMMAND_BATCH_LINE_LENGTH               128
+#define COMMAND_BATCH_MAX_COMMANDS              8
+
+/**
+ * Collects extended commands into one line, e.g.:
+ *
+ * AT+CIPMUX=0;+CSTT="tim.br","tim","tim";+CDNSCFG="8.8.8.8","8.8.4.4"
+ *
+ * The modem runs them in order and stops at the first one which fails,
+ * answering a single OK or ERROR for the whole line. Only commands that
+ * can safely be repeated (settings) should be batched, since a failed
+ * batch is run again one command at a time to find out which one failed.
+ */
+class CommandBatch {
+
+    /**
+     * The command line, starting with AT.
+     */
+    StaticCommandBuilder<COMMAND_BATCH_LINE_LENGTH> line;
+
+    /**
+     * Number of commands in the line.
+     */
+    unsigned char count;
+
+    /**
+     * Set when a command did not fit in the line.
+     */
+    bool overflowed;
+
+    /**
+     * Where each command starts in the line.
+     */
+    unsigned char offsets[COMMAND_BATCH_MAX_COMMANDS];
+
+    /**
+     * Status of each command, one of CommandStatus.
+     */
+    unsigned char statuses[COMMAND_BATCH_MAX_COMMANDS];
+
+    /**
+     * Where isolate() cut the line, 0 if it is whole.
+     */
+    unsigned char cut;
+
+    /**
+     * Starts a new command in the line.
+     *
+     * @return              false if there is no room for another command.
+     */
+    bool open();
+
+public:
+
+    enum CommandStatus {
+        NOT_RUN = 0,
+        SUCCEEDED = 1,
+        FAILED = 2
+    };
+
+    /**
+     * Public constructor.
+     */
+    CommandBatch();
+
+    /**
+     * Removes all commands.
+     */
+    void clear();
+
+    /**
+     * Adds an extended command to the batch.
+     *
+     * @param command       The command, starting with '+', without AT.
+     * @return              false if the command does not fit.
+     */
+    bool add(const char *command);
+
+    /**
+     * Adds an extended command stored in flash to the batch.
+     *
+     * @param command       The command, starting with '+', without AT.
+     * @return              false if the command does not fit.
+     */
+    bool add(const __FlashStringHelper *command);
+
+    /**
+     * Appends text to the last command added.
+     *
+     * @param text          The text to be appended.
+     * @return              false if the text does not fit.
+     */
+    bool append(const char *text);
+
+    /**
+     * Appends text stored in flash to the last command added.
+     *
+     * @param text          The text to be appended.
+     * @return              false if the text does not fit.
+     */
+    bool append(const __FlashStringHelper *text);
+
+    /**
+     * Tells if something did not fit in the line. An overflowed batch
+     * is never sent.
+     *
+     * @return
+     */
+    inline bool isOverflowed() {
+        return overflowed || line.isOverflowed();
+    }
+
+    /**
+     * Number of commands in the batch.
+     *
+     * @return
+     */
+    inline unsigned char size() {
+        return count;
+    }
+
+    /**
+     * The command line, starting with AT.
+     *
+     * @return
+     */
+    inline CommandBuilder *getLine() {
+        return &line;
+    }
+
+    /**
+     * Cuts the line right after one command, so it can be sent alone.
+     * The line must be restored with restore() before anything else.
+     *
+     * @param index         The command index.
+     * @return              The command without AT, NULL if index is out of range.
+     */
+    const char *isolate(unsigned char index);
+
+    /**
+     * Undoes isolate().
+     */
+    void restore();
+
+    /**
+     * Status of one command after the batch was sent.
+     *
+     * @param index         The command index.
+     * @return              One of CommandStatus.
+     */
+    inline unsigned char getStatus(unsigned char index) {
+        return index < count ? statuses[index] : (unsigned char) NOT_RUN;
+    }
+
+    /**
+     * Sets the status of one command.
+     *
+     * @param index         The command index.
+     * @param status        One of CommandStatus.
+     */
+    inline void setStatus(unsigned char index, unsigned char status) {
+        if (index < count) {
+            statuses[index] = status;
+        }
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_COMMAND_BATCH_H__ */
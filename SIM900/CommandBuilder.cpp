@@ -0,0 +1,97 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CommandBuilder.cpp
+ *
+ * Bounded builder of command lines.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_CPP__
+#define __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_CPP__ 1
+
+#include "CommandBuilder.h"
+
+CommandBuilder::CommandBuilder(char *buf, unsigned int capacity)
+        : buf(buf), capacity(capacity) {
+    clear();
+}
+
+void CommandBuilder::clear() {
+    length = 0;
+    overflowed = false;
+    buf[0] = '\0';
+}
+
+bool CommandBuilder::append(const char *str) {
+    return append(str, strlen(str));
+}
+
+bool CommandBuilder::append(const __FlashStringHelper *str) {
+    const char *p = (const char *) str;
+    unsigned int len = strlen_P(p);
+    if (length + len + 2 > capacity) {
+        overflowed = true;
+        return false;
+    }
+    memcpy_P(buf + length, p, len);
+    length += len;
+    buf[length] = '\0';
+    return true;
+}
+
+bool CommandBuilder::append(char c) {
+    return append(&c, 1);
+}
+
+bool CommandBuilder::appendNumber(unsigned long n) {
+    char digits[10];
+    unsigned char i = sizeof(digits);
+    do {
+        digits[--i] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+    return append(digits + i, sizeof(digits) - i);
+}
+
+bool CommandBuilder::appendQuoted(const char *str) {
+    unsigned int len = strlen(str);
+    if (length + len + 4 > capacity) {
+        overflowed = true;
+        return false;
+    }
+    append('"');
+    append(str, len);
+    return append('"');
+}
+
+bool CommandBuilder::append(const char *data, unsigned int len) {
+
+    // Keeps room for the line terminator and the \0
+    if (length + len + 2 > capacity) {
+        overflowed = true;
+        return false;
+    }
+    memcpy(buf + length, data, len);
+    length += len;
+    buf[length] = '\0';
+    return true;
+}
+
+void CommandBuilder::truncate(unsigned int len) {
+    if (len < length) {
+        length = len;
+        buf[length] = '\0';
+    }
+}
+
+size_t CommandBuilder::writeTo(Print *out) {
+    size_t written;
+    buf[length] = '\r';
+    written = out->write((const uint8_t *) buf, length + 1);
+    buf[length] = '\0';
+    return written;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_CPP__ */
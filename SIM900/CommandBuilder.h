@@ -0,0 +1,231 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * CommandBuilder.h
+ *
+ * Bounded builder of command lines.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_H__
+#define __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_H__ 1
+
+#include <Arduino.h>
+
+/**
+ * Formats a command line into a fixed buffer, so it can be written to the
+ * modem in a single burst. Nothing is allocated; when something does not
+ * fit, it is dropped and the builder is marked as overflowed.
+ *
+ * Two bytes of the buffer are always kept for the line terminator and the
+ * \0, so the line can be written as is.
+ */
+class CommandBuilder {
+
+    /**
+     * The buffer, \0 terminated.
+     */
+    char *buf;
+
+    /**
+     * Size of the buffer.
+     */
+    unsigned int capacity;
+
+    /**
+     * Number of bytes in the buffer.
+     */
+    unsigned int length;
+
+    /**
+     * Set when something did not fit.
+     */
+    bool overflowed;
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param buf           The buffer, at least 2 bytes long.
+     * @param capacity      Size of the buffer.
+     */
+    CommandBuilder(char *buf, unsigned int capacity);
+
+    /**
+     * Empties the builder.
+     */
+    void clear();
+
+    /**
+     * Appends a \0 terminated string.
+     *
+     * @param str
+     * @return              false if it does not fit.
+     */
+    bool append(const char *str);
+
+    /**
+     * Appends a \0 terminated string stored in flash.
+     *
+     * @param str
+     * @return              false if it does not fit.
+     */
+    bool append(const __FlashStringHelper *str);
+
+    /**
+     * Appends a single char.
+     *
+     * @param c
+     * @return              false if it does not fit.
+     */
+    bool append(char c);
+
+    /**
+     * Appends a number in decimal.
+     *
+     * @param n
+     * @return              false if it does not fit.
+     */
+    bool appendNumber(unsigned long n);
+
+    /**
+     * Appends a string between double quotes.
+     *
+     * @param str
+     * @return              false if it does not fit.
+     */
+    bool appendQuoted(const char *str);
+
+    /**
+     * Appends raw bytes.
+     *
+     * @param data
+     * @param len
+     * @return              false if they do not fit.
+     */
+    bool append(const char *data, unsigned int len);
+
+    /**
+     * Cuts the line at the given length.
+     *
+     * @param len
+     */
+    void truncate(unsigned int len);
+
+    /**
+     * Writes the line and its terminator with a single write call.
+     *
+     * @param out           Where to write.
+     * @return              Number of bytes written.
+     */
+    size_t writeTo(Print *out);
+
+    /**
+     * Tells if something did not fit.
+     *
+     * @return
+     */
+    inline bool isOverflowed() {
+        return overflowed;
+    }
+
+    /**
+     * Number of bytes in the line.
+     *
+     * @return
+     */
+    inline unsigned int size() {
+        return length;
+    }
+
+    /**
+     * The line, \0 terminated.
+     *
+     * @return
+     */
+    inline char *c_str() {
+        return buf;
+    }
+};
+
+/**
+ * A literal prefix stored in flash, which keeps its length in its type; see
+ * COMMAND_PREFIX().
+ */
+template<unsigned int LENGTH>
+struct CommandPrefix {
+    const __FlashStringHelper *str;
+
+    explicit CommandPrefix(const __FlashStringHelper *str)
+            : str(str) {
+    }
+};
+
+/**
+ * Stores a literal prefix in flash, the way F() does, for the
+ * StaticCommandBuilder constructor to check its length at compile time.
+ */
+#define COMMAND_PREFIX(literal)         (CommandPrefix<sizeof(literal)>(F(literal)))
+
+/**
+ * A command builder holding its own buffer, to be placed on the stack.
+ *
+ * The buffer size is a template parameter, so a literal prefix which
+ * could never fit is caught at compile time, in flash as well as in RAM:
+ *
+ * StaticCommandBuilder<GPRS_SIM900_MAX_COMMAND_LENGHT> command(COMMAND_PREFIX("AT+CIPSTART="));
+ */
+template<unsigned int SIZE>
+class StaticCommandBuilder: public CommandBuilder {
+
+    char storage[SIZE];
+
+public:
+
+    /**
+     * Public constructor, starting with an empty line.
+     */
+    StaticCommandBuilder()
+            : CommandBuilder(storage, SIZE) {
+    }
+
+    /**
+     * Public constructor, starting with a literal prefix.
+     *
+     * @param prefix        The literal the line starts with.
+     */
+    template<unsigned int LENGTH>
+    StaticCommandBuilder(const char (&prefix)[LENGTH])
+            : CommandBuilder(storage, SIZE) {
+        static_assert(LENGTH + 1 <= SIZE, "Command prefix does not fit in the command builder");
+        append(prefix, LENGTH - 1);
+    }
+
+    /**
+     * Public constructor, starting with a literal prefix stored in flash.
+     *
+     * @param prefix        The literal the line starts with, e.g. COMMAND_PREFIX("AT+CIPSTART=").
+     */
+    template<unsigned int LENGTH>
+    StaticCommandBuilder(CommandPrefix<LENGTH> prefix)
+            : CommandBuilder(storage, SIZE) {
+        static_assert(LENGTH + 1 <= SIZE, "Command prefix does not fit in the command builder");
+        append(prefix.str);
+    }
+
+    /**
+     * Public constructor, starting with a prefix stored in flash whose
+     * length is only known at run time. A prefix which does not fit marks
+     * the builder as overflowed.
+     *
+     * @param prefix        The prefix the line starts with.
+     */
+    StaticCommandBuilder(const __FlashStringHelper *prefix)
+            : CommandBuilder(storage, SIZE) {
+        append(prefix);
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_COMMAND_BUILDER_H__ */
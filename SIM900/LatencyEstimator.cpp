@@ -0,0 +1,85 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LatencyEstimator.cpp
+ *
+ * Timeout of a class of commands learned from their observed latency.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_CPP__
+#define __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_CPP__ 1
+
+#include "LatencyEstimator.h"
+
+LatencyEstimator::LatencyEstimator(unsigned long initial) {
+    reset(initial);
+}
+
+void LatencyEstimator::reset(unsigned long initial, unsigned long minimum, unsigned long maximum) {
+    smoothed = 0;
+    variation = 0;
+    samples = 0;
+    timeout = initial;
+    setBounds(minimum, maximum);
+}
+
+void LatencyEstimator::setBounds(unsigned long minimum, unsigned long maximum) {
+    this->minimum = minimum;
+    this->maximum = maximum < minimum ? minimum : maximum;
+    clamp();
+}
+
+void LatencyEstimator::sample(unsigned long latency) {
+    long delta;
+    if (samples == 0) {
+        smoothed = latency << 3;
+        variation = latency << 1;
+    } else {
+
+        // Scaled so the 1/8 and 1/4 gains are plain additions
+        delta = (long) latency - (long) (smoothed >> 3);
+        smoothed += delta;
+        if (delta < 0) {
+            delta = -delta;
+        }
+        variation += delta - (long) (variation >> 2);
+    }
+    if (samples < 255) {
+        samples++;
+    }
+    timeout = (smoothed >> 3) + variation;
+    clamp();
+}
+
+void LatencyEstimator::backoff() {
+    timeout = timeout > maximum / 2 ? maximum : timeout * 2;
+    clamp();
+}
+
+unsigned long LatencyEstimator::getTimeout() {
+    return timeout;
+}
+
+unsigned long LatencyEstimator::getLatency() {
+    return smoothed >> 3;
+}
+
+unsigned long LatencyEstimator::getVariation() {
+    return variation >> 2;
+}
+
+unsigned char LatencyEstimator::getSamples() {
+    return samples;
+}
+
+void LatencyEstimator::clamp() {
+    if (timeout < minimum) {
+        timeout = minimum;
+    } else if (timeout > maximum) {
+        timeout = maximum;
+    }
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_CPP__ */
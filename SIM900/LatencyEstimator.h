@@ -0,0 +1,132 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * LatencyEstimator.h
+ *
+ * Timeout of a class of commands learned from their observed latency.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_H__
+#define __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_H__ 1
+
+#include <Arduino.h>
+
+#define LATENCY_ESTIMATOR_MIN_TIMEOUT           100UL
+#define LATENCY_ESTIMATOR_MAX_TIMEOUT           60000UL
+
+/**
+ * Smoothed latency and latency variation of a class of commands, kept
+ * like the retransmission timer of TCP (RFC 6298):
+ *
+ * srtt = 7/8 srtt + 1/8 latency
+ * rttvar = 3/4 rttvar + 1/4 |srtt - latency|
+ * timeout = srtt + 4 rttvar
+ *
+ * The timeout is clamped to [minimum, maximum] and doubled every time a
+ * command of the class times out, until the next latency is observed.
+ * Before the first observation the initial timeout is used.
+ */
+class LatencyEstimator {
+
+    /**
+     * Smoothed latency, in 1/8 milliseconds.
+     */
+    unsigned long smoothed;
+
+    /**
+     * Latency variation, in 1/4 milliseconds.
+     */
+    unsigned long variation;
+
+    /**
+     * Current timeout, in milliseconds.
+     */
+    unsigned long timeout;
+
+    /**
+     * Timeout bounds, in milliseconds.
+     */
+    unsigned long minimum;
+    unsigned long maximum;
+
+    /**
+     * Number of latencies observed, saturated at 255.
+     */
+    unsigned char samples;
+
+    /**
+     * Clamps the timeout to its bounds.
+     */
+    void clamp();
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param initial       Timeout used before any latency is observed.
+     */
+    LatencyEstimator(unsigned long initial = LATENCY_ESTIMATOR_MAX_TIMEOUT);
+
+    /**
+     * Forgets the observed latencies.
+     *
+     * @param initial       Timeout used before any latency is observed.
+     * @param minimum       Shortest timeout ever given.
+     * @param maximum       Longest timeout ever given.
+     */
+    void reset(unsigned long initial, unsigned long minimum = LATENCY_ESTIMATOR_MIN_TIMEOUT,
+            unsigned long maximum = LATENCY_ESTIMATOR_MAX_TIMEOUT);
+
+    /**
+     * Changes the timeout bounds, keeping the observed latencies.
+     *
+     * @param minimum       Shortest timeout ever given.
+     * @param maximum       Longest timeout ever given.
+     */
+    void setBounds(unsigned long minimum, unsigned long maximum);
+
+    /**
+     * Takes the latency of a command which got its response.
+     *
+     * @param latency       Time from the command to its response, in milliseconds.
+     */
+    void sample(unsigned long latency);
+
+    /**
+     * Doubles the timeout after a command timed out.
+     */
+    void backoff();
+
+    /**
+     * The timeout to give the next command of the class.
+     *
+     * @return              The timeout, in milliseconds.
+     */
+    unsigned long getTimeout();
+
+    /**
+     * The smoothed latency.
+     *
+     * @return              The latency in milliseconds, 0 if none was observed.
+     */
+    unsigned long getLatency();
+
+    /**
+     * The latency variation.
+     *
+     * @return              The variation in milliseconds.
+     */
+    unsigned long getVariation();
+
+    /**
+     * Number of latencies observed, up to 255.
+     *
+     * @return
+     */
+    unsigned char getSamples();
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_LATENCY_ESTIMATOR_H__ */
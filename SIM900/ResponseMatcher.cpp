@@ -0,0 +1,163 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * ResponseMatcher.cpp
+ *
+ * Single pass matcher of a table of response tokens.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_CPP__
+#define __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_CPP__ 1
+
+#include "ResponseMatcher.h"
+
+ResponseMatcher::ResponseMatcher(const ResponseAutomaton *automaton)
+        : tokens((const ResponseToken *) pgm_read_ptr(&automaton->tokens)),
+          states((const ResponseState *) pgm_read_ptr(&automaton->states)),
+          edges((const ResponseEdge *) pgm_read_ptr(&automaton->edges)) {
+    reset();
+}
+
+void ResponseMatcher::reset() {
+    state = 0;
+    match = RESPONSE_MATCHER_NO_MATCH;
+}
+
+bool ResponseMatcher::feed(unsigned char c) {
+    unsigned char to, token;
+    if (match != RESPONSE_MATCHER_NO_MATCH) {
+        return true;
+    }
+    while ((to = next(states, edges, state, c)) == RESPONSE_MATCHER_NO_MATCH && state != 0) {
+        state = pgm_read_byte(&states[state].fail);
+    }
+    state = to == RESPONSE_MATCHER_NO_MATCH ? 0 : to;
+    token = pgm_read_byte(&states[state].match);
+    if (token != RESPONSE_MATCHER_NO_MATCH) {
+        match = pgm_read_byte(&tokens[token].id);
+    }
+    return match != RESPONSE_MATCHER_NO_MATCH;
+}
+
+bool ResponseMatcher::feed(const char *str) {
+    while (*str != '\0') {
+        if (feed((unsigned char) *str++)) {
+            return true;
+        }
+    }
+    return match != RESPONSE_MATCHER_NO_MATCH;
+}
+
+unsigned char ResponseMatcher::classify(const ResponseAutomaton *automaton, const char *str,
+        unsigned char noMatch) {
+    ResponseMatcher matcher(automaton);
+    return matcher.feed(str) ? matcher.getMatch() : noMatch;
+}
+
+unsigned char ResponseMatcher::rank(const ResponseAutomaton *automaton, const char *str, unsigned char noMatch) {
+    const ResponseToken *tokens = (const ResponseToken *) pgm_read_ptr(&automaton->tokens);
+    const ResponseState *states = (const ResponseState *) pgm_read_ptr(&automaton->states);
+    const ResponseEdge *edges = (const ResponseEdge *) pgm_read_ptr(&automaton->edges);
+    unsigned char state = 0, to, token, found = RESPONSE_MATCHER_NO_MATCH;
+
+    // Goes on past the first match, keeping the token which comes first in the table
+    while (*str != '\0') {
+        while ((to = next(states, edges, state, (unsigned char) *str)) == RESPONSE_MATCHER_NO_MATCH && state != 0) {
+            state = pgm_read_byte(&states[state].fail);
+        }
+        state = to == RESPONSE_MATCHER_NO_MATCH ? 0 : to;
+        token = pgm_read_byte(&states[state].match);
+        if (token < found) {
+            found = token;
+        }
+        str++;
+    }
+    return found == RESPONSE_MATCHER_NO_MATCH ? noMatch : pgm_read_byte(&tokens[found].id);
+}
+
+unsigned char ResponseMatcher::prefix(const ResponseAutomaton *automaton, const char *str) {
+    const ResponseState *states = (const ResponseState *) pgm_read_ptr(&automaton->states);
+    const ResponseEdge *edges = (const ResponseEdge *) pgm_read_ptr(&automaton->edges);
+    unsigned char state = 0, token, found = RESPONSE_MATCHER_NO_MATCH;
+
+    // Each token str starts with ends on the way, the first in the table wins
+    while (*str != '\0') {
+        if ((state = next(states, edges, state, (unsigned char) *str++)) == RESPONSE_MATCHER_NO_MATCH) {
+            break;
+        }
+        token = pgm_read_byte(&states[state].token);
+        if (token < found) {
+            found = token;
+        }
+    }
+    return found;
+}
+
+unsigned char ResponseMatcher::next(const ResponseState *states, const ResponseEdge *edges, unsigned char state,
+        unsigned char c) {
+    const ResponseEdge *edge = edges + pgm_read_byte(&states[state].edges);
+    const ResponseEdge *end = edge + pgm_read_byte(&states[state].edgeCount);
+    unsigned char at;
+    for (; edge < end; edge++) {
+        at = pgm_read_byte(&edge->c);
+        if (at == c) {
+            return pgm_read_byte(&edge->next);
+        }
+        if (at > c) {
+            break;
+        }
+    }
+    return RESPONSE_MATCHER_NO_MATCH;
+}
+
+unsigned char ResponseMatcher::prepare(const char *pattern, bool inFlash, unsigned char *failure,
+        unsigned char size) {
+    unsigned char length, border = 0, c;
+    if (size == 0 || patternAt(pattern, inFlash, 0) == '\0') {
+        return 0;
+    }
+    failure[0] = 0;
+    for (length = 1; length < size && (c = patternAt(pattern, inFlash, length)) != '\0'; length++) {
+        while (border > 0 && patternAt(pattern, inFlash, border) != c) {
+            border = failure[border - 1];
+        }
+        if (patternAt(pattern, inFlash, border) == c) {
+            border++;
+        }
+        failure[length] = border;
+    }
+    return length;
+}
+
+unsigned char ResponseMatcher::advance(const char *pattern, bool inFlash, const unsigned char *failure,
+        unsigned char size, unsigned char matched, unsigned char c) {
+    unsigned char border, k;
+    if (patternAt(pattern, inFlash, 0) == '\0') {
+        return 0;
+    }
+    while (matched > 0 && patternAt(pattern, inFlash, matched) != c) {
+        if (matched <= size) {
+            matched = failure[matched - 1];
+            continue;
+        }
+
+        // Beyond the table, the longest prefix which is also a suffix of what was matched is searched for
+        for (border = matched - 1; border > 0; border--) {
+            for (k = 0; k < border && patternAt(pattern, inFlash, k)
+                    == patternAt(pattern, inFlash, matched - border + k); k++)
+                ;
+            if (k == border) {
+                break;
+            }
+        }
+        matched = border;
+    }
+    if (patternAt(pattern, inFlash, matched) == c) {
+        matched++;
+    }
+    return matched;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_CPP__ */
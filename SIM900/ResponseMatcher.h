@@ -0,0 +1,235 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * ResponseMatcher.h
+ *
+ * Single pass matcher of a table of response tokens.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_H__
+#define __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_H__ 1
+
+#include <Arduino.h>
+
+#define RESPONSE_MATCHER_NO_MATCH               0xff
+
+/**
+ * A token of a response table.
+ *
+ * Tables and the token texts live in flash:
+ *
+ * static const char TOKEN_OK[] PROGMEM = "OK";
+ * static const ResponseToken TOKENS[] PROGMEM = {
+ *     { TOKEN_OK, MY_OK_ID },
+ *     ...
+ * };
+ */
+struct ResponseToken {
+
+    /**
+     * The \0 terminated token, in flash.
+     */
+    const char *text;
+
+    /**
+     * The id reported when the token is matched.
+     */
+    unsigned char id;
+};
+
+/**
+ * A state of an automaton: the bytes of the tokens matched so far.
+ */
+struct ResponseState {
+
+    /**
+     * Its edges, sorted by byte: edgeCount of them from edges.
+     */
+    unsigned char edges;
+    unsigned char edgeCount;
+
+    /**
+     * The state to fall back to on a byte with no edge: the longest
+     * suffix of this state which is a state too.
+     */
+    unsigned char fail;
+
+    /**
+     * Index of the token which ends exactly here, and of the first token
+     * in the table which ends here or at a state along fail,
+     * RESPONSE_MATCHER_NO_MATCH if none.
+     */
+    unsigned char token;
+    unsigned char match;
+};
+
+/**
+ * An edge of an automaton, taken on a byte.
+ */
+struct ResponseEdge {
+    unsigned char c;
+    unsigned char next;
+};
+
+/**
+ * The Aho-Corasick automaton of a token table, generated from it by
+ * "make automata" and kept in flash next to it. State 0 is the start.
+ */
+struct ResponseAutomaton {
+    const ResponseToken *tokens;
+    const ResponseState *states;
+    const ResponseEdge *edges;
+};
+
+/**
+ * Matches the tokens of a table in one pass over the bytes, through its
+ * automaton: a single state is kept, and nothing is built in RAM.
+ */
+class ResponseMatcher {
+
+    /**
+     * The automaton, read from flash.
+     */
+    const ResponseToken *tokens;
+    const ResponseState *states;
+    const ResponseEdge *edges;
+
+    /**
+     * The current state.
+     */
+    unsigned char state;
+
+    /**
+     * Id of the matched token, RESPONSE_MATCHER_NO_MATCH while none.
+     */
+    unsigned char match;
+
+    /**
+     * The state an edge of a state leads to on a byte.
+     *
+     * @return              The next state, RESPONSE_MATCHER_NO_MATCH if the
+     *                      state has no edge on c.
+     */
+    static unsigned char next(const ResponseState *states, const ResponseEdge *edges, unsigned char state,
+            unsigned char c);
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param automaton     The automaton of the token table, in flash.
+     */
+    ResponseMatcher(const ResponseAutomaton *automaton);
+
+    /**
+     * Forgets everything fed so far.
+     */
+    void reset();
+
+    /**
+     * Feeds one byte.
+     *
+     * The first token to be completed wins. If several tokens complete on
+     * the same byte, the one which comes first in the table wins. Once a
+     * token is matched, further bytes are ignored until reset().
+     *
+     * @param c             The received byte.
+     * @return              true if a token is matched.
+     */
+    bool feed(unsigned char c);
+
+    /**
+     * Feeds a \0 terminated string.
+     *
+     * @param str
+     * @return              true if a token is matched.
+     */
+    bool feed(const char *str);
+
+    /**
+     * Id of the matched token.
+     *
+     * @return              The token id, RESPONSE_MATCHER_NO_MATCH if none.
+     */
+    inline unsigned char getMatch() {
+        return match;
+    }
+
+    /**
+     * Classifies a string against a token table in one pass.
+     *
+     * @param automaton     The automaton of the token table, in flash.
+     * @param str           The \0 terminated string.
+     * @param noMatch       Returned when no token is found.
+     * @return              The id of the first token found in str.
+     */
+    static unsigned char classify(const ResponseAutomaton *automaton, const char *str, unsigned char noMatch);
+
+    /**
+     * Classifies a string against a token table in one pass, by the order
+     * of the table rather than of the string, as a chain of strstr() would:
+     * the first token of the table found anywhere in str wins.
+     *
+     * @param automaton     The automaton of the token table, in flash.
+     * @param str           The \0 terminated string.
+     * @param noMatch       Returned when no token is found.
+     * @return              The id of the first token of the table in str.
+     */
+    static unsigned char rank(const ResponseAutomaton *automaton, const char *str, unsigned char noMatch);
+
+    /**
+     * Finds the token a string starts with, following the edges of the
+     * automaton from the start only.
+     *
+     * @param automaton     The automaton of the token table, in flash.
+     * @param str           The \0 terminated string.
+     * @return              Index in the table of the first token str starts
+     *                      with, RESPONSE_MATCHER_NO_MATCH if none.
+     */
+    static unsigned char prefix(const ResponseAutomaton *automaton, const char *str);
+
+    /**
+     * A byte of a pattern held in RAM or in flash.
+     */
+    static inline unsigned char patternAt(const char *pattern, bool inFlash, unsigned char i) {
+        return inFlash ? pgm_read_byte(pattern + i) : (unsigned char) pattern[i];
+    }
+
+    /**
+     * A single pattern known only at run time, like the expectation of a
+     * command, is matched through its failure table instead.
+     *
+     * Computes the failure table of a pattern: for each length matched,
+     * from 1, the length of its longest proper prefix which is also a
+     * suffix of it.
+     *
+     * @param pattern       The \0 terminated pattern.
+     * @param inFlash       If true, the pattern is stored in flash.
+     * @param failure       Where to put the table.
+     * @param size          Its size.
+     * @return              Number of entries computed, the length of the
+     *                      pattern up to size.
+     */
+    static unsigned char prepare(const char *pattern, bool inFlash, unsigned char *failure, unsigned char size);
+
+    /**
+     * Advances a streaming match of a pattern by one byte, falling back
+     * along its failure table on a mismatch, which takes amortized constant
+     * time. Past the table, the fallback is searched for.
+     *
+     * @param pattern       The \0 terminated pattern.
+     * @param inFlash       If true, the pattern is stored in flash.
+     * @param failure       Its failure table, from prepare().
+     * @param size          Number of entries of the table.
+     * @param matched       How many bytes of the pattern were matched so far.
+     * @param c             The received byte.
+     * @return              How many bytes of the pattern are matched now.
+     */
+    static unsigned char advance(const char *pattern, bool inFlash, const unsigned char *failure,
+            unsigned char size, unsigned char matched, unsigned char c);
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_RESPONSE_MATCHER_H__ */
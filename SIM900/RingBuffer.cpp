@@ -0,0 +1,63 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * RingBuffer.cpp
+ *
+ * Lock-free single producer, single consumer byte queue.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RING_BUFFER_CPP__
+#define __ARDUINO_DRIVER_GSM_RING_BUFFER_CPP__ 1
+
+#include "RingBuffer.h"
+
+RingBuffer::RingBuffer(unsigned char *storage, unsigned int capacity)
+        : storage(storage), mask((unsigned char) (capacity - 1)), head(0), tail(0), overflows(0), dropped(0),
+          overflowing(false) {
+}
+
+bool RingBuffer::put(unsigned char c) {
+    unsigned char h = head;
+    unsigned char next = (h + 1) & mask;
+    if (next == tail) {
+        stall();
+        dropped++;
+        return false;
+    }
+    overflowing = false;
+    storage[h] = c;
+
+    // The byte is stored before the consumer can see it
+    head = next;
+    return true;
+}
+
+void RingBuffer::stall() {
+    if (!overflowing) {
+        overflowing = true;
+        overflows++;
+    }
+}
+
+int RingBuffer::get() {
+    unsigned char t = tail;
+    int c;
+    if (t == head) {
+        return -1;
+    }
+    c = storage[t];
+    tail = (t + 1) & mask;
+    return c;
+}
+
+int RingBuffer::peek() {
+    unsigned char t = tail;
+    if (t == head) {
+        return -1;
+    }
+    return storage[t];
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_RING_BUFFER_CPP__ */
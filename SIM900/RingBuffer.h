@@ -0,0 +1,154 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * RingBuffer.h
+ *
+ * Lock-free single producer, single consumer byte queue.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_RING_BUFFER_H__
+#define __ARDUINO_DRIVER_GSM_RING_BUFFER_H__ 1
+
+#include <Arduino.h>
+
+/**
+ * Bytes go in from one context (typically an interrupt) and come out in
+ * another (loop) without disabling interrupts: the producer only writes
+ * head, the consumer only writes tail, and both are single bytes, so
+ * every access is atomic even on AVR. The capacity is a power of two up
+ * to 256, one slot is kept free to tell full from empty.
+ */
+class RingBuffer {
+
+    unsigned char *storage;
+
+    /**
+     * Capacity - 1, to wrap the indexes.
+     */
+    unsigned char mask;
+
+    /**
+     * Where the producer writes next and where the consumer reads next.
+     */
+    volatile unsigned char head;
+    volatile unsigned char tail;
+
+    /**
+     * Times the buffer filled up, and bytes lost because of it. Written
+     * by the producer only.
+     */
+    volatile unsigned int overflows;
+    volatile unsigned int dropped;
+
+    /**
+     * Set while the producer keeps finding the buffer full, so a burst
+     * counts as a single overflow.
+     */
+    bool overflowing;
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param storage       The buffer.
+     * @param capacity      Its size, a power of two up to 256.
+     */
+    RingBuffer(unsigned char *storage, unsigned int capacity);
+
+    /**
+     * Producer side: queues a byte, or drops it if the buffer is full.
+     *
+     * @param c
+     * @return              false if the byte was dropped.
+     */
+    bool put(unsigned char c);
+
+    /**
+     * Producer side: tells if there is no room for another byte.
+     *
+     * @return
+     */
+    inline bool isFull() {
+        return ((head + 1) & mask) == tail;
+    }
+
+    /**
+     * Producer side: counts an overflow which did not lose data, when the
+     * producer can leave the byte where it is (e.g. in the UART buffer).
+     */
+    void stall();
+
+    /**
+     * Consumer side: takes the oldest byte.
+     *
+     * @return              The byte, -1 if empty.
+     */
+    int get();
+
+    /**
+     * Consumer side: the oldest byte, left in the buffer.
+     *
+     * @return              The byte, -1 if empty.
+     */
+    int peek();
+
+    /**
+     * Consumer side: number of bytes queued.
+     *
+     * @return
+     */
+    inline unsigned char available() {
+        return (head - tail) & mask;
+    }
+
+    /**
+     * Consumer side: drops every queued byte.
+     */
+    inline void clear() {
+        tail = head;
+    }
+
+    /**
+     * Times the buffer filled up.
+     *
+     * @return
+     */
+    inline unsigned int getOverflows() {
+        return overflows;
+    }
+
+    /**
+     * Bytes lost because the buffer was full.
+     *
+     * @return
+     */
+    inline unsigned int getDropped() {
+        return dropped;
+    }
+};
+
+/**
+ * A ring buffer holding its own storage.
+ */
+template<unsigned int SIZE>
+class StaticRingBuffer: public RingBuffer {
+
+    static_assert(SIZE >= 2 && SIZE <= 256 && (SIZE & (SIZE - 1)) == 0,
+            "Ring buffer size must be a power of two up to 256");
+
+    unsigned char storage[SIZE];
+
+public:
+
+    /**
+     * Public constructor.
+     */
+    StaticRingBuffer()
+            : RingBuffer(storage, SIZE) {
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_RING_BUFFER_H__ */
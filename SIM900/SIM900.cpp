@@ -13,58 +13,1260 @@
 
 #include <Arduino.h>
 #include "SIM900.h"
+#include "SIM900Tokens.h"
+#include "SIM900Automata.h"
+
+static const char SIM900_FAILURE[] PROGMEM = SIM900_FAILURE_TERMINATOR;
+
+static const char SIM900_DATA_IPD[] PROGMEM = "+IPD,";
+static const char SIM900_DATA_RECEIVE[] PROGMEM = "+RECEIVE,";
+static const char SIM900_DATA_HTTPREAD[] PROGMEM = "+HTTPREAD: ";
+static const char SIM900_DATA_CLOSED[] PROGMEM = "\r\nCLOSED\r\n";
+
+/**
+ * Rates supported by AT+IPR, slowest first.
+ */
+static const uint32_t SIM900_BAUD_RATES[] PROGMEM = {
+    1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200
+};
+
+#ifdef SIM900_STATS
+static const char SIM900_LATENCY_LOCAL[] PROGMEM = "local";
+static const char SIM900_LATENCY_ATTACH[] PROGMEM = "attach";
+static const char SIM900_LATENCY_CONNECT[] PROGMEM = "connect";
+static const char SIM900_LATENCY_SEND[] PROGMEM = "send";
+static const char SIM900_LATENCY_CLOSE[] PROGMEM = "close";
+static const char SIM900_LATENCY_DNS[] PROGMEM = "dns";
+static const char SIM900_LATENCY_STATUS[] PROGMEM = "status";
+static const char SIM900_LATENCY_ACK[] PROGMEM = "ack";
+static const char SIM900_LATENCY_HTTP[] PROGMEM = "http";
+
+static const char * const SIM900_LATENCY_CLASS_NAMES[SIM900_LATENCY_CLASS_COUNT] PROGMEM = {
+    SIM900_LATENCY_LOCAL,
+    SIM900_LATENCY_ATTACH,
+    SIM900_LATENCY_CONNECT,
+    SIM900_LATENCY_SEND,
+    SIM900_LATENCY_CLOSE,
+    SIM900_LATENCY_DNS,
+    SIM900_LATENCY_STATUS,
+    SIM900_LATENCY_ACK,
+    SIM900_LATENCY_HTTP
+};
+#endif
+
+#define SIM900_BAUD_RATE_COUNT                  (sizeof(SIM900_BAUD_RATES) / sizeof(SIM900_BAUD_RATES[0]))
+#define SIM900_FACTORY_BAUD_RATE                9600L
+
+#ifdef SIM900_TRANSPORT_SOFTWARE_SERIAL
 
 SIM900::SIM900(unsigned char receivePin, unsigned char transmitPin)
         : SIM900(receivePin, transmitPin, 0, 0) {
 }
 
 SIM900::SIM900(unsigned char receivePin, unsigned char transmitPin, unsigned char resetPin, unsigned char powerPin)
-        : SoftwareSerialAttentionDevice(receivePin, transmitPin), echo(true), resetPin(resetPin), powerPin(powerPin) {
+        : serial(receivePin, transmitPin), transport(&serial), echo(true), resetPin(resetPin), powerPin(powerPin) {
+    initialize();
+}
+#else
+
+SIM900::SIM900(SIM900Transport *transport)
+        : SIM900(transport, 0, 0) {
+}
+
+SIM900::SIM900(SIM900Transport *transport, unsigned char resetPin, unsigned char powerPin)
+        : transport(transport), echo(true), resetPin(resetPin), powerPin(powerPin) {
+    initialize();
+}
+#endif
+
+void SIM900::initialize() {
+    dataMode = false;
+    closeMatched = closeReleased = closeReleasing = 0;
+    closeByte = -1;
+    sendingFrame = false;
+    connectPending = false;
     pinMode(resetPin, OUTPUT);
     pinMode(powerPin, OUTPUT);
     softResetAndPowerEnabled = !(resetPin == 0 && powerPin == 0);
+    baudRate = SIM900_AUTOBAUD;
+    pulsePin = 0;
+    pulseStartedAt = pulseDuration = 0;
+    startupState = STARTUP_IDLE;
+    startupAttempts = 0;
+    startupStartedAt = startupNextAt = 0;
+    capabilities = 0;
+    for (unsigned char i = 0; i < SIM900_CAPABILITY_COUNT; i++) {
+        capabilityTimes[i] = SIM900_NEVER;
+    }
+    response[0] = '\0';
+    responseLength = 0;
+    commandState = COMMAND_IDLE;
+    commandResult = COMMAND_OK;
+    pendingResult = COMMAND_OK;
+    expectation = NULL;
+    expectationInFlash = false;
+    matcher = NULL;
+    expectationMatched = 0;
+    failureMatched = 0;
+    expectationFailureSize = 0;
+    ResponseMatcher::prepare(SIM900_FAILURE, true, terminatorFailure, sizeof(terminatorFailure));
+    commandStartedAt = waitStartedAt = lastByteAt = 0;
+    commandTimeout = 0;
+    commandCallback = NULL;
+    commandCallbackContext = NULL;
+    lineStart = 0;
+    responseGeneration = 0;
+    memset(urcHandlers, 0, sizeof(urcHandlers));
+    memset(urcContexts, 0, sizeof(urcContexts));
+    dataSink = NULL;
+    dataSinkContext = NULL;
+    payloadBuffer = NULL;
+    payloadRemaining = 0;
+    payloadSkip = 0;
+    httpSink = NULL;
+    httpSinkContext = NULL;
+    payloadHeld = false;
+    for (unsigned char i = 0; i < SIM900_LATENCY_CLASS_COUNT; i++) {
+        latencies[i].reset(SIM900_DEFAULT_COMMAND_TIMEOUT);
+    }
+    latencyClass = SIM900_NO_LATENCY_CLASS;
+#ifdef SIM900_STATS
+    resetStats();
+#endif
 }
 
 SIM900::~SIM900() {
 }
 
 unsigned char SIM900::begin(long bound) {
-    SoftwareSerial::begin(bound);
-    if (sendCommandExpecting("AT", "OK")) {
-        return 1;
+    if (bound != SIM900_AUTOBAUD) {
+        startup(bound);
+        while (startupState == STARTUP_PROBING || startupState == STARTUP_POWERING
+                || startupState == STARTUP_BOOTING) {
+            poll();
+        }
+        if (startupState == STARTUP_FAILED) {
+            return 0;
+        }
+    } else {
+        startup(SIM900_AUTOBAUD);
+        if (!detectBaudRate()) {
+
+            // A modem left on autobauding says nothing after power on until
+            // it sees "AT", so keep probing rather than waiting for Call Ready.
+            softPower();
+            unsigned long start = millis();
+            while (!detectBaudRate()) {
+                if (millis() - start >= SIM900_INITIALIZATION_TIMEOUT) {
+                    baudRate = SIM900_AUTOBAUD;
+                    startupState = STARTUP_FAILED;
+                    return 0;
+                }
+            }
+        }
+        tuneBaudRate(SIM900_TRANSPORT_MAX_BAUD_RATE);
+        setCapability(CAPABILITY_AT, true);
+        startupState = STARTUP_QUERYING;
+        startupNextAt = millis();
+    }
+    while (startupState == STARTUP_QUERYING) {
+        poll();
     }
-    softPower();
-    return (unsigned char) (waitUntilReceive("Call Ready", SIM900_INITIALIZATION_TIMEOUT) >= 0);
+
+    // The caller owns the modem from now on, the reports keep the capabilities up to date
+    if (startupState == STARTUP_WAITING) {
+        startupState = isCapable(CAPABILITY_SIM) && isCapable(CAPABILITY_NETWORK) && isCapable(CAPABILITY_GPRS)
+                ? STARTUP_READY : STARTUP_FOLLOWING;
+    }
+    return 1;
 }
 
-void SIM900::softReset() {
-    if (softResetAndPowerEnabled) {
-        digitalWrite(resetPin, HIGH);
-        delay(100);
-        digitalWrite(resetPin, LOW);
+void SIM900::startup(long bound) {
+    if (bound != SIM900_AUTOBAUD) {
+        baudRate = bound;
+        transport->begin(bound);
+    }
+    capabilities = 0;
+    for (unsigned char i = 0; i < SIM900_CAPABILITY_COUNT; i++) {
+        capabilityTimes[i] = SIM900_NEVER;
+    }
+    startupAttempts = 0;
+    startupStartedAt = startupNextAt = millis();
+    startupState = STARTUP_PROBING;
+}
+
+unsigned long SIM900::getCapabilityTime(unsigned char capability) {
+    return capability < SIM900_CAPABILITY_COUNT ? capabilityTimes[capability] : SIM900_NEVER;
+}
+
+bool SIM900::waitForCapability(unsigned char capability, unsigned long timeout) {
+    unsigned long start = millis();
+    while (!isCapable(capability) && startupState != STARTUP_FAILED && millis() - start < timeout) {
+        poll();
+    }
+    return isCapable(capability);
+}
+
+void SIM900::stepStartup(unsigned long now) {
+    switch (startupState) {
+    case STARTUP_POWERING:
+        if (!isPulsing()) {
+
+            // The boot timeout runs from the moment the modem is powered
+            startupState = STARTUP_BOOTING;
+            startupStartedAt = startupNextAt = now;
+        }
+        return;
+    case STARTUP_BOOTING:
+        if (now - startupStartedAt >= SIM900_INITIALIZATION_TIMEOUT) {
+            startupState = STARTUP_FAILED;
+            return;
+        }
+
+        // no break
+    case STARTUP_PROBING:
+        if ((long) (now - startupNextAt) >= 0) {
+            submitCommand(F("AT"), false, F("OK"), SIM900_STARTUP_PROBE_TIMEOUT, onStartupCommand, this);
+        }
+        return;
+    case STARTUP_QUERYING:
+        if ((long) (now - startupNextAt) >= 0) {
+
+            // Registration changes are reported from now on, the query covers what happened so far
+            submitCommand(F("AT+CREG=1;+CGREG=1;+CPIN?;+CREG?;+CGREG?"), false, F("OK"),
+                    SIM900_DEFAULT_COMMAND_TIMEOUT, onStartupCommand, this);
+        }
+        return;
+    case STARTUP_WAITING:
+        if ((long) (now - startupNextAt) >= 0) {
+            submitCommand(F("AT+CPIN?;+CREG?;+CGREG?"), false, F("OK"), SIM900_DEFAULT_COMMAND_TIMEOUT,
+                    onStartupCommand, this);
+        }
+        return;
+    }
+}
+
+void SIM900::onStartupCommand(SIM900 *sim, unsigned char result, void *context) {
+    unsigned long now = millis();
+    switch (sim->startupState) {
+    case STARTUP_PROBING:
+    case STARTUP_BOOTING:
+        if (result == COMMAND_OK) {
+            sim->setCapability(CAPABILITY_AT, true);
+            sim->startupState = STARTUP_QUERYING;
+            sim->startupNextAt = now;
+        } else if (sim->startupState == STARTUP_PROBING
+                && ++sim->startupAttempts >= SIM900_STARTUP_PROBE_ATTEMPTS) {
+            if (sim->softResetAndPowerEnabled) {
+                sim->softPower();
+                sim->startupState = STARTUP_POWERING;
+            } else {
+
+                // Nothing to power it with, it may still be booting after a brownout
+                sim->startupState = STARTUP_BOOTING;
+                sim->startupNextAt = now;
+            }
+        } else {
+            sim->startupNextAt = now + (sim->startupState == STARTUP_BOOTING ? SIM900_STARTUP_PROBE_INTERVAL : 0);
+        }
+        return;
+    case STARTUP_QUERYING:
+    case STARTUP_WAITING:
+
+        // The reports in the response were observed as they arrived
+        sim->startupState = STARTUP_WAITING;
+        sim->startupNextAt = now + SIM900_STARTUP_QUERY_INTERVAL;
+        sim->setCapability(CAPABILITY_AT, result != COMMAND_TIMEOUT);
+        return;
+    }
+}
+
+void SIM900::observeLine() {
+    const char *line = (const char *) response + lineStart;
+    const char *p;
+    unsigned char status;
+    unsigned char capability = ResponseMatcher::classify(&SIM900_CAPABILITY_AUTOMATON, line,
+            RESPONSE_MATCHER_NO_MATCH);
+    switch (capability) {
+    case CAPABILITY_SIM:
+        setCapability(capability, strstr_P(line, PSTR("READY")) != NULL);
+        break;
+    case CAPABILITY_NETWORK:
+    case CAPABILITY_GPRS:
+
+        // "+CREG: <n>,<stat>[,...]" when queried, "+CREG: <stat>[,<lac>,<ci>]" when reported
+        p = strchr(line, ':') + 2;
+        status = (unsigned char) atoi(p);
+        p = strchr(p, ',');
+        if (p != NULL && p[1] >= '0' && p[1] <= '9') {
+            status = (unsigned char) atoi(p + 1);
+        }
+        setCapability(capability, status == 1 || status == 5);
+        break;
+    case CAPABILITY_CALL_READY:
+        setCapability(capability, true);
+        break;
+    }
+}
+
+void SIM900::setCapability(unsigned char capability, bool usable) {
+    if (!usable) {
+        capabilities &= ~(1 << capability);
+        return;
+    }
+    capabilities |= 1 << capability;
+    if (capabilityTimes[capability] == SIM900_NEVER) {
+        capabilityTimes[capability] = millis() - startupStartedAt;
+    }
+    if ((startupState == STARTUP_WAITING || startupState == STARTUP_FOLLOWING) && isCapable(CAPABILITY_SIM)
+            && isCapable(CAPABILITY_NETWORK) && isCapable(CAPABILITY_GPRS)) {
+        startupState = STARTUP_READY;
+    }
+}
+
+long SIM900::getBaudRate() {
+    return baudRate;
+}
+
+bool SIM900::probeBaudRate(long rate, unsigned char attempts) {
+    transport->begin(rate);
+    baudRate = rate;
+    while (available() > 0) {
+        read();
+    }
+    while (attempts-- > 0) {
+        if (sendCommandExpecting(F("AT"), F("OK"), false, SIM900_AUTOBAUD_PROBE_TIMEOUT)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SIM900::verifyBaudRate(unsigned char rounds) {
+    while (rounds-- > 0) {
+        if (!sendCommandExpecting(F("AT"), F("OK"), false, SIM900_AUTOBAUD_PROBE_TIMEOUT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SIM900::detectBaudRate() {
+    if (probeBaudRate(SIM900_FACTORY_BAUD_RATE, SIM900_AUTOBAUD_PROBE_ATTEMPTS)) {
+        return true;
+    }
+    for (unsigned char i = SIM900_BAUD_RATE_COUNT; i-- > 0;) {
+        long rate = (long) pgm_read_dword(&SIM900_BAUD_RATES[i]);
+        if (rate == SIM900_FACTORY_BAUD_RATE) {
+            continue;
+        }
+        if (probeBaudRate(rate, SIM900_AUTOBAUD_PROBE_ATTEMPTS)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SIM900::tuneBaudRate(long ceiling) {
+    for (unsigned char i = SIM900_BAUD_RATE_COUNT; i-- > 0;) {
+        long rate = (long) pgm_read_dword(&SIM900_BAUD_RATES[i]);
+        if (rate > ceiling) {
+            continue;
+        }
+        if (rate <= baudRate && baudRate <= ceiling) {
+            return;
+        }
+        long previous = baudRate;
+        if (switchBaudRate(rate)) {
+            return;
+        }
+
+        // The modem may have switched and the link is not good enough at
+        // the new rate: ask it to go back, then look for it at the old one.
+        if (!probeBaudRate(previous, 1)) {
+            StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> command(COMMAND_PREFIX("AT+IPR="));
+            command.appendNumber((unsigned long) previous);
+            transport->begin(rate);
+            sendCommandExpecting(&command, F("OK"), SIM900_AUTOBAUD_PROBE_TIMEOUT);
+            if (!probeBaudRate(previous, SIM900_AUTOBAUD_PROBE_ATTEMPTS) && !detectBaudRate()) {
+                return;
+            }
+        }
+    }
+}
+
+bool SIM900::switchBaudRate(long rate) {
+    StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> command(COMMAND_PREFIX("AT+IPR="));
+    command.appendNumber((unsigned long) rate);
+    if (!sendCommandExpecting(&command, F("OK"), SIM900_AUTOBAUD_PROBE_TIMEOUT)) {
+        return false;
+    }
+    transport->begin(rate);
+    baudRate = rate;
+    return verifyBaudRate(SIM900_AUTOBAUD_VERIFY_ROUNDS);
+}
+
+int SIM900::available() {
+#ifndef SIM900_RECEIVE_FROM_ISR
+    service();
+#endif
+
+    // What follows a held back CLOSED may be the rest of that line
+    if (dataMode) {
+        return takeData(false) < 0 ? 0 : closeReleasing - closeReleased + (closeByte >= 0 ? 1 : 0)
+                + receiveBuffer.available();
+    }
+    return receiveBuffer.available();
+}
+
+int SIM900::read() {
+    int c;
+#ifndef SIM900_RECEIVE_FROM_ISR
+    if (receiveBuffer.available() == 0) {
+        service();
+    }
+#endif
+    c = dataMode ? takeData(true) : receiveBuffer.get();
+#ifdef SIM900_STATS
+    if (c >= 0) {
+        stats.bytesRead++;
+    }
+#endif
+    return c;
+}
+
+int SIM900::peek() {
+#ifndef SIM900_RECEIVE_FROM_ISR
+    if (receiveBuffer.available() == 0) {
+        service();
+    }
+#endif
+    return dataMode ? takeData(false) : receiveBuffer.peek();
+}
+
+int SIM900::takeData(bool consume) {
+    unsigned char i;
+    int c;
+    for (;;) {
+        if (closeReleased < closeReleasing) {
+            c = (unsigned char) pgm_read_byte(SIM900_DATA_CLOSED + closeReleased);
+            if (consume) {
+                closeReleased++;
+            }
+            return c;
+        }
+        if (closeByte >= 0) {
+            c = closeByte;
+            if (consume) {
+                closeByte = -1;
+            }
+            return c;
+        }
+        if (!dataMode) {
+            return -1;
+        }
+        c = receiveBuffer.get();
+        if (c < 0) {
+
+            // The modem sends the line at once, a part of it followed by silence is payload
+            if (closeMatched == 0 || millis() - lastByteAt < SIM900_RESPONSE_IDLE_TIMEOUT) {
+                return -1;
+            }
+            closeReleased = 0;
+            closeReleasing = closeMatched;
+            closeMatched = 0;
+            continue;
+        }
+        lastByteAt = millis();
+        if (c == pgm_read_byte(SIM900_DATA_CLOSED + closeMatched)) {
+            closeMatched++;
+            if (pgm_read_byte(SIM900_DATA_CLOSED + closeMatched) != '\0') {
+                continue;
+            }
+
+            // The modem left data mode with the connection, the line is a code again
+            closeMatched = 0;
+            setDataMode(false);
+            for (i = 0; pgm_read_byte(SIM900_DATA_CLOSED + i) != '\0'; i++) {
+                feed(pgm_read_byte(SIM900_DATA_CLOSED + i));
+            }
+            return -1;
+        }
+
+        // The held bytes were payload; a carriage return may start the line again
+        closeReleased = 0;
+        closeReleasing = closeMatched;
+        closeMatched = c == '\r' ? 1 : 0;
+        closeByte = c == '\r' ? -1 : c;
     }
 }
 
+size_t SIM900::write(uint8_t c) {
+#ifdef SIM900_STATS
+    stats.bytesWritten++;
+#endif
+    return transport->SIM900Transport::write(c);
+}
+
+size_t SIM900::write(const uint8_t *buf, size_t len) {
+#ifdef SIM900_STATS
+    stats.bytesWritten += len;
+#endif
+    return transport->SIM900Transport::write(buf, len);
+}
+
+void SIM900::softReset() {
+    pulse(resetPin, SIM900_RESET_PULSE);
+}
+
 void SIM900::softPower() {
+    pulse(powerPin, SIM900_POWER_PULSE);
+}
+
+void SIM900::pulse(unsigned char pin, unsigned long duration) {
     if (softResetAndPowerEnabled) {
-        digitalWrite(powerPin, HIGH);
-        delay(1000);
-        digitalWrite(powerPin, LOW);
+        if (isPulsing()) {
+            digitalWrite(pulsePin, LOW);
+        }
+        digitalWrite(pin, HIGH);
+        pulsePin = pin;
+        pulseStartedAt = millis();
+        pulseDuration = duration;
     }
 }
 
 void SIM900::setEcho(bool echo) {
     this->echo = echo;
-    char command[] = "E0";
-    if (echo) {
-        command[1] = '1';
-    }
-    sendCommand(command, true, 100);
+    sendCommandExpecting(echo ? F("E1") : F("E0"), F("OK"), true);
 }
 
+#ifndef SIM900_NO_CALL
 unsigned char SIM900::disconnect(DisconnectParamter param) {
     // TODO
     return 3;
 }
+#endif
+
+bool SIM900::submitCommand(const char *command, bool appendAT, const char *expectation, unsigned long timeout,
+        SIM900CommandCallback callback, void *context) {
+    StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> builder;
+    if (appendAT) {
+        builder.append(F("AT"));
+    }
+    builder.append(command);
+    return submitCommand(&builder, expectation, timeout, callback, context);
+}
+
+bool SIM900::submitCommand(CommandBuilder *command, const char *expectation, unsigned long timeout,
+        SIM900CommandCallback callback, void *context) {
+    if (!writeCommand(command, timeout, callback, context)) {
+        return !isBusy();
+    }
+    return expect(expectation, false, timeout, callback, context);
+}
+
+bool SIM900::submitCommand(const __FlashStringHelper *command, bool appendAT,
+        const __FlashStringHelper *expectation, unsigned long timeout, SIM900CommandCallback callback,
+        void *context) {
+    StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> builder;
+    if (appendAT) {
+        builder.append(F("AT"));
+    }
+    builder.append(command);
+    return submitCommand(&builder, expectation, timeout, callback, context);
+}
+
+bool SIM900::submitCommand(CommandBuilder *command, const __FlashStringHelper *expectation, unsigned long timeout,
+        SIM900CommandCallback callback, void *context) {
+    if (!writeCommand(command, timeout, callback, context)) {
+        return !isBusy();
+    }
+    return expect((const char *) expectation, true, timeout, callback, context);
+}
+
+bool SIM900::submitCommandMatching(const char *command, bool appendAT, ResponseMatcher *matcher,
+        unsigned long timeout, SIM900CommandCallback callback, void *context) {
+    StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> builder;
+    if (appendAT) {
+        builder.append(F("AT"));
+    }
+    builder.append(command);
+    return submitCommandMatching(&builder, matcher, timeout, callback, context);
+}
+
+bool SIM900::submitCommandMatching(CommandBuilder *command, ResponseMatcher *matcher, unsigned long timeout,
+        SIM900CommandCallback callback, void *context) {
+    if (!writeCommand(command, timeout, callback, context)) {
+        return !isBusy();
+    }
+    return expectTokens(matcher, timeout, callback, context);
+}
+
+bool SIM900::writeCommand(CommandBuilder *command, unsigned long timeout, SIM900CommandCallback callback,
+        void *context) {
+    if (isBusy()) {
+        return false;
+    }
+    responseLength = 0;
+    lineStart = 0;
+    response[0] = '\0';
+    responseGeneration++;
+    commandStartedAt = millis();
+    if (command->isOverflowed()) {
+        arm(timeout, callback, context);
+        complete(COMMAND_TOO_LONG);
+        return false;
+    }
+
+    // The modem would send the command line to the peer
+    if (dataMode) {
+        arm(timeout, callback, context);
+        complete(COMMAND_FAILED);
+        return false;
+    }
+    command->writeTo(this);
+    return true;
+}
+
+bool SIM900::expectResponse(const char *expectation, unsigned long timeout, SIM900CommandCallback callback,
+        void *context) {
+    return expect(expectation, false, timeout, callback, context);
+}
+
+bool SIM900::expectResponse(const __FlashStringHelper *expectation, unsigned long timeout,
+        SIM900CommandCallback callback, void *context) {
+    return expect((const char *) expectation, true, timeout, callback, context);
+}
+
+bool SIM900::expect(const char *expectation, bool inFlash, unsigned long timeout, SIM900CommandCallback callback,
+        void *context) {
+    const char *p;
+    if (!arm(timeout, callback, context)) {
+        return false;
+    }
+    this->expectation = expectation;
+    expectationInFlash = inFlash;
+    if (expectation == NULL) {
+        return true;
+    }
+    expectationFailureSize = ResponseMatcher::prepare(expectation, inFlash, expectationFailure,
+            sizeof(expectationFailure));
+    if (inFlash) {
+        p = strstr_P((const char *) response, expectation);
+        if (p != NULL) {
+            finishReceived(p + strlen_P(expectation));
+        }
+    } else if ((p = strstr((const char *) response, expectation)) != NULL) {
+        finishReceived(p + strlen(expectation));
+    }
+    return true;
+}
+
+bool SIM900::expectTokens(ResponseMatcher *matcher, unsigned long timeout, SIM900CommandCallback callback,
+        void *context) {
+    const char *p = (const char *) response;
+    if (!arm(timeout, callback, context)) {
+        return false;
+    }
+    this->matcher = matcher;
+    matcher->reset();
+    while (*p != '\0') {
+        if (matcher->feed((unsigned char) *p++)) {
+            finishReceived(p);
+            break;
+        }
+    }
+    return true;
+}
+
+bool SIM900::arm(unsigned long timeout, SIM900CommandCallback callback, void *context) {
+    if (isBusy()) {
+        return false;
+    }
+    expectation = NULL;
+    expectationInFlash = false;
+    matcher = NULL;
+    expectationMatched = 0;
+    failureMatched = 0;
+    commandTimeout = timeout;
+    commandCallback = callback;
+    commandCallbackContext = context;
+    commandResult = COMMAND_PENDING;
+    commandState = COMMAND_WAITING;
+    waitStartedAt = lastByteAt = millis();
+    return true;
+}
+
+void SIM900::finishReceived(const char *end) {
+    if (strchr(end, '\n') != NULL) {
+        complete(COMMAND_OK);
+    } else {
+        finish(COMMAND_OK);
+    }
+}
+
+void SIM900::service() {
+    int pending = transport->SIM900Transport::available();
+    while (pending-- > 0) {
+
+        // What does not fit stays in the transport, which may still hold it
+        if (receiveBuffer.isFull()) {
+            receiveBuffer.stall();
+            return;
+        }
+        receiveBuffer.put((unsigned char) transport->SIM900Transport::read());
+    }
+}
+
+void SIM900::poll() {
+    unsigned long now;
+    unsigned char generation;
+    bool busy, idle = !isBusy();
+    int c;
+
+    // Reads even when idle, so unsolicited result codes are always dispatched,
+    // but stops once a command completes so its successor gets what follows
+    for (;;) {
+#ifndef SIM900_RECEIVE_FROM_ISR
+        if (receiveBuffer.available() == 0) {
+            service();
+        }
+#endif
+
+        // In data mode the bytes belong to the connection, up to a peer close
+        if (dataMode) {
+            takeData(false);
+            if (dataMode) {
+                break;
+            }
+        }
+
+        // A payload waits for room in its buffer, unless a response waits behind it
+        if (payloadRemaining > 0 && payloadSkip == 0 && payloadBuffer != NULL && payloadBuffer->isFull()
+                && (!isBusy() || payloadHeld) && receiveBuffer.available() > 0) {
+            payloadBuffer->stall();
+            break;
+        }
+        c = receiveBuffer.get();
+        if (c < 0) {
+            break;
+        }
+        busy = isBusy();
+        generation = responseGeneration;
+        feed((unsigned char) c);
+#ifdef SIM900_STATS
+        stats.bytesRead++;
+#endif
+        if (busy && (!isBusy() || generation != responseGeneration)) {
+            break;
+        }
+    }
+    now = millis();
+    if (isPulsing() && now - pulseStartedAt >= pulseDuration) {
+        digitalWrite(pulsePin, LOW);
+        pulseDuration = 0;
+    }
+    if (!isBusy()) {
+
+        // Not right after a command completed, or waitForCommand() would
+        // return on the startup command instead
+        if (idle && startupState != STARTUP_IDLE && !dataMode && !sendingFrame) {
+            stepStartup(now);
+        }
+        return;
+    }
+    if (commandState == COMMAND_FINISHING) {
+        if (now - lastByteAt >= SIM900_RESPONSE_IDLE_TIMEOUT) {
+            complete(pendingResult);
+        }
+    } else if (expectation == NULL && matcher == NULL && responseLength > 0
+            && now - lastByteAt >= SIM900_RESPONSE_IDLE_TIMEOUT) {
+        complete(COMMAND_OK);
+    } else if (now - waitStartedAt >= commandTimeout) {
+        complete(COMMAND_TIMEOUT);
+    }
+}
+
+void SIM900::setDataMode(bool dataMode) {
+
+    // What was received before is done with, a response must not match it
+    responseLength = 0;
+    lineStart = 0;
+    response[0] = '\0';
+    responseGeneration++;
+    closeMatched = closeReleased = closeReleasing = 0;
+    closeByte = -1;
+    this->dataMode = dataMode;
+}
+
+unsigned char SIM900::waitForCommand() {
+    while (isBusy()) {
+        poll();
+    }
+    return commandResult;
+}
+
+unsigned int SIM900::sendCommand(const char *command, bool appendAT, unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, appendAT, NULL, timeout);
+    waitForCommand();
+    return responseLength;
+}
+
+unsigned int SIM900::sendCommand(CommandBuilder *command, unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, (const char *) NULL, timeout);
+    waitForCommand();
+    return responseLength;
+}
+
+unsigned int SIM900::sendCommand(const __FlashStringHelper *command, bool appendAT, unsigned long timeout) {
+    StaticCommandBuilder<SIM900_MAX_COMMAND_LENGTH> builder;
+    if (appendAT) {
+        builder.append(F("AT"));
+    }
+    builder.append(command);
+    return sendCommand(&builder, timeout);
+}
+
+bool SIM900::sendCommandExpecting(const char *command, const char *expectation, bool appendAT,
+        unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, appendAT, expectation, timeout);
+    return waitForCommand() == COMMAND_OK;
+}
+
+bool SIM900::sendCommandExpecting(CommandBuilder *command, const char *expectation, unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, expectation, timeout);
+    return waitForCommand() == COMMAND_OK;
+}
+
+bool SIM900::sendCommandExpecting(const __FlashStringHelper *command, const __FlashStringHelper *expectation,
+        bool appendAT, unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, appendAT, expectation, timeout);
+    return waitForCommand() == COMMAND_OK;
+}
+
+bool SIM900::sendCommandExpecting(CommandBuilder *command, const __FlashStringHelper *expectation,
+        unsigned long timeout) {
+    waitForCommand();
+    submitCommand(command, expectation, timeout);
+    return waitForCommand() == COMMAND_OK;
+}
+
+bool SIM900::sendBatch(CommandBatch *batch, unsigned long timeout) {
+    unsigned char i, status = CommandBatch::SUCCEEDED;
+    StaticCommandBuilder<COMMAND_BATCH_LINE_LENGTH> command;
+    if (batch->size() == 0 || batch->isOverflowed()) {
+        return false;
+    }
+    if (!sendCommandExpecting(batch->getLine(), F("OK"), timeout)) {
+
+        // The modem stops at the first failure without telling which one it was
+        for (i = 0; i < batch->size(); i++) {
+            batch->setStatus(i, CommandBatch::NOT_RUN);
+        }
+        for (i = 0; i < batch->size() && status == CommandBatch::SUCCEEDED; i++) {
+            command.clear();
+            command.append(F("AT"));
+            command.append(batch->isolate(i));
+            batch->restore();
+            status = sendCommandExpecting(&command, F("OK"), timeout) ? CommandBatch::SUCCEEDED : CommandBatch::FAILED;
+            batch->setStatus(i, status);
+        }
+        return status == CommandBatch::SUCCEEDED;
+    }
+    for (i = 0; i < batch->size(); i++) {
+        batch->setStatus(i, CommandBatch::SUCCEEDED);
+    }
+    return true;
+}
+
+int SIM900::waitUntilReceive(const char *str, unsigned long timeout) {
+    const char *p;
+    waitForCommand();
+    expectResponse(str, timeout);
+    waitForCommand();
+    p = strstr((const char *) response, str);
+    return p == NULL ? -1 : (int) (p - (const char *) response);
+}
+
+int SIM900::waitUntilReceive(const __FlashStringHelper *str, unsigned long timeout) {
+    const char *p;
+    waitForCommand();
+    expectResponse(str, timeout);
+    waitForCommand();
+    p = strstr_P((const char *) response, (const char *) str);
+    return p == NULL ? -1 : (int) (p - (const char *) response);
+}
+
+bool SIM900::doesResponseContains(const char *str) {
+    return strstr((const char *) response, str) != NULL;
+}
+
+bool SIM900::doesResponseContains(const __FlashStringHelper *str) {
+    return strstr_P((const char *) response, (const char *) str) != NULL;
+}
+
+void SIM900::onUnsolicited(unsigned char code, SIM900UrcHandler handler, void *context) {
+    if (code < SIM900_URC_COUNT) {
+        urcHandlers[code] = handler;
+        urcContexts[code] = context;
+    }
+}
+
+void SIM900::onData(SIM900DataSink sink, void *context) {
+    dataSink = sink;
+    dataSinkContext = context;
+}
+
+void SIM900::onHttpData(SIM900DataSink sink, void *context) {
+    httpSink = sink;
+    httpSinkContext = context;
+}
+
+void SIM900::measureLatency(unsigned char latencyClass) {
+    this->latencyClass = latencyClass < SIM900_LATENCY_CLASS_COUNT ? latencyClass : SIM900_NO_LATENCY_CLASS;
+}
+
+unsigned long SIM900::getTimeout(unsigned char latencyClass) {
+    if (latencyClass >= SIM900_LATENCY_CLASS_COUNT) {
+        return SIM900_DEFAULT_COMMAND_TIMEOUT;
+    }
+    return latencies[latencyClass].getTimeout();
+}
+
+LatencyEstimator *SIM900::getLatencyEstimator(unsigned char latencyClass) {
+    return latencyClass < SIM900_LATENCY_CLASS_COUNT ? &latencies[latencyClass] : NULL;
+}
+
+void SIM900::recordLatency(unsigned char latencyClass, unsigned char result, unsigned long latency) {
+    if (latencyClass >= SIM900_LATENCY_CLASS_COUNT) {
+        return;
+    }
+#ifdef SIM900_STATS
+    record(latencyClass, result, latency);
+#endif
+    if (result == COMMAND_TIMEOUT) {
+        latencies[latencyClass].backoff();
+    } else {
+        latencies[latencyClass].sample(latency);
+    }
+}
+
+void SIM900::feed(unsigned char c) {
+    lastByteAt = millis();
+    if (payloadRemaining > 0) {
+        receivePayload(c);
+        return;
+    }
+    if (responseLength >= SIM900_RESPONSE_BUFFER_SIZE - 1 && commandState == COMMAND_IDLE && lineStart > 0) {
+
+        // Nobody waits for what is before the current line, make room for it
+        responseLength -= lineStart;
+        memmove(response, response + lineStart, responseLength + 1);
+        lineStart = 0;
+    }
+    if (responseLength < SIM900_RESPONSE_BUFFER_SIZE - 1) {
+        response[responseLength++] = c;
+        response[responseLength] = '\0';
+#ifdef SIM900_STATS
+        if (responseLength > stats.responseHighWater) {
+            stats.responseHighWater = responseLength;
+        }
+    } else {
+        stats.responseOverflows++;
+#endif
+    }
+    if (c == ':' && takeDataHeader()) {
+        return;
+    }
+    if (c == '\n' && takeHttpHeader()) {
+        return;
+    }
+    if (c == '\n') {
+        observeLine();
+        if (dispatchUnsolicited()) {
+
+            // The expected line can be a code too, like CONNECT after ATA
+            if (commandState == COMMAND_FINISHING) {
+                complete(pendingResult);
+            }
+            return;
+        }
+        lineStart = responseLength;
+    }
+    if (commandState == COMMAND_IDLE) {
+        return;
+    }
+    if (commandState == COMMAND_FINISHING) {
+        if (c == '\n') {
+            complete(pendingResult);
+        }
+        return;
+    }
+    failureMatched = ResponseMatcher::advance(SIM900_FAILURE, true, terminatorFailure, sizeof(terminatorFailure),
+            failureMatched, c);
+    if (matcher != NULL && matcher->feed(c)) {
+        finish(COMMAND_OK);
+        return;
+    }
+    if (expectation != NULL) {
+        expectationMatched = ResponseMatcher::advance(expectation, expectationInFlash, expectationFailure,
+                expectationFailureSize, expectationMatched, c);
+        if (ResponseMatcher::patternAt(expectation, expectationInFlash, expectationMatched) == '\0') {
+            finish(COMMAND_OK);
+            return;
+        }
+    }
+    if (failureMatched == sizeof(SIM900_FAILURE) - 1) {
+        finish(COMMAND_FAILED);
+    }
+}
+
+bool SIM900::takeDataHeader() {
+    const char *line = (const char *) response + lineStart;
+    const char *p;
+    char *end;
+    char connection = -1;
+    unsigned char skip = 0;
+    unsigned long length;
+    if (strncmp_P(line, SIM900_DATA_IPD, sizeof(SIM900_DATA_IPD) - 1) == 0) {
+        p = line + sizeof(SIM900_DATA_IPD) - 1;
+    } else if (strncmp_P(line, SIM900_DATA_RECEIVE, sizeof(SIM900_DATA_RECEIVE) - 1) == 0) {
+
+        // +RECEIVE,<n>,<len>: ends with a line break before the payload
+        p = line + sizeof(SIM900_DATA_RECEIVE) - 1;
+        if (p[0] < '0' || p[0] > '7' || p[1] != ',') {
+            return false;
+        }
+        connection = p[0] - '0';
+        p += 2;
+        skip = 2;
+    } else {
+        return false;
+    }
+    length = strtoul(p, &end, 10);
+    if (end == p || *end != ':') {
+        return false;
+    }
+    responseLength = lineStart;
+    response[responseLength] = '\0';
+    payloadBuffer = dataSink != NULL ? dataSink(this, connection, (unsigned int) length, dataSinkContext) : NULL;
+    payloadRemaining = (unsigned int) length;
+    payloadSkip = skip;
+    payloadHeld = false;
+    return true;
+}
+
+bool SIM900::takeHttpHeader() {
+    const char *line = (const char *) response + lineStart;
+    const char *p = line + sizeof(SIM900_DATA_HTTPREAD) - 1;
+    char *end;
+    unsigned long length;
+    if (strncmp_P(line, SIM900_DATA_HTTPREAD, sizeof(SIM900_DATA_HTTPREAD) - 1) != 0) {
+        return false;
+    }
+    length = strtoul(p, &end, 10);
+    if (end == p || (*end != '\r' && *end != '\n')) {
+        return false;
+    }
+    responseLength = lineStart;
+    response[responseLength] = '\0';
+    payloadBuffer = httpSink != NULL ? httpSink(this, -1, (unsigned int) length, httpSinkContext) : NULL;
+    payloadRemaining = (unsigned int) length;
+    payloadSkip = 0;
+    payloadHeld = true;
+    return true;
+}
+
+void SIM900::receivePayload(unsigned char c) {
+    if (payloadSkip > 0) {
+        payloadSkip--;
+        if (c == '\r' || c == '\n') {
+            return;
+        }
+        payloadSkip = 0;
+    }
+    if (payloadBuffer != NULL) {
+        payloadBuffer->put(c);
+    }
+    payloadRemaining--;
+}
+
+bool SIM900::dispatchUnsolicited() {
+    char *line = (char *) response + lineStart;
+    char connection = -1;
+    unsigned char token, code, generation;
+    unsigned int end = responseLength;
+    while (end > lineStart && (response[end - 1] == '\n' || response[end - 1] == '\r')) {
+        end--;
+    }
+    if (end == lineStart) {
+        return false;
+    }
+
+    // In multi-IP mode some codes are prefixed by the connection number: "<n>, CLOSED"
+    if (line[0] >= '0' && line[0] <= '7' && line[1] == ',' && line[2] == ' ') {
+        connection = line[0] - '0';
+        line += 3;
+    }
+    token = ResponseMatcher::prefix(&SIM900_URC_AUTOMATON, line);
+    if (token == RESPONSE_MATCHER_NO_MATCH) {
+        return false;
+    }
+    code = pgm_read_byte(&SIM900_URC_TOKENS[token].id);
+#ifdef SIM900_NO_CALL
+    if (code == URC_RING) {
+        return false;
+    }
+#endif
+#ifdef SIM900_NO_SMS
+    if (code == URC_NEW_MESSAGE) {
+        return false;
+    }
+#endif
+
+    // A bare CONNECT answers the command, like ATA, unless a transparent connection is awaited
+    if (code == URC_CONNECT) {
+        if (pgm_read_ptr(&SIM900_URC_TOKENS[token].text) == SIM900_URC_CONNECT && !connectPending) {
+            return false;
+        }
+        connectPending = false;
+    }
+
+    // The result of a frame answers AT+CIPSEND, unless frames go back to back
+    if (code == URC_SEND && !sendingFrame) {
+        return false;
+    }
+    generation = responseGeneration;
+    response[end] = '\0';
+    if (urcHandlers[code] != NULL) {
+        urcHandlers[code](this, code, connection, line, urcContexts[code]);
+    }
+
+    // Peels the line out of the response, unless the handler started a new command
+    if (generation == responseGeneration) {
+        responseLength = lineStart;
+        response[responseLength] = '\0';
+    }
+    return true;
+}
+
+void SIM900::finish(unsigned char result) {
+    unsigned char last;
+    if (result == COMMAND_OK && expectation != NULL) {
+        if (expectationInFlash) {
+            last = pgm_read_byte(expectation + strlen_P(expectation) - 1);
+        } else {
+            last = (unsigned char) expectation[strlen(expectation) - 1];
+        }
+        if (last == '>' || last == ' ') {
+            complete(result);
+            return;
+        }
+    }
+    pendingResult = result;
+    commandState = COMMAND_FINISHING;
+}
+
+void SIM900::complete(unsigned char result) {
+    SIM900CommandCallback callback = commandCallback;
+    unsigned long latency = lastByteAt - commandStartedAt;
+#ifdef SIM900_STATS
+    if (result != COMMAND_TOO_LONG) {
+        record(latencyClass == SIM900_NO_LATENCY_CLASS ? (unsigned char) LATENCY_LOCAL : latencyClass, result, latency);
+    }
+#endif
+    if (latencyClass != SIM900_NO_LATENCY_CLASS) {
+        if (result == COMMAND_TIMEOUT) {
+            latencies[latencyClass].backoff();
+        } else if (result == COMMAND_OK || result == COMMAND_FAILED) {
+            latencies[latencyClass].sample(latency);
+        }
+        latencyClass = SIM900_NO_LATENCY_CLASS;
+    }
+    commandState = COMMAND_IDLE;
+    commandResult = result;
+    commandCallback = NULL;
+    if (callback != NULL) {
+        callback(this, result, commandCallbackContext);
+    }
+}
+
+#ifdef SIM900_STATS
+
+void SIM900::record(unsigned char latencyClass, unsigned char result, unsigned long latency) {
+    SIM900CommandStats *command = &stats.commands[latencyClass];
+    command->count++;
+    if (result == COMMAND_TIMEOUT) {
+        command->timeouts++;
+        return;
+    }
+    if (result == COMMAND_FAILED) {
+        command->failures++;
+    }
+    if (command->count - command->timeouts == 1 || latency < command->minLatency) {
+        command->minLatency = latency;
+    }
+    if (latency > command->maxLatency) {
+        command->maxLatency = latency;
+    }
+    command->totalLatency += latency;
+}
+
+void SIM900::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void SIM900::getStats(SIM900Stats *snapshot) {
+    noInterrupts();
+    memcpy(snapshot, &stats, sizeof(stats));
+    snapshot->receiveOverflows = receiveBuffer.getOverflows();
+    snapshot->receiveDropped = receiveBuffer.getDropped();
+    interrupts();
+}
+
+void SIM900::dumpStats(Print *out) {
+    SIM900Stats snapshot;
+    SIM900CommandStats *command;
+    unsigned int answered;
+    getStats(&snapshot);
+    for (unsigned char i = 0; i < SIM900_LATENCY_CLASS_COUNT; i++) {
+        command = &snapshot.commands[i];
+        if (command->count == 0) {
+            continue;
+        }
+        answered = command->count - command->timeouts;
+        out->print((const __FlashStringHelper *) pgm_read_ptr(&SIM900_LATENCY_CLASS_NAMES[i]));
+        out->print(F(" n="));
+        out->print(command->count);
+        out->print(F(" err="));
+        out->print(command->failures);
+        out->print(F(" tmo="));
+        out->print(command->timeouts);
+        out->print(F(" min="));
+        out->print(command->minLatency);
+        out->print(F(" avg="));
+        out->print(answered == 0 ? 0UL : command->totalLatency / answered);
+        out->print(F(" max="));
+        out->println(command->maxLatency);
+    }
+    out->print(F("tx="));
+    out->print(snapshot.bytesWritten);
+    out->print(F(" rx="));
+    out->print(snapshot.bytesRead);
+    out->print(F(" hw="));
+    out->print(snapshot.responseHighWater);
+    out->print(F(" drop="));
+    out->print(snapshot.responseOverflows);
+    out->print(F(" ovf="));
+    out->print(snapshot.receiveOverflows);
+    out->print(F(" lost="));
+    out->println(snapshot.receiveDropped);
+}
+#endif
 
 #endif /* __ARDUINO_DRIVER_GSM_SIM900_CPP__ */
@@ -12,18 +12,204 @@
 #define __ARDUINO_DRIVER_GSM_SIM900_H__ 1
 
 #include <Arduino.h>
-#include <SoftwareSerialAttentionDevice.h>
 #include <string.h>
+#include "SIM900Transport.h"
+#include "ResponseMatcher.h"
+#include "CommandBatch.h"
+#include "CommandBuilder.h"
+#include "LatencyEstimator.h"
+#include "RingBuffer.h"
 
 #define SIM900_INITIALIZATION_TIMEOUT           10000UL
+#define SIM900_DEFAULT_COMMAND_TIMEOUT          1000UL
+#define SIM900_RESPONSE_IDLE_TIMEOUT            50UL
+#ifndef SIM900_RESPONSE_BUFFER_SIZE
+#define SIM900_RESPONSE_BUFFER_SIZE             128
+#endif
 
-class SIM900: public SoftwareSerialAttentionDevice {
+#ifndef SIM900_MAX_COMMAND_LENGTH
+#define SIM900_MAX_COMMAND_LENGTH               64
+#endif
+
+#define SIM900_FAILURE_TERMINATOR               "ERROR"
+
+/**
+ * Bytes of an expectation matched through its failure table, the rest the
+ * slow way.
+ */
+#ifndef SIM900_EXPECTATION_FAILURE_SIZE
+#define SIM900_EXPECTATION_FAILURE_SIZE         16
+#endif
+#define SIM900_URC_COUNT                        12
+#define SIM900_LATENCY_CLASS_COUNT              9
+#define SIM900_NO_LATENCY_CLASS                 0xff
+#define SIM900_STARTUP_PROBE_TIMEOUT            200UL
+#define SIM900_STARTUP_PROBE_ATTEMPTS           3
+#define SIM900_STARTUP_PROBE_INTERVAL           500UL
+#define SIM900_STARTUP_QUERY_INTERVAL           2000UL
+#define SIM900_RESET_PULSE                      100UL
+#define SIM900_POWER_PULSE                      1000UL
+#define SIM900_CAPABILITY_COUNT                 5
+#define SIM900_NEVER                            0xffffffffUL
+#define SIM900_AUTOBAUD                         0L
+#define SIM900_AUTOBAUD_PROBE_TIMEOUT           200UL
+#define SIM900_AUTOBAUD_PROBE_ATTEMPTS          3
+#define SIM900_AUTOBAUD_VERIFY_ROUNDS           3
+
+#ifndef SIM900_RECEIVE_BUFFER_SIZE
+#define SIM900_RECEIVE_BUFFER_SIZE              64
+#endif
+
+class SIM900;
+
+/**
+ * Completion callback of an asynchronous command.
+ *
+ * @param sim           The modem which ran the command.
+ * @param result        One of SIM900::CommandResult.
+ * @param context       The opaque pointer given when the command was submitted.
+ */
+typedef void (*SIM900CommandCallback)(SIM900 *sim, unsigned char result, void *context);
+
+/**
+ * Handler of an unsolicited result code.
+ *
+ * Called from poll(), even while a command is running, so it must not
+ * submit commands itself; set a flag and act on it from loop().
+ *
+ * @param sim           The modem which received the code.
+ * @param code          One of SIM900::UnsolicitedResultCode.
+ * @param connection    The connection number in multi-IP mode, -1 otherwise.
+ * @param line          The whole line, without the connection number.
+ * @param context       The opaque pointer given when the handler was registered.
+ */
+typedef void (*SIM900UrcHandler)(SIM900 *sim, unsigned char code, char connection, const char *line, void *context);
+
+/**
+ * Destination of the payload announced by a data header, +IPD,<len>: or
+ * +RECEIVE,<n>,<len>:.
+ *
+ * Called from poll() once per header; the payload bytes then go straight
+ * to the returned buffer, never through the response.
+ *
+ * @param sim           The modem which received the header.
+ * @param connection    The connection number in multi-IP mode, -1 otherwise.
+ * @param length        Length of the payload.
+ * @param context       The opaque pointer given when the sink was registered.
+ * @return              The buffer, NULL to drop the payload.
+ */
+typedef RingBuffer *(*SIM900DataSink)(SIM900 *sim, char connection, unsigned int length, void *context);
+
+#ifdef SIM900_STATS
+
+/**
+ * Counters of one class of commands, see SIM900::LatencyClass.
+ *
+ * Each wait for a response counts once: a command with an intermediate
+ * response, like AT+CIPSTART (OK, then CONNECT OK), counts its OK under
+ * LATENCY_LOCAL and its final response under its own class.
+ */
+struct SIM900CommandStats {
+
+    /**
+     * Waits completed, answered or not.
+     */
+    unsigned int count;
+
+    /**
+     * Waits answered with ERROR, and waits which timed out.
+     */
+    unsigned int failures;
+    unsigned int timeouts;
+
+    /**
+     * Latency of the answered waits, from the command to the end of its
+     * response, in milliseconds. The average is total / (count - timeouts).
+     */
+    unsigned long minLatency;
+    unsigned long maxLatency;
+    unsigned long totalLatency;
+};
+
+/**
+ * Counters of the modem, kept when the library is built with SIM900_STATS.
+ */
+struct SIM900Stats {
+    SIM900CommandStats commands[SIM900_LATENCY_CLASS_COUNT];
+
+    /**
+     * Bytes written to and read from the transport.
+     */
+    unsigned long bytesWritten;
+    unsigned long bytesRead;
+
+    /**
+     * Most bytes the response buffer ever held, and bytes dropped because
+     * it was full.
+     */
+    unsigned int responseHighWater;
+    unsigned int responseOverflows;
+
+    /**
+     * Overflows of the receive buffer, and bytes it lost, see RingBuffer.
+     * Filled by SIM900::getStats().
+     */
+    unsigned int receiveOverflows;
+    unsigned int receiveDropped;
+};
+#endif
+
+class SIM900: public Stream {
+
+#ifdef SIM900_TRANSPORT_SOFTWARE_SERIAL
+
+    /**
+     * The software serial port, owned by the modem.
+     */
+    SoftwareSerial serial;
+#endif
+
+    /**
+     * The serial transport to the modem.
+     */
+    SIM900Transport *transport;
 
     /**
      * Using echo.
      */
     bool echo;
 
+    /**
+     * The modem relays the bytes to and from a connection instead of
+     * taking commands (transparent mode).
+     */
+    bool dataMode;
+
+    /**
+     * In data mode, bytes of the CLOSED line of a peer close held back
+     * from read() while they match it, then those handed out after all
+     * once the line turned out to be payload (from closeReleased to
+     * closeReleasing, and closeByte).
+     */
+    unsigned char closeMatched;
+    unsigned char closeReleased;
+    unsigned char closeReleasing;
+    int closeByte;
+
+    /**
+     * A frame is on its way, from the prompt of its AT+CIPSEND to its
+     * SEND OK: the modem would take a command as payload, then answers
+     * the frame in the middle of whatever follows, so its SEND OK is
+     * URC_SEND.
+     */
+    bool sendingFrame;
+
+    /**
+     * A transparent connection is being opened or resumed: the next bare
+     * CONNECT is URC_CONNECT rather than part of a response.
+     */
+    bool connectPending;
+
     /**
      * Soft reset pin.
      */
@@ -39,7 +225,495 @@ class SIM900: public SoftwareSerialAttentionDevice {
      */
     bool softResetAndPowerEnabled;
 
-public:
+    /**
+     * Baud rate the transport is running at.
+     */
+    long baudRate;
+
+    /**
+     * Pin being pulsed, when the pulse started and how long it lasts,
+     * 0 if no pulse is running.
+     */
+    unsigned char pulsePin;
+    unsigned long pulseStartedAt;
+    unsigned long pulseDuration;
+
+    /**
+     * Startup state, one of StartupState, failed probes in a row, when
+     * the startup (or the boot after a power pulse) began and when the
+     * next startup command is due.
+     */
+    unsigned char startupState;
+    unsigned char startupAttempts;
+    unsigned long startupStartedAt;
+    unsigned long startupNextAt;
+
+    /**
+     * Capabilities usable now, one bit per Capability, and when each was
+     * first usable, in milliseconds since the startup began.
+     */
+    unsigned char capabilities;
+    unsigned long capabilityTimes[SIM900_CAPABILITY_COUNT];
+
+    /**
+     * Response of the last command, always \0 terminated.
+     */
+    unsigned char response[SIM900_RESPONSE_BUFFER_SIZE];
+
+    /**
+     * Number of bytes in the response buffer.
+     */
+    unsigned int responseLength;
+
+    /**
+     * State of the command engine, one of CommandState.
+     */
+    unsigned char commandState;
+
+    /**
+     * Result of the last command, one of CommandResult.
+     */
+    unsigned char commandResult;
+
+    /**
+     * Result the command will finish with once its line ends.
+     */
+    unsigned char pendingResult;
+
+    /**
+     * Terminator which completes the command, NULL when the response
+     * is open-ended and ends after SIM900_RESPONSE_IDLE_TIMEOUT of silence,
+     * and whether it is stored in flash.
+     */
+    const char *expectation;
+    bool expectationInFlash;
+
+    /**
+     * Token table which completes the command, used instead of the expectation.
+     */
+    ResponseMatcher *matcher;
+
+    /**
+     * How many bytes of the expectation and of the failure terminator
+     * were matched so far.
+     */
+    unsigned char expectationMatched;
+    unsigned char failureMatched;
+
+    /**
+     * The failure tables of the expectation, with its number of entries,
+     * and of the failure terminator.
+     */
+    unsigned char expectationFailure[SIM900_EXPECTATION_FAILURE_SIZE];
+    unsigned char expectationFailureSize;
+    unsigned char terminatorFailure[sizeof(SIM900_FAILURE_TERMINATOR) - 1];
+
+    /**
+     * Time the command was submitted, time the current expectation was
+     * armed and time the last byte arrived.
+     */
+    unsigned long commandStartedAt;
+    unsigned long waitStartedAt;
+    unsigned long lastByteAt;
+
+    /**
+     * Maximum time to wait for the terminator.
+     */
+    unsigned long commandTimeout;
+
+    /**
+     * Completion callback and its context.
+     */
+    SIM900CommandCallback commandCallback;
+    void *commandCallbackContext;
+
+    /**
+     * Where the line being received starts in the response.
+     */
+    unsigned int lineStart;
+
+    /**
+     * Changes every time the response is cleared for a new command.
+     */
+    unsigned char responseGeneration;
+
+    /**
+     * Handlers of unsolicited result codes and their contexts.
+     */
+    SIM900UrcHandler urcHandlers[SIM900_URC_COUNT];
+    void *urcContexts[SIM900_URC_COUNT];
+
+    /**
+     * Destination of the received payloads and its context, then the
+     * buffer the payload being received goes to, how many of its bytes
+     * are still to come, and how many line end bytes before it to skip.
+     */
+    SIM900DataSink dataSink;
+    void *dataSinkContext;
+    RingBuffer *payloadBuffer;
+    unsigned int payloadRemaining;
+    unsigned char payloadSkip;
+
+    /**
+     * Destination of the AT+HTTPREAD payloads and its context, and whether
+     * the payload being received is one: the command waits for its own
+     * payload, so that one is held back instead of dropped when its buffer
+     * is full.
+     */
+    SIM900DataSink httpSink;
+    void *httpSinkContext;
+    bool payloadHeld;
+
+    /**
+     * Latency of each class of commands, and the class the running
+     * command is measured into, SIM900_NO_LATENCY_CLASS if none.
+     */
+    LatencyEstimator latencies[SIM900_LATENCY_CLASS_COUNT];
+    unsigned char latencyClass;
+
+    /**
+     * Bytes received from the transport and not parsed yet. service() (or
+     * receive(), from an interrupt) fills it, poll() and read() drain it.
+     */
+    StaticRingBuffer<SIM900_RECEIVE_BUFFER_SIZE> receiveBuffer;
+
+#ifdef SIM900_STATS
+
+    /**
+     * Instrumentation counters.
+     */
+    SIM900Stats stats;
+
+    /**
+     * Counts a completed wait into the stats of its class.
+     */
+    void record(unsigned char latencyClass, unsigned char result, unsigned long latency);
+#endif
+
+    /**
+     * Feeds one received byte to the command engine.
+     *
+     * @param c             The received byte.
+     */
+    void feed(unsigned char c);
+
+    /**
+     * Clears the response and writes the command line in a single burst.
+     * A command which did not fit its builder is not written and completes
+     * right away with COMMAND_TOO_LONG.
+     *
+     * @return              true if the command was written.
+     */
+    bool writeCommand(CommandBuilder *command, unsigned long timeout, SIM900CommandCallback callback, void *context);
+
+    /**
+     * Starts waiting for a terminator.
+     *
+     * @return              false if another command is still running.
+     */
+    bool arm(unsigned long timeout, SIM900CommandCallback callback, void *context);
+
+    /**
+     * Finishes a command whose terminator is already in the response.
+     *
+     * @param end           Where the terminator ends in the response.
+     */
+    void finishReceived(const char *end);
+
+    /**
+     * Sets up pins and the command engine, shared by the constructors.
+     */
+    void initialize();
+
+    /**
+     * Raises a pin for a while; poll() lowers it.
+     */
+    void pulse(unsigned char pin, unsigned long duration);
+
+    /**
+     * Submits the next startup command when it is due. Runs from poll()
+     * only when no command is running.
+     */
+    void stepStartup(unsigned long now);
+
+    /**
+     * Moves the startup on when one of its commands completes.
+     */
+    static void onStartupCommand(SIM900 *sim, unsigned char result, void *context);
+
+    /**
+     * Looks for SIM, registration and Call Ready reports in the line just
+     * received, solicited or not.
+     */
+    void observeLine();
+
+    /**
+     * Marks a capability as usable or not.
+     */
+    void setCapability(unsigned char capability, bool usable);
+
+    /**
+     * Opens the transport at the given rate and sends "AT" until the modem
+     * answers OK, at most the given number of times.
+     *
+     * @return              true if the modem answered.
+     */
+    bool probeBaudRate(long rate, unsigned char attempts);
+
+    /**
+     * Sends "AT" the given number of times.
+     *
+     * @return              true if the modem answered OK to every one.
+     */
+    bool verifyBaudRate(unsigned char rounds);
+
+    /**
+     * Finds the rate the modem is running at, trying 9600 bps, its factory
+     * rate, first and then every supported rate from the fastest down,
+     * even the ones above SIM900_TRANSPORT_MAX_BAUD_RATE.
+     *
+     * @return              true if the modem answered at some rate.
+     */
+    bool detectBaudRate();
+
+    /**
+     * Moves the modem and the transport to the fastest rate, up to the
+     * given one, which passes SIM900_AUTOBAUD_VERIFY_ROUNDS round trips.
+     * A modem found above the ceiling is brought down to it. If a rate
+     * fails after the modem switched, the previous one is restored, or
+     * detected again.
+     *
+     * @param ceiling       The fastest rate to try.
+     */
+    void tuneBaudRate(long ceiling);
+
+    /**
+     * Tells the modem to switch to the given rate, with AT+IPR, and moves
+     * the transport along.
+     *
+     * @return              true if the modem answered at the new rate.
+     */
+    bool switchBaudRate(long rate);
+
+    /**
+     * Checks the line being received, up to its ':', for a data header.
+     * A header is removed from the response and starts its payload.
+     *
+     * @return              true if the line was a data header.
+     */
+    bool takeDataHeader();
+
+    /**
+     * Checks the line just received for the header of AT+HTTPREAD,
+     * +HTTPREAD: <len>, whose payload starts on the next line.
+     *
+     * @return              true if the line was the header.
+     */
+    bool takeHttpHeader();
+
+    /**
+     * Hands one byte of a payload to its buffer.
+     *
+     * @param c             The received byte.
+     */
+    void receivePayload(unsigned char c);
+
+    /**
+     * Data mode side of read() and peek(): the next byte of the connection,
+     * with a CLOSED line of a peer close taken out. That line leaves data
+     * mode and goes to the command engine instead.
+     *
+     * @param consume       If the byte is taken rather than peeked.
+     * @return              The byte, -1 if none.
+     */
+    int takeData(bool consume);
+
+    /**
+     * Checks the line just received against the unsolicited result codes.
+     * A known code is handed to its handler and removed from the response.
+     *
+     * @return              true if the line was an unsolicited result code.
+     */
+    bool dispatchUnsolicited();
+
+    /**
+     * Finishes the running command once the line of the terminator ends.
+     * Prompts (an expectation ending in '>' or ' ') finish right away since
+     * the modem never ends their line.
+     *
+     * @param result        One of CommandResult.
+     */
+    void finish(unsigned char result);
+
+    /**
+     * Finishes the running command and notifies the callback.
+     *
+     * @param result        One of CommandResult.
+     */
+    void complete(unsigned char result);
+
+    /**
+     * Arms the wait for an expectation held in RAM or in flash.
+     *
+     * @see expectResponse(const char *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool expect(const char *expectation, bool inFlash, unsigned long timeout, SIM900CommandCallback callback,
+            void *context);
+
+public:
+
+    enum CommandState {
+        COMMAND_IDLE = 0,
+
+        // Waiting for the expectation or the failure terminator
+        COMMAND_WAITING = 1,
+
+        // A terminator was received, collecting the rest of its line
+        COMMAND_FINISHING = 2
+    };
+
+    enum UnsolicitedResultCode {
+
+        // Incoming call
+        URC_RING = 0,
+
+        // New SMS message stored: +CMTI: <mem>,<index>
+        URC_NEW_MESSAGE = 1,
+
+        // The TCP/UDP connection was closed: [<n>, ]CLOSED
+        URC_CLOSED = 2,
+
+        // The GPRS context was deactivated by the network
+        URC_PDP_DEACT = 3,
+
+        // Data arrived in manual receive mode: +CIPRXGET: 1[,<n>]
+        URC_DATA_AVAILABLE = 4,
+
+        // The modem finished its initialization
+        URC_CALL_READY = 5,
+
+        // The modem is powering down
+        URC_POWER_DOWN = 6,
+
+        // The supply voltage is out of range
+        URC_UNDER_VOLTAGE = 7,
+
+        // A TCP/UDP connection was set up or not: [<n>, ]CONNECT OK, [<n>, ]CONNECT FAIL,
+        // or CONNECT in transparent mode, see setConnectPending()
+        URC_CONNECT = 8,
+
+        // A name was resolved or not: +CDNSGIP: 1,"<name>","<ip>" or +CDNSGIP: 0,<error>
+        URC_DNS = 9,
+
+        // The HTTP request of the built-in stack ended: +HTTPACTION: <method>,<status>,<length>
+        URC_HTTP_ACTION = 10,
+
+        // A frame was sent or not: [<n>, ]SEND OK, [<n>, ]SEND FAIL or DATA ACCEPT:[<n>,]<length>,
+        // only while a frame is on its way, see setSendingFrame()
+        URC_SEND = 11
+    };
+
+    enum StartupState {
+
+        // startup() was not called
+        STARTUP_IDLE = 0,
+
+        // Sending AT, in case the modem is already running
+        STARTUP_PROBING = 1,
+
+        // Holding the power pin
+        STARTUP_POWERING = 2,
+
+        // Sending AT while the modem boots
+        STARTUP_BOOTING = 3,
+
+        // The modem answers, turning registration reports on
+        STARTUP_QUERYING = 4,
+
+        // Waiting for the SIM and the registrations
+        STARTUP_WAITING = 5,
+
+        // SIM ready, registered on the network and attached to GPRS
+        STARTUP_READY = 6,
+
+        // The modem did not answer within SIM900_INITIALIZATION_TIMEOUT
+        STARTUP_FAILED = 7,
+
+        // begin() returned: no more queries, the reports alone are followed
+        STARTUP_FOLLOWING = 8
+    };
+
+    enum Capability {
+
+        // The modem answers AT commands
+        CAPABILITY_AT = 0,
+
+        // +CPIN: READY
+        CAPABILITY_SIM = 1,
+
+        // +CREG: registered, home or roaming
+        CAPABILITY_NETWORK = 2,
+
+        // +CGREG: attached, home or roaming
+        CAPABILITY_GPRS = 3,
+
+        // Call Ready
+        CAPABILITY_CALL_READY = 4
+    };
+
+    enum CommandResult {
+
+        // The command is still running
+        COMMAND_PENDING = 0,
+
+        // The expectation was received, or the open-ended response ended
+        COMMAND_OK = 1,
+
+        // The modem answered with an error
+        COMMAND_FAILED = 2,
+
+        // Nothing conclusive was received in time
+        COMMAND_TIMEOUT = 3,
+
+        // Another command is still running
+        COMMAND_BUSY = 4,
+
+        // The command did not fit its builder and was not sent
+        COMMAND_TOO_LONG = 5
+    };
+
+    /**
+     * Classes of commands whose latency is learned, see measureLatency().
+     */
+    enum LatencyClass {
+
+        // Answered by the modem itself
+        LATENCY_LOCAL = 0,
+
+        // GPRS attach, AT+CIICR
+        LATENCY_ATTACH = 1,
+
+        // Connection set up, AT+CIPSTART
+        LATENCY_CONNECT = 2,
+
+        // Data acknowledged by the modem, SEND OK
+        LATENCY_SEND = 3,
+
+        // Connection tear down, AT+CIPCLOSE
+        LATENCY_CLOSE = 4,
+
+        // Name resolution, AT+CDNSGIP
+        LATENCY_DNS = 5,
+
+        // Connection status, AT+CIPSTATUS
+        LATENCY_STATUS = 6,
+
+        // Data acknowledged by the peer, AT+CIPACK
+        LATENCY_ACK = 7,
+
+        // Request of the built-in HTTP stack, AT+HTTPACTION
+        LATENCY_HTTP = 8
+    };
 
     enum DisconnectParamter {
 
@@ -75,6 +749,8 @@ public:
         ALL_WAITING_ON_CHANNEL = 5
     };
 
+#ifdef SIM900_TRANSPORT_SOFTWARE_SERIAL
+
     /**
      * Public constructor.
      * 
@@ -88,6 +764,24 @@ public:
      * @param serial
      */
     SIM900(unsigned char receivePin, unsigned char transmitPin, unsigned char resetPin, unsigned char powerPin);
+#else
+
+    /**
+     * Public constructor.
+     *
+     * @param transport     The serial transport to the modem.
+     */
+    SIM900(SIM900Transport *transport);
+
+    /**
+     * Public constructor.
+     *
+     * @param transport     The serial transport to the modem.
+     * @param resetPin      Soft reset pin.
+     * @param powerPin      Soft power on/off pin.
+     */
+    SIM900(SIM900Transport *transport, unsigned char resetPin, unsigned char powerPin);
+#endif
 
     /**
      * Virtual destructor.
@@ -95,23 +789,151 @@ public:
     virtual ~SIM900();
 
     /**
-     * Initializes the device.
+     * Initializes the device, returning once the modem answers AT and the
+     * registration reports are turned on and queried. From then on the
+     * SIM, network and GPRS capabilities follow the unsolicited reports;
+     * no startup command runs behind the caller's back.
+     *
+     * With SIM900_AUTOBAUD the rate the modem is running at is detected,
+     * then the link is upgraded to the fastest rate, up to
+     * SIM900_TRANSPORT_MAX_BAUD_RATE, that passes a few AT round trips.
+     * The rate in use is given by getBaudRate().
      * 
-     * @param           The bound rate to be used.
+     * @param           The bound rate to be used, or SIM900_AUTOBAUD.
      * @return          0 if not success, > 0 otherwise.
      */
     unsigned char begin(long bound);
 
     /**
-     * Soft controlled Reset
+     * Starts the modem without blocking; poll() drives the rest.
+     *
+     * An already running modem is found with a few quick AT probes. If it
+     * does not answer, it is powered up through the power pin, held
+     * without delay(), and probed while it boots. Once it answers,
+     * registration reports are turned on and the SIM, network and GPRS
+     * states are followed, from solicited and unsolicited reports alike,
+     * with a query every SIM900_STARTUP_QUERY_INTERVAL for what is still
+     * missing. The startup never runs a command while another is running,
+     * in data mode or within a frame (see setSendingFrame()), but a
+     * command submitted while it runs one finds the modem busy.
+     *
+     * @param bound         The baud rate to be used.
+     */
+    void startup(long bound);
+
+    /**
+     * The startup state.
+     *
+     * @return              One of StartupState.
+     */
+    inline unsigned char getStartupState() {
+        return startupState;
+    }
+
+    /**
+     * Tells if a capability is usable now.
+     *
+     * @param capability    One of Capability.
+     * @return
+     */
+    inline bool isCapable(unsigned char capability) {
+        return (capabilities & (1 << capability)) != 0;
+    }
+
+    /**
+     * When a capability was first usable.
+     *
+     * @param capability    One of Capability.
+     * @return              Milliseconds since the startup began, SIM900_NEVER if not yet.
+     */
+    unsigned long getCapabilityTime(unsigned char capability);
+
+    /**
+     * Polls until a capability is usable.
+     *
+     * @param capability    One of Capability.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              true if the capability is usable.
+     */
+    bool waitForCapability(unsigned char capability, unsigned long timeout);
+
+    /**
+     * The baud rate of the link to the modem.
+     *
+     * @return              The rate, SIM900_AUTOBAUD before begin().
+     */
+    long getBaudRate();
+
+    /**
+     * Number of bytes received and not parsed yet.
+     *
+     * @return
+     */
+    virtual int available();
+
+    /**
+     * Reads a received byte, bypassing the command engine.
+     *
+     * @return              The byte, -1 if none.
+     */
+    virtual int read();
+
+    /**
+     * Peeks a received byte.
+     *
+     * @return              The byte, -1 if none.
+     */
+    virtual int peek();
+
+    /**
+     * Writes a byte to the transport.
+     *
+     * @param c
+     * @return              Number of bytes written.
+     */
+    virtual size_t write(uint8_t c);
+
+    /**
+     * Writes bytes to the transport.
+     *
+     * @param buf
+     * @param len
+     * @return              Number of bytes written.
+     */
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    using Print::write;
+
+    /**
+     * The serial transport to the modem.
+     *
+     * @return
+     */
+    inline SIM900Transport *getTransport() {
+        return transport;
+    }
+
+    /**
+     * Soft controlled Reset, a SIM900_RESET_PULSE on the reset pin.
+     * Returns right away, poll() ends the pulse.
      */
     void softReset();
 
     /**
-     * Soft controlled Power on/off
+     * Soft controlled Power on/off, a SIM900_POWER_PULSE on the power pin.
+     * Returns right away, poll() ends the pulse.
      */
     void softPower();
 
+    /**
+     * Tells if a reset or power pulse is running.
+     *
+     * @return
+     */
+    inline bool isPulsing() {
+        return pulseDuration != 0;
+    }
+
     /**
      * Configures echo mode
      * 
@@ -119,7 +941,479 @@ public:
      */
     void setEcho(bool echo);
 
+#ifndef SIM900_NO_CALL
     unsigned char disconnect(DisconnectParamter param);
+#endif
+
+    /**
+     * Submits a command without waiting for its response.
+     *
+     * The command is written right away and the response is collected
+     * by poll(), which must be called often (e.g. from loop()). When the
+     * expectation arrives, the modem answers with an error or the timeout
+     * expires, the callback is called with the CommandResult. The rest of
+     * the line holding the terminator is kept in the response, so it can
+     * be parsed by the callback.
+     *
+     * @param command       The command, without line terminator, at most
+     *                      SIM900_MAX_COMMAND_LENGTH - 2 bytes long with the AT.
+     * @param appendAT      If true, "AT" is written before the command.
+     * @param expectation   The response terminator or NULL for an open-ended response.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @param callback      Called on completion, may be NULL.
+     * @param context       Given back to the callback.
+     * @return              false if another command is still running.
+     */
+    bool submitCommand(const char *command, bool appendAT, const char *expectation, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Submits a command line built with a CommandBuilder, including its AT.
+     *
+     * @see submitCommand(const char *, bool, const char *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool submitCommand(CommandBuilder *command, const char *expectation, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Submits a command whose text and expectation are stored in flash,
+     * e.g. submitCommand(F("+CIPSHUT"), true, F("SHUT OK"), timeout).
+     *
+     * @see submitCommand(const char *, bool, const char *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool submitCommand(const __FlashStringHelper *command, bool appendAT, const __FlashStringHelper *expectation,
+            unsigned long timeout, SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Submits a command line built with a CommandBuilder, waiting for an
+     * expectation stored in flash.
+     *
+     * @see submitCommand(const char *, bool, const char *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool submitCommand(CommandBuilder *command, const __FlashStringHelper *expectation, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Keeps collecting the response of the last command until a new
+     * expectation arrives. The response received so far is kept.
+     *
+     * @param expectation   The response terminator.
+     * @param timeout       Maximum time to wait from now, in milliseconds.
+     * @param callback      Called on completion, may be NULL.
+     * @param context       Given back to the callback.
+     * @return              false if another command is still running.
+     */
+    bool expectResponse(const char *expectation, unsigned long timeout, SIM900CommandCallback callback = NULL,
+            void *context = NULL);
+
+    /**
+     * Keeps collecting the response until an expectation stored in flash.
+     *
+     * @see expectResponse(const char *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool expectResponse(const __FlashStringHelper *expectation, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Submits a command completed by any token of a table.
+     *
+     * Works like submitCommand(), the matched token id is read from
+     * the matcher once the command completes.
+     *
+     * @param command       The command, without line terminator.
+     * @param appendAT      If true, "AT" is written before the command.
+     * @param matcher       The token matcher, must outlive the command.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @param callback      Called on completion, may be NULL.
+     * @param context       Given back to the callback.
+     * @return              false if another command is still running.
+     */
+    bool submitCommandMatching(const char *command, bool appendAT, ResponseMatcher *matcher, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Submits a command line built with a CommandBuilder, completed by
+     * any token of a table.
+     *
+     * @see submitCommandMatching(const char *, bool, ResponseMatcher *, unsigned long, SIM900CommandCallback, void *)
+     */
+    bool submitCommandMatching(CommandBuilder *command, ResponseMatcher *matcher, unsigned long timeout,
+            SIM900CommandCallback callback = NULL, void *context = NULL);
+
+    /**
+     * Keeps collecting the response of the last command until any token
+     * of a table arrives. The response received so far is kept and
+     * matched first.
+     *
+     * @param matcher       The token matcher, must outlive the command.
+     * @param timeout       Maximum time to wait from now, in milliseconds.
+     * @param callback      Called on completion, may be NULL.
+     * @param context       Given back to the callback.
+     * @return              false if another command is still running.
+     */
+    bool expectTokens(ResponseMatcher *matcher, unsigned long timeout, SIM900CommandCallback callback = NULL,
+            void *context = NULL);
+
+    /**
+     * Registers the handler of an unsolicited result code.
+     *
+     * Codes are recognized at any time poll() runs, even in the middle of
+     * a command, and are removed from the response before the command
+     * sees them.
+     *
+     * @param code          One of UnsolicitedResultCode.
+     * @param handler       The handler, NULL to just drop the code.
+     * @param context       Given back to the handler.
+     */
+    void onUnsolicited(unsigned char code, SIM900UrcHandler handler, void *context = NULL);
+
+    /**
+     * Registers the destination of received TCP/UDP payloads.
+     *
+     * The data headers are recognized at any time poll() runs, even in the
+     * middle of a command. Without a sink the payloads are dropped, so
+     * they never show up in a response. While no command runs, a payload
+     * whose buffer is full waits in the receive buffer (and then in the
+     * transport) until it is read; while a command waits, what does not
+     * fit is dropped, so the response behind it still arrives.
+     *
+     * @param sink          The sink, NULL to drop the payloads.
+     * @param context       Given back to the sink.
+     */
+    void onData(SIM900DataSink sink, void *context = NULL);
+
+    /**
+     * Registers the destination of the payloads read from the built-in
+     * HTTP stack, +HTTPREAD: <len>. The sink is given -1 as connection.
+     *
+     * Unlike a TCP/UDP payload, one whose buffer is full is never dropped:
+     * it waits, even while AT+HTTPREAD waits for it, so the buffer has to
+     * be drained while the command runs.
+     *
+     * @param sink          The sink, NULL to drop the payloads.
+     * @param context       Given back to the sink.
+     */
+    void onHttpData(SIM900DataSink sink, void *context = NULL);
+
+    /**
+     * Measures the next command to complete into a latency class.
+     *
+     * The latency runs from the moment the command was written to the
+     * moment its response ended, so a command whose final response comes
+     * after an intermediate one (an OK, then CONNECT OK) is measured by
+     * calling this before waiting for the final one. A timeout backs the
+     * class off instead.
+     *
+     * @param latencyClass  One of LatencyClass.
+     */
+    void measureLatency(unsigned char latencyClass);
+
+    /**
+     * The timeout learned for a class of commands.
+     *
+     * @param latencyClass  One of LatencyClass.
+     * @return              The timeout, in milliseconds.
+     */
+    unsigned long getTimeout(unsigned char latencyClass);
+
+    /**
+     * The estimator of a class of commands, to change its bounds.
+     *
+     * @param latencyClass  One of LatencyClass.
+     * @return              The estimator, NULL if there is no such class.
+     */
+    LatencyEstimator *getLatencyEstimator(unsigned char latencyClass);
+
+    /**
+     * Takes the latency of a wait which did not end with a command, such as
+     * one ended by an unsolicited result code, as a command would.
+     *
+     * @param latencyClass  One of LatencyClass.
+     * @param result        COMMAND_OK, COMMAND_FAILED or COMMAND_TIMEOUT.
+     * @param latency       From the start of the wait, in milliseconds.
+     */
+    void recordLatency(unsigned char latencyClass, unsigned char result, unsigned long latency);
+
+#ifdef SIM900_STATS
+
+    /**
+     * Copies the instrumentation counters, to be sent upstream as is.
+     * The receive path may update them from an interrupt, so they are
+     * copied with interrupts disabled, no counter torn halfway.
+     *
+     * @param snapshot      Where to copy them.
+     */
+    void getStats(SIM900Stats *snapshot);
+
+    /**
+     * Zeroes the instrumentation counters.
+     */
+    void resetStats();
+
+    /**
+     * Prints the counters, one line per class of commands which ran:
+     *
+     * connect n=3 err=0 tmo=1 min=310 avg=325 max=340
+     * tx=1820 rx=2410 hw=96 drop=0 ovf=0 lost=0
+     *
+     * @param out           Where to print, e.g. &Serial.
+     */
+    void dumpStats(Print *out);
+#endif
+
+    /**
+     * Moves the bytes waiting in the transport to the receive buffer, and
+     * stops, leaving the rest in the transport, when it is full.
+     *
+     * poll() calls it, but it can also run from a timer interrupt to keep
+     * the UART from overrunning while loop() is busy elsewhere; then
+     * define SIM900_RECEIVE_FROM_ISR so it has a single caller.
+     */
+    void service();
+
+    /**
+     * Queues a byte received by a custom UART interrupt handler. Define
+     * SIM900_RECEIVE_FROM_ISR when using it.
+     *
+     * @param c             The received byte.
+     * @return              false if the receive buffer was full and the
+     *                      byte was lost.
+     */
+    inline bool receive(unsigned char c) {
+        return receiveBuffer.put(c);
+    }
+
+    /**
+     * The receive buffer, for its overflow counters.
+     *
+     * @return
+     */
+    inline RingBuffer *getReceiveBuffer() {
+        return &receiveBuffer;
+    }
+
+    /**
+     * Advances the command engine with the bytes received so far and
+     * dispatches the unsolicited result codes among them.
+     *
+     * Never blocks.
+     */
+    void poll();
+
+    /**
+     * Tells if a command is still waiting for its response.
+     *
+     * @return
+     */
+    inline bool isBusy() {
+        return commandState != COMMAND_IDLE;
+    }
+
+    /**
+     * Restarts the timeout of the command waiting for its response, for a
+     * response which keeps coming but is held back by its reader, like a
+     * long payload going to a slow sink.
+     */
+    inline void restartTimeout() {
+        waitStartedAt = millis();
+    }
+
+    /**
+     * Tells if a payload is being received, or waits for room in its buffer.
+     *
+     * @return
+     */
+    inline bool isReceivingPayload() {
+        return payloadRemaining > 0;
+    }
+
+    /**
+     * Tells the driver the modem entered or left data mode. In data mode
+     * poll() leaves the received bytes to read(), and commands fail.
+     * A CLOSED line in the data is taken as the peer closing: the modem
+     * is back in command mode, and the line is dispatched as URC_CLOSED.
+     * Bytes which may start that line are held back from read() until it
+     * is told apart, at worst for SIM900_RESPONSE_IDLE_TIMEOUT.
+     *
+     * @param dataMode
+     */
+    void setDataMode(bool dataMode);
+
+    /**
+     * Tells if the modem is in data mode.
+     *
+     * @return
+     */
+    inline bool isInDataMode() {
+        return dataMode;
+    }
+
+    /**
+     * Tells the driver a frame is on its way, from the prompt of
+     * AT+CIPSEND to its SEND OK (DATA ACCEPT in quick send mode), pieces
+     * of it written between polls. The startup holds its queries
+     * meanwhile, and SEND OK, SEND FAIL and DATA ACCEPT are dispatched as
+     * URC_SEND, so the next frame can be asked for before they come. Any
+     * other time they are left in the response of the command.
+     *
+     * @param sendingFrame
+     */
+    inline void setSendingFrame(bool sendingFrame) {
+        this->sendingFrame = sendingFrame;
+    }
+
+    /**
+     * Tells the driver a transparent connection is being opened or
+     * resumed, so the bare CONNECT which ends it is dispatched as
+     * URC_CONNECT. Any other time a bare CONNECT is left in the response
+     * of the command, like the one of ATA. The next URC_CONNECT clears it.
+     *
+     * @param connectPending
+     */
+    inline void setConnectPending(bool connectPending) {
+        this->connectPending = connectPending;
+    }
+
+    /**
+     * Result of the last command.
+     *
+     * @return              One of CommandResult.
+     */
+    inline unsigned char getCommandResult() {
+        return commandResult;
+    }
+
+    /**
+     * Polls until the running command completes.
+     *
+     * @return              One of CommandResult.
+     */
+    unsigned char waitForCommand();
+
+    /**
+     * Sends a command and collects its open-ended response.
+     *
+     * @param command       The command, without line terminator.
+     * @param appendAT      If true, "AT" is written before the command.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              The number of bytes received.
+     */
+    unsigned int sendCommand(const char *command = "", bool appendAT = false, unsigned long timeout =
+            SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command line built with a CommandBuilder and collects its
+     * open-ended response.
+     *
+     * @param command       The command line, including its AT.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              The number of bytes received.
+     */
+    unsigned int sendCommand(CommandBuilder *command, unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command stored in flash and collects its open-ended response.
+     *
+     * @see sendCommand(const char *, bool, unsigned long)
+     */
+    unsigned int sendCommand(const __FlashStringHelper *command, bool appendAT = false, unsigned long timeout =
+            SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command and waits for the expectation.
+     *
+     * @param command       The command, without line terminator.
+     * @param expectation   The response terminator.
+     * @param appendAT      If true, "AT" is written before the command.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              true if the expectation was received.
+     */
+    bool sendCommandExpecting(const char *command, const char *expectation, bool appendAT = false,
+            unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command line built with a CommandBuilder and waits for the
+     * expectation.
+     *
+     * @param command       The command line, including its AT.
+     * @param expectation   The response terminator.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              true if the expectation was received.
+     */
+    bool sendCommandExpecting(CommandBuilder *command, const char *expectation,
+            unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command and waits for the expectation, both stored in flash.
+     *
+     * @see sendCommandExpecting(const char *, const char *, bool, unsigned long)
+     */
+    bool sendCommandExpecting(const __FlashStringHelper *command, const __FlashStringHelper *expectation,
+            bool appendAT = false, unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends a command line built with a CommandBuilder and waits for an
+     * expectation stored in flash.
+     *
+     * @see sendCommandExpecting(CommandBuilder *, const char *, unsigned long)
+     */
+    bool sendCommandExpecting(CommandBuilder *command, const __FlashStringHelper *expectation,
+            unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Sends all commands of a batch in a single command line.
+     *
+     * If the modem answers OK, every command succeeded. Otherwise the
+     * commands are run again one by one, to find out which one failed;
+     * the ones after it are not run. The status of each command is kept
+     * in the batch.
+     *
+     * @param batch         The batch to be sent.
+     * @param timeout       Maximum time to wait for each line, in milliseconds.
+     * @return              true if every command succeeded.
+     */
+    bool sendBatch(CommandBatch *batch, unsigned long timeout = SIM900_DEFAULT_COMMAND_TIMEOUT);
+
+    /**
+     * Waits until the response contains the given string.
+     *
+     * @param str           The string to wait for.
+     * @param timeout       Maximum time to wait, in milliseconds.
+     * @return              The position of str in the response, -1 if not received.
+     */
+    int waitUntilReceive(const char *str, unsigned long timeout);
+
+    /**
+     * Waits until the response contains a string stored in flash.
+     *
+     * @see waitUntilReceive(const char *, unsigned long)
+     */
+    int waitUntilReceive(const __FlashStringHelper *str, unsigned long timeout);
+
+    /**
+     * Tells if the last response contains the given string.
+     *
+     * @param str
+     * @return
+     */
+    bool doesResponseContains(const char *str);
+
+    /**
+     * Tells if the last response contains a string stored in flash.
+     *
+     * @param str
+     * @return
+     */
+    bool doesResponseContains(const __FlashStringHelper *str);
+
+    /**
+     * The last response, \0 terminated.
+     *
+     * @return
+     */
+    inline unsigned char *getLastResponse() {
+        return response;
+    }
 
     /*
      void getProductIdentificationInformation();
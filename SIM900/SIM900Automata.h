@@ -0,0 +1,367 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * SIM900Automata.h
+ *
+ * Automata of the token tables of SIM900Tokens.h, generated by
+ * "make automata". Do not edit.
+ *
+ * A state is { first edge, edges, fail, token, match }.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_SIM900_AUTOMATA_H__
+#define __ARDUINO_DRIVER_GSM_SIM900_AUTOMATA_H__ 1
+
+#include "SIM900Tokens.h"
+
+/**
+ * 16 tokens of SIM900_URC_TOKENS, 130 states.
+ */
+static_assert(sizeof(SIM900_URC_TOKENS) / sizeof(ResponseToken) == 16,
+        "SIM900_URC_TOKENS changed, run make automata");
+
+static const ResponseState SIM900_URC_STATES[] PROGMEM = {
+    { 0, 7, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 0 "" */
+    { 7, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 1 "R" */
+    { 8, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 2 "RI" */
+    { 9, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 3 "RIN" */
+    { 10, 0, 0, 0, 0 }, /* 4 "RING" */
+    { 10, 3, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 5 "+" */
+    { 13, 3, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 6 "+C" */
+    { 16, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 7 "+CM" */
+    { 17, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 8 "+CMT" */
+    { 18, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 9 "+CMTI" */
+    { 19, 0, 0, 1, 1 }, /* 10 "+CMTI:" */
+    { 19, 3, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 11 "C" */
+    { 22, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 12 "CL" */
+    { 23, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 13 "CLO" */
+    { 24, 1, 107, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 14 "CLOS" */
+    { 25, 1, 108, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 15 "CLOSE" */
+    { 26, 0, 118, 2, 2 }, /* 16 "CLOSED" */
+    { 26, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 17 "+P" */
+    { 27, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 18 "+PD" */
+    { 28, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 19 "+PDP" */
+    { 29, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 20 "+PDP:" */
+    { 30, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 21 "+PDP: " */
+    { 31, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 22 "+PDP: D" */
+    { 32, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 23 "+PDP: DE" */
+    { 33, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 24 "+PDP: DEA" */
+    { 34, 1, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 25 "+PDP: DEAC" */
+    { 35, 0, 0, 3, 3 }, /* 26 "+PDP: DEACT" */
+    { 35, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 27 "+CI" */
+    { 36, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 28 "+CIP" */
+    { 37, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 29 "+CIPR" */
+    { 38, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 30 "+CIPRX" */
+    { 39, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 31 "+CIPRXG" */
+    { 40, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 32 "+CIPRXGE" */
+    { 41, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 33 "+CIPRXGET" */
+    { 42, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 34 "+CIPRXGET:" */
+    { 43, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 35 "+CIPRXGET: " */
+    { 44, 0, 0, 4, 4 }, /* 36 "+CIPRXGET: 1" */
+    { 44, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 37 "Ca" */
+    { 45, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 38 "Cal" */
+    { 46, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 39 "Call" */
+    { 47, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 40 "Call " */
+    { 48, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 41 "Call R" */
+    { 49, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 42 "Call Re" */
+    { 50, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 43 "Call Rea" */
+    { 51, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 44 "Call Read" */
+    { 52, 0, 0, 5, 5 }, /* 45 "Call Ready" */
+    { 52, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 46 "N" */
+    { 53, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 47 "NO" */
+    { 54, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 48 "NOR" */
+    { 55, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 49 "NORM" */
+    { 56, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 50 "NORMA" */
+    { 57, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 51 "NORMAL" */
+    { 58, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 52 "NORMAL " */
+    { 59, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 53 "NORMAL P" */
+    { 60, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 54 "NORMAL PO" */
+    { 61, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 55 "NORMAL POW" */
+    { 62, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 56 "NORMAL POWE" */
+    { 63, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 57 "NORMAL POWER" */
+    { 64, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 58 "NORMAL POWER " */
+    { 65, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 59 "NORMAL POWER D" */
+    { 66, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 60 "NORMAL POWER DO" */
+    { 67, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 61 "NORMAL POWER DOW" */
+    { 68, 0, 46, 6, 6 }, /* 62 "NORMAL POWER DOWN" */
+    { 68, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 63 "U" */
+    { 69, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 64 "UN" */
+    { 70, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 65 "UND" */
+    { 71, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 66 "UNDE" */
+    { 72, 1, 1, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 67 "UNDER" */
+    { 73, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 68 "UNDER-" */
+    { 74, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 69 "UNDER-V" */
+    { 75, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 70 "UNDER-VO" */
+    { 76, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 71 "UNDER-VOL" */
+    { 77, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 72 "UNDER-VOLT" */
+    { 78, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 73 "UNDER-VOLTA" */
+    { 79, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 74 "UNDER-VOLTAG" */
+    { 80, 0, 0, 7, 7 }, /* 75 "UNDER-VOLTAGE" */
+    { 80, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 76 "CO" */
+    { 81, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 77 "CON" */
+    { 82, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 78 "CONN" */
+    { 83, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 79 "CONNE" */
+    { 84, 1, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 80 "CONNEC" */
+    { 85, 1, 0, 10, 10 }, /* 81 "CONNECT" */
+    { 86, 2, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 82 "CONNECT " */
+    { 88, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 83 "CONNECT O" */
+    { 89, 0, 0, 8, 8 }, /* 84 "CONNECT OK" */
+    { 89, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 85 "CONNECT F" */
+    { 90, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 86 "CONNECT FA" */
+    { 91, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 87 "CONNECT FAI" */
+    { 92, 0, 0, 9, 9 }, /* 88 "CONNECT FAIL" */
+    { 92, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 89 "+CD" */
+    { 93, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 90 "+CDN" */
+    { 94, 1, 107, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 91 "+CDNS" */
+    { 95, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 92 "+CDNSG" */
+    { 96, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 93 "+CDNSGI" */
+    { 97, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 94 "+CDNSGIP" */
+    { 98, 0, 0, 11, 11 }, /* 95 "+CDNSGIP:" */
+    { 98, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 96 "+H" */
+    { 99, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 97 "+HT" */
+    { 100, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 98 "+HTT" */
+    { 101, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 99 "+HTTP" */
+    { 102, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 100 "+HTTPA" */
+    { 103, 1, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 101 "+HTTPAC" */
+    { 104, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 102 "+HTTPACT" */
+    { 105, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 103 "+HTTPACTI" */
+    { 106, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 104 "+HTTPACTIO" */
+    { 107, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 105 "+HTTPACTION" */
+    { 108, 0, 0, 12, 12 }, /* 106 "+HTTPACTION:" */
+    { 108, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 107 "S" */
+    { 109, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 108 "SE" */
+    { 110, 1, 46, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 109 "SEN" */
+    { 111, 1, 118, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 110 "SEND" */
+    { 112, 2, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 111 "SEND " */
+    { 114, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 112 "SEND O" */
+    { 115, 0, 0, 13, 13 }, /* 113 "SEND OK" */
+    { 115, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 114 "SEND F" */
+    { 116, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 115 "SEND FA" */
+    { 117, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 116 "SEND FAI" */
+    { 118, 0, 0, 14, 14 }, /* 117 "SEND FAIL" */
+    { 118, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 118 "D" */
+    { 119, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 119 "DA" */
+    { 120, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 120 "DAT" */
+    { 121, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 121 "DATA" */
+    { 122, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 122 "DATA " */
+    { 123, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 123 "DATA A" */
+    { 124, 1, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 124 "DATA AC" */
+    { 125, 1, 11, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 125 "DATA ACC" */
+    { 126, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 126 "DATA ACCE" */
+    { 127, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 127 "DATA ACCEP" */
+    { 128, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 128 "DATA ACCEPT" */
+    { 129, 0, 0, 15, 15 } /* 129 "DATA ACCEPT:" */
+};
+
+static const ResponseEdge SIM900_URC_EDGES[] PROGMEM = {
+    { '+', 5 },
+    { 'C', 11 },
+    { 'D', 118 },
+    { 'N', 46 },
+    { 'R', 1 },
+    { 'S', 107 },
+    { 'U', 63 },
+    { 'I', 2 },
+    { 'N', 3 },
+    { 'G', 4 },
+    { 'C', 6 },
+    { 'H', 96 },
+    { 'P', 17 },
+    { 'D', 89 },
+    { 'I', 27 },
+    { 'M', 7 },
+    { 'T', 8 },
+    { 'I', 9 },
+    { ':', 10 },
+    { 'L', 12 },
+    { 'O', 76 },
+    { 'a', 37 },
+    { 'O', 13 },
+    { 'S', 14 },
+    { 'E', 15 },
+    { 'D', 16 },
+    { 'D', 18 },
+    { 'P', 19 },
+    { ':', 20 },
+    { ' ', 21 },
+    { 'D', 22 },
+    { 'E', 23 },
+    { 'A', 24 },
+    { 'C', 25 },
+    { 'T', 26 },
+    { 'P', 28 },
+    { 'R', 29 },
+    { 'X', 30 },
+    { 'G', 31 },
+    { 'E', 32 },
+    { 'T', 33 },
+    { ':', 34 },
+    { ' ', 35 },
+    { '1', 36 },
+    { 'l', 38 },
+    { 'l', 39 },
+    { ' ', 40 },
+    { 'R', 41 },
+    { 'e', 42 },
+    { 'a', 43 },
+    { 'd', 44 },
+    { 'y', 45 },
+    { 'O', 47 },
+    { 'R', 48 },
+    { 'M', 49 },
+    { 'A', 50 },
+    { 'L', 51 },
+    { ' ', 52 },
+    { 'P', 53 },
+    { 'O', 54 },
+    { 'W', 55 },
+    { 'E', 56 },
+    { 'R', 57 },
+    { ' ', 58 },
+    { 'D', 59 },
+    { 'O', 60 },
+    { 'W', 61 },
+    { 'N', 62 },
+    { 'N', 64 },
+    { 'D', 65 },
+    { 'E', 66 },
+    { 'R', 67 },
+    { '-', 68 },
+    { 'V', 69 },
+    { 'O', 70 },
+    { 'L', 71 },
+    { 'T', 72 },
+    { 'A', 73 },
+    { 'G', 74 },
+    { 'E', 75 },
+    { 'N', 77 },
+    { 'N', 78 },
+    { 'E', 79 },
+    { 'C', 80 },
+    { 'T', 81 },
+    { ' ', 82 },
+    { 'F', 85 },
+    { 'O', 83 },
+    { 'K', 84 },
+    { 'A', 86 },
+    { 'I', 87 },
+    { 'L', 88 },
+    { 'N', 90 },
+    { 'S', 91 },
+    { 'G', 92 },
+    { 'I', 93 },
+    { 'P', 94 },
+    { ':', 95 },
+    { 'T', 97 },
+    { 'T', 98 },
+    { 'P', 99 },
+    { 'A', 100 },
+    { 'C', 101 },
+    { 'T', 102 },
+    { 'I', 103 },
+    { 'O', 104 },
+    { 'N', 105 },
+    { ':', 106 },
+    { 'E', 108 },
+    { 'N', 109 },
+    { 'D', 110 },
+    { ' ', 111 },
+    { 'F', 114 },
+    { 'O', 112 },
+    { 'K', 113 },
+    { 'A', 115 },
+    { 'I', 116 },
+    { 'L', 117 },
+    { 'A', 119 },
+    { 'T', 120 },
+    { 'A', 121 },
+    { ' ', 122 },
+    { 'A', 123 },
+    { 'C', 124 },
+    { 'C', 125 },
+    { 'E', 126 },
+    { 'P', 127 },
+    { 'T', 128 },
+    { ':', 129 }
+};
+
+static const ResponseAutomaton SIM900_URC_AUTOMATON PROGMEM = {
+    SIM900_URC_TOKENS, SIM900_URC_STATES, SIM900_URC_EDGES
+};
+
+/**
+ * 4 tokens of SIM900_CAPABILITY_TOKENS, 29 states.
+ */
+static_assert(sizeof(SIM900_CAPABILITY_TOKENS) / sizeof(ResponseToken) == 4,
+        "SIM900_CAPABILITY_TOKENS changed, run make automata");
+
+static const ResponseState SIM900_CAPABILITY_STATES[] PROGMEM = {
+    { 0, 2, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 0 "" */
+    { 2, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 1 "+" */
+    { 3, 3, 19, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 2 "+C" */
+    { 6, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 3 "+CP" */
+    { 7, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 4 "+CPI" */
+    { 8, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 5 "+CPIN" */
+    { 9, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 6 "+CPIN:" */
+    { 10, 0, 0, 0, 0 }, /* 7 "+CPIN: " */
+    { 10, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 8 "+CR" */
+    { 11, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 9 "+CRE" */
+    { 12, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 10 "+CREG" */
+    { 13, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 11 "+CREG:" */
+    { 14, 0, 0, 1, 1 }, /* 12 "+CREG: " */
+    { 14, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 13 "+CG" */
+    { 15, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 14 "+CGR" */
+    { 16, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 15 "+CGRE" */
+    { 17, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 16 "+CGREG" */
+    { 18, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 17 "+CGREG:" */
+    { 19, 0, 0, 2, 2 }, /* 18 "+CGREG: " */
+    { 19, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 19 "C" */
+    { 20, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 20 "Ca" */
+    { 21, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 21 "Cal" */
+    { 22, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 22 "Call" */
+    { 23, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 23 "Call " */
+    { 24, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 24 "Call R" */
+    { 25, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 25 "Call Re" */
+    { 26, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 26 "Call Rea" */
+    { 27, 1, 0, RESPONSE_MATCHER_NO_MATCH, RESPONSE_MATCHER_NO_MATCH }, /* 27 "Call Read" */
+    { 28, 0, 0, 3, 3 } /* 28 "Call Ready" */
+};
+
+static const ResponseEdge SIM900_CAPABILITY_EDGES[] PROGMEM = {
+    { '+', 1 },
+    { 'C', 19 },
+    { 'C', 2 },
+    { 'G', 13 },
+    { 'P', 3 },
+    { 'R', 8 },
+    { 'I', 4 },
+    { 'N', 5 },
+    { ':', 6 },
+    { ' ', 7 },
+    { 'E', 9 },
+    { 'G', 10 },
+    { ':', 11 },
+    { ' ', 12 },
+    { 'R', 14 },
+    { 'E', 15 },
+    { 'G', 16 },
+    { ':', 17 },
+    { ' ', 18 },
+    { 'a', 20 },
+    { 'l', 21 },
+    { 'l', 22 },
+    { ' ', 23 },
+    { 'R', 24 },
+    { 'e', 25 },
+    { 'a', 26 },
+    { 'd', 27 },
+    { 'y', 28 }
+};
+
+static const ResponseAutomaton SIM900_CAPABILITY_AUTOMATON PROGMEM = {
+    SIM900_CAPABILITY_TOKENS, SIM900_CAPABILITY_STATES, SIM900_CAPABILITY_EDGES
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_SIM900_AUTOMATA_H__ */
@@ -0,0 +1,74 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * SIM900Tokens.h
+ *
+ * Token tables of the SIM900 responses, the sources of SIM900Automata.h.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_SIM900_TOKENS_H__
+#define __ARDUINO_DRIVER_GSM_SIM900_TOKENS_H__ 1
+
+#include <Arduino.h>
+#include "SIM900.h"
+
+/**
+ * The unsolicited result codes, matched at the start of a line. Where a
+ * code starts another, the longer one comes first. Codes of pruned
+ * features stay, so the automaton is the same in every build; SIM900
+ * leaves them in the response.
+ */
+static const char SIM900_URC_RING[] PROGMEM = "RING";
+static const char SIM900_URC_NEW_MESSAGE[] PROGMEM = "+CMTI:";
+static const char SIM900_URC_CLOSED[] PROGMEM = "CLOSED";
+static const char SIM900_URC_PDP_DEACT[] PROGMEM = "+PDP: DEACT";
+static const char SIM900_URC_DATA_AVAILABLE[] PROGMEM = "+CIPRXGET: 1";
+static const char SIM900_URC_CALL_READY[] PROGMEM = "Call Ready";
+static const char SIM900_URC_POWER_DOWN[] PROGMEM = "NORMAL POWER DOWN";
+static const char SIM900_URC_UNDER_VOLTAGE[] PROGMEM = "UNDER-VOLTAGE";
+static const char SIM900_URC_CONNECT_OK[] PROGMEM = "CONNECT OK";
+static const char SIM900_URC_CONNECT_FAIL[] PROGMEM = "CONNECT FAIL";
+static const char SIM900_URC_CONNECT[] PROGMEM = "CONNECT";
+static const char SIM900_URC_DNS[] PROGMEM = "+CDNSGIP:";
+static const char SIM900_URC_HTTP_ACTION[] PROGMEM = "+HTTPACTION:";
+static const char SIM900_URC_SEND_OK[] PROGMEM = "SEND OK";
+static const char SIM900_URC_SEND_FAIL[] PROGMEM = "SEND FAIL";
+static const char SIM900_URC_DATA_ACCEPT[] PROGMEM = "DATA ACCEPT:";
+
+static const ResponseToken SIM900_URC_TOKENS[] PROGMEM = {
+    { SIM900_URC_RING, SIM900::URC_RING },
+    { SIM900_URC_NEW_MESSAGE, SIM900::URC_NEW_MESSAGE },
+    { SIM900_URC_CLOSED, SIM900::URC_CLOSED },
+    { SIM900_URC_PDP_DEACT, SIM900::URC_PDP_DEACT },
+    { SIM900_URC_DATA_AVAILABLE, SIM900::URC_DATA_AVAILABLE },
+    { SIM900_URC_CALL_READY, SIM900::URC_CALL_READY },
+    { SIM900_URC_POWER_DOWN, SIM900::URC_POWER_DOWN },
+    { SIM900_URC_UNDER_VOLTAGE, SIM900::URC_UNDER_VOLTAGE },
+    { SIM900_URC_CONNECT_OK, SIM900::URC_CONNECT },
+    { SIM900_URC_CONNECT_FAIL, SIM900::URC_CONNECT },
+    { SIM900_URC_CONNECT, SIM900::URC_CONNECT },
+    { SIM900_URC_DNS, SIM900::URC_DNS },
+    { SIM900_URC_HTTP_ACTION, SIM900::URC_HTTP_ACTION },
+    { SIM900_URC_SEND_OK, SIM900::URC_SEND },
+    { SIM900_URC_SEND_FAIL, SIM900::URC_SEND },
+    { SIM900_URC_DATA_ACCEPT, SIM900::URC_SEND }
+};
+
+/**
+ * The reports which tell what the modem is capable of.
+ */
+static const char SIM900_CAPABILITY_SIM[] PROGMEM = "+CPIN: ";
+static const char SIM900_CAPABILITY_NETWORK[] PROGMEM = "+CREG: ";
+static const char SIM900_CAPABILITY_GPRS[] PROGMEM = "+CGREG: ";
+static const char SIM900_CAPABILITY_CALL_READY[] PROGMEM = "Call Ready";
+
+static const ResponseToken SIM900_CAPABILITY_TOKENS[] PROGMEM = {
+    { SIM900_CAPABILITY_SIM, SIM900::CAPABILITY_SIM },
+    { SIM900_CAPABILITY_NETWORK, SIM900::CAPABILITY_NETWORK },
+    { SIM900_CAPABILITY_GPRS, SIM900::CAPABILITY_GPRS },
+    { SIM900_CAPABILITY_CALL_READY, SIM900::CAPABILITY_CALL_READY }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_SIM900_TOKENS_H__ */
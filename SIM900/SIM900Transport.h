@@ -0,0 +1,61 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * SIM900Transport.h
+ *
+ * Compile time selection of the serial transport used by SIM900.
+ *
+ * The transport is a concrete class, so every byte the modem reads or
+ * writes is a direct call with no virtual dispatch. Define one of the
+ * following when building the library (e.g. with -D build flags):
+ *
+ * <ul>
+ *  <li>nothing: SoftwareSerial, the default</li>
+ *  <li>SIM900_TRANSPORT_HARDWARE_SERIAL: HardwareSerial (Serial, Serial1, ...)</li>
+ *  <li>SIM900_TRANSPORT_POSIX: PosixSerial, a termios device or pty on Linux</li>
+ *  <li>SIM900_TRANSPORT and SIM900_TRANSPORT_HEADER: any other Stream class</li>
+ * </ul>
+ *
+ * SIM900_TRANSPORT_MAX_BAUD_RATE is the fastest rate the transport keeps up
+ * with reliably, the ceiling of the automatic baud rate upgrade. It can be
+ * overridden with a build flag as well.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_SIM900_TRANSPORT_H__
+#define __ARDUINO_DRIVER_GSM_SIM900_TRANSPORT_H__ 1
+
+#include <Arduino.h>
+
+#if defined(SIM900_TRANSPORT_HARDWARE_SERIAL)
+
+typedef HardwareSerial SIM900Transport;
+
+#elif defined(SIM900_TRANSPORT_POSIX)
+
+#include <PosixSerial.h>
+typedef PosixSerial SIM900Transport;
+
+#elif defined(SIM900_TRANSPORT)
+
+#include SIM900_TRANSPORT_HEADER
+typedef SIM900_TRANSPORT SIM900Transport;
+
+#else
+
+#include <SoftwareSerial.h>
+#define SIM900_TRANSPORT_SOFTWARE_SERIAL        1
+typedef SoftwareSerial SIM900Transport;
+
+#endif
+
+#ifndef SIM900_TRANSPORT_MAX_BAUD_RATE
+#ifdef SIM900_TRANSPORT_SOFTWARE_SERIAL
+#define SIM900_TRANSPORT_MAX_BAUD_RATE          38400L
+#else
+#define SIM900_TRANSPORT_MAX_BAUD_RATE          115200L
+#endif
+#endif
+
+#endif /* __ARDUINO_DRIVER_GSM_SIM900_TRANSPORT_H__ */
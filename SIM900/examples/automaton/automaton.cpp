@@ -0,0 +1,205 @@
+/**
+ * Generates the Aho-Corasick automata of the response token tables, which
+ * ResponseMatcher runs from flash. Each <Library>Tokens.h gets its
+ * <Library>Automata.h, to be regenerated whenever a table changes.
+ *
+ * $ make automata
+ */
+
+#include <Arduino.h>
+#include <SIM900Tokens.h>
+#include <GprsSIM900Tokens.h>
+#include <CallSIM900Tokens.h>
+
+/**
+ * The states are numbered in an unsigned char, RESPONSE_MATCHER_NO_MATCH
+ * excluded, and so are the edges, one less than the states.
+ */
+#define AUTOMATON_MAX_STATES                    RESPONSE_MATCHER_NO_MATCH
+#define AUTOMATON_NONE                          RESPONSE_MATCHER_NO_MATCH
+
+struct Table {
+    const char *name;
+    const ResponseToken *tokens;
+    unsigned char count;
+};
+
+#define TABLE(prefix, tokens)                   { prefix, tokens, sizeof(tokens) / sizeof(ResponseToken) }
+
+static const Table SIM900_TABLES[] = {
+    TABLE("SIM900_URC", SIM900_URC_TOKENS),
+    TABLE("SIM900_CAPABILITY", SIM900_CAPABILITY_TOKENS)
+};
+
+static const Table GPRS_SIM900_TABLES[] = {
+    TABLE("GPRS_SIM900_STATE", GPRS_SIM900_STATE_TOKENS)
+};
+
+static const Table CALL_SIM900_TABLES[] = {
+    TABLE("CALL_SIM900_RESPONSE", CALL_SIM900_RESPONSE_TOKENS)
+};
+
+struct Automaton {
+    unsigned int count;
+    int next[AUTOMATON_MAX_STATES][256];
+    unsigned char fail[AUTOMATON_MAX_STATES];
+    unsigned char token[AUTOMATON_MAX_STATES];
+    unsigned char match[AUTOMATON_MAX_STATES];
+    unsigned char depth[AUTOMATON_MAX_STATES];
+
+    /**
+     * The bytes leading to each state, for the comments.
+     */
+    char text[AUTOMATON_MAX_STATES][64];
+};
+
+static Automaton automaton;
+
+static bool build(const Table *table) {
+    unsigned int i, s, c, head = 0, tail = 0, f;
+    unsigned char queue[AUTOMATON_MAX_STATES];
+    const char *p;
+    memset(&automaton, 0, sizeof(automaton));
+    memset(automaton.next, -1, sizeof(automaton.next));
+    memset(automaton.token, AUTOMATON_NONE, sizeof(automaton.token));
+    automaton.count = 1;
+
+    // The trie of the tokens, the first of two equal ones ends the state
+    for (i = 0; i < table->count; i++) {
+        s = 0;
+        for (p = table->tokens[i].text; *p != '\0'; p++) {
+            c = (unsigned char) *p;
+            if (automaton.next[s][c] < 0) {
+                if (automaton.count == AUTOMATON_MAX_STATES || automaton.depth[s] + 1u >= sizeof(automaton.text[0])) {
+                    fprintf(stderr, "%s: too many states\n", table->name);
+                    return false;
+                }
+                automaton.next[s][c] = automaton.count;
+                automaton.depth[automaton.count] = automaton.depth[s] + 1;
+                memcpy(automaton.text[automaton.count], automaton.text[s], automaton.depth[s]);
+                automaton.text[automaton.count][automaton.depth[s]] = (char) c;
+                automaton.count++;
+            }
+            s = automaton.next[s][c];
+        }
+        if (automaton.token[s] == AUTOMATON_NONE) {
+            automaton.token[s] = i;
+        }
+    }
+
+    // The fail links, breadth first so those of the shorter states are known
+    automaton.match[0] = automaton.token[0];
+    queue[tail++] = 0;
+    while (head < tail) {
+        s = queue[head++];
+        for (c = 0; c < 256; c++) {
+            if (automaton.next[s][c] < 0) {
+                continue;
+            }
+            i = automaton.next[s][c];
+            f = s == 0 ? 0 : automaton.fail[s];
+            while (s != 0 && f != 0 && automaton.next[f][c] < 0) {
+                f = automaton.fail[f];
+            }
+            automaton.fail[i] = s != 0 && automaton.next[f][c] >= 0 ? automaton.next[f][c] : 0;
+            automaton.match[i] = automaton.token[i] < automaton.match[automaton.fail[i]]
+                    ? automaton.token[i] : automaton.match[automaton.fail[i]];
+            queue[tail++] = i;
+        }
+    }
+    return true;
+}
+
+static void printByte(FILE *out, unsigned int c) {
+    if (c == '\'' || c == '\\') {
+        fprintf(out, "'\\%c'", c);
+    } else if (c >= ' ' && c < 0x7f) {
+        fprintf(out, "'%c'", c);
+    } else {
+        fprintf(out, "0x%02x", c);
+    }
+}
+
+static void printId(FILE *out, unsigned char id) {
+    if (id == AUTOMATON_NONE) {
+        fprintf(out, "RESPONSE_MATCHER_NO_MATCH");
+    } else {
+        fprintf(out, "%u", id);
+    }
+}
+
+static void generate(FILE *out, const Table *table) {
+    unsigned int s, c, edges = 0, count;
+    fprintf(out, "/**\n * %u tokens of %s_TOKENS, %u states.\n */\n", table->count, table->name, automaton.count);
+    fprintf(out, "static_assert(sizeof(%s_TOKENS) / sizeof(ResponseToken) == %u,\n", table->name, table->count);
+    fprintf(out, "        \"%s_TOKENS changed, run make automata\");\n\n", table->name);
+    fprintf(out, "static const ResponseState %s_STATES[] PROGMEM = {\n", table->name);
+    for (s = 0; s < automaton.count; s++) {
+        for (c = 0, count = 0; c < 256; c++) {
+            count += automaton.next[s][c] >= 0;
+        }
+        fprintf(out, "    { %u, %u, %u, ", edges, count, automaton.fail[s]);
+        printId(out, automaton.token[s]);
+        fprintf(out, ", ");
+        printId(out, automaton.match[s]);
+        fprintf(out, " }%s /* %u \"%s\" */\n", s + 1 < automaton.count ? "," : "", s, automaton.text[s]);
+        edges += count;
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const ResponseEdge %s_EDGES[] PROGMEM = {\n", table->name);
+    for (s = 0, count = 0; s < automaton.count; s++) {
+        for (c = 0; c < 256; c++) {
+            if (automaton.next[s][c] < 0) {
+                continue;
+            }
+            fprintf(out, "    { ");
+            printByte(out, c);
+            fprintf(out, ", %d }%s\n", automaton.next[s][c], ++count < edges ? "," : "");
+        }
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const ResponseAutomaton %s_AUTOMATON PROGMEM = {\n", table->name);
+    fprintf(out, "    %s_TOKENS, %s_STATES, %s_EDGES\n};\n\n", table->name, table->name, table->name);
+}
+
+static bool write(const char *dir, const char *library, const char *guard, const Table *tables, unsigned char count) {
+    char path[256];
+    unsigned char i;
+    FILE *out;
+    snprintf(path, sizeof(path), "%s/%s/%sAutomata.h", dir, library, library);
+    if ((out = fopen(path, "w")) == NULL) {
+        perror(path);
+        return false;
+    }
+    fprintf(out, "/**\n * Arduino - Gsm driver\n *\n * %sAutomata.h\n *\n", library);
+    fprintf(out, " * Automata of the token tables of %sTokens.h, generated by\n", library);
+    fprintf(out, " * \"make automata\". Do not edit.\n *\n");
+    fprintf(out, " * A state is { first edge, edges, fail, token, match }.\n *\n");
+    fprintf(out, " * @author Dalmir da Silva <dalmirdasilva@gmail.com>\n */\n\n");
+    fprintf(out, "#ifndef __ARDUINO_DRIVER_GSM_%s_AUTOMATA_H__\n", guard);
+    fprintf(out, "#define __ARDUINO_DRIVER_GSM_%s_AUTOMATA_H__ 1\n\n", guard);
+    fprintf(out, "#include \"%sTokens.h\"\n\n", library);
+    for (i = 0; i < count; i++) {
+        if (!build(&tables[i])) {
+            fclose(out);
+            return false;
+        }
+        generate(out, &tables[i]);
+    }
+    fprintf(out, "#endif /* __ARDUINO_DRIVER_GSM_%s_AUTOMATA_H__ */\n", guard);
+    return fclose(out) == 0;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : ".";
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [source directory]\n", argv[0]);
+        return 2;
+    }
+    if (!write(dir, "SIM900", "SIM900", SIM900_TABLES, sizeof(SIM900_TABLES) / sizeof(Table))
+            || !write(dir, "GprsSIM900", "GPRS_SIM900", GPRS_SIM900_TABLES, sizeof(GPRS_SIM900_TABLES) / sizeof(Table))
+            || !write(dir, "CallSIM900", "CALL_SIM900", CALL_SIM900_TABLES, sizeof(CALL_SIM900_TABLES) / sizeof(Table))) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+/**
+ * The SIM900 stack as a sketch holds it, built by make footprint to
+ * report how much flash and SRAM it takes in each configuration.
+ *
+ * $ make footprint
+ */
+
+#include <Arduino.h>
+#include <SIM900.h>
+#include <GprsSIM900.h>
+#ifndef SIM900_NO_CALL
+#include <CallSIM900.h>
+#endif
+
+#ifdef SIM900_TRANSPORT_SOFTWARE_SERIAL
+SIM900 sim(2, 3, 4, 5);
+#else
+SIM900 sim(&Serial, 4, 5);
+#endif
+GprsSIM900 gprs(&sim);
+#ifndef SIM900_NO_CALL
+CallSIM900 call(&sim);
+#endif
+
+void setup() {
+    gprs.begin(SIM900_AUTOBAUD);
+}
+
+void loop() {
+    sim.poll();
+}
@@ -0,0 +1,67 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * EmulatedSerial.cpp
+ *
+ * Serial transport to a SIM900Emulator, on virtual time.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_CPP__
+#define __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_CPP__ 1
+
+#include "EmulatedSerial.h"
+
+EmulatedSerial::EmulatedSerial(SIM900Emulator *modem)
+        : modem(modem), baud(0) {
+}
+
+void EmulatedSerial::begin(unsigned long baud) {
+    this->baud = baud;
+}
+
+void EmulatedSerial::end() {
+    baud = 0;
+}
+
+int EmulatedSerial::available() {
+    unsigned long long next, step;
+    int count = modem->available();
+    if (count == 0) {
+        next = modem->nextActivityAt();
+        step = VirtualClock::now() + EMULATED_SERIAL_POLL_STEP;
+        VirtualClock::advanceTo(next < step ? next : step);
+        count = modem->available();
+    }
+    return count;
+}
+
+int EmulatedSerial::read() {
+    return modem->read(baud);
+}
+
+int EmulatedSerial::peek() {
+    return modem->peek(baud);
+}
+
+size_t EmulatedSerial::write(uint8_t c) {
+    if (baud == 0) {
+        return 0;
+    }
+    VirtualClock::advance(SIM900Emulator::byteTime(baud));
+    modem->receive(c, baud);
+    return 1;
+}
+
+size_t EmulatedSerial::write(const uint8_t *buf, size_t len) {
+    size_t i;
+    for (i = 0; i < len && write(buf[i]) == 1; i++) {
+    }
+    return i;
+}
+
+void EmulatedSerial::flush() {
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_CPP__ */
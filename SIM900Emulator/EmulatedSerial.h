@@ -0,0 +1,90 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * EmulatedSerial.h
+ *
+ * Serial transport to a SIM900Emulator, on virtual time.
+ *
+ * Build the driver with:
+ *
+ * -DSIM900_TRANSPORT=EmulatedSerial -DSIM900_TRANSPORT_HEADER='<EmulatedSerial.h>'
+ *
+ * and link VirtualClock.cpp instead of Host/Clock.cpp.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_H__
+#define __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_H__ 1
+
+#include <Arduino.h>
+#include "SIM900Emulator.h"
+
+#define EMULATED_SERIAL_POLL_STEP               1000ULL
+
+class EmulatedSerial: public Stream {
+
+    /**
+     * The modem on the other end of the line.
+     */
+    SIM900Emulator *modem;
+
+    /**
+     * Rate the port runs at, 0 while closed.
+     */
+    unsigned long baud;
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param modem         The modem on the other end of the line.
+     */
+    EmulatedSerial(SIM900Emulator *modem);
+
+    virtual ~EmulatedSerial() {}
+
+    /**
+     * Opens the port.
+     *
+     * @param baud          The baud rate.
+     */
+    void begin(unsigned long baud);
+
+    /**
+     * Closes the port.
+     */
+    void end();
+
+    /**
+     * Number of bytes which reached the port.
+     *
+     * When none did, the virtual clock moves on to the next byte or event
+     * of the modem, at most EMULATED_SERIAL_POLL_STEP microseconds, as if
+     * the caller had spent that time polling.
+     *
+     * @return
+     */
+    virtual int available();
+
+    virtual int read();
+
+    virtual int peek();
+
+    /**
+     * Writes a byte, taking its time on the wire.
+     *
+     * @param c
+     * @return              Number of bytes written.
+     */
+    virtual size_t write(uint8_t c);
+
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    virtual void flush();
+
+    using Print::write;
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_EMULATED_SERIAL_H__ */
@@ -0,0 +1,1031 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * SIM900Emulator.cpp
+ *
+ * Host side model of a SIM900 modem and its network, on virtual time.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_CPP__
+#define __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_CPP__ 1
+
+#include "SIM900Emulator.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *SIM900_EMULATOR_STATES[] = {
+    "IP INITIAL", "IP START", "IP CONFIG", "IP GPRSACT", "IP STATUS", "TCP CONNECTING", "CONNECT OK", "TCP CLOSED"
+};
+
+SIM900Emulator::SIM900Emulator(const SIM900EmulatorConfig &config)
+        : config(config), rate(config.baudRate), echo(config.echo), multiplexed(false), quickSend(false),
+          dataHeader(false), peerEcho(false), peerHttp(false), peerMqtt(false),
+          peerPublishes(0), keepalive("0,7200,75,9"),
+          transparent(false), transparentData(false), packing(false), escapeCount(0), lastDataAt(0), registered(false),
+          networkReports(0), gprsReports(0), ipState(IP_INITIAL), bearer(false), httpInitialized(false),
+          httpBreak(0), httpBreakEnd(0), httpFileSize(0), httpFailures(0),
+          time(0), outputFreeAt(0), uplinkFreeAt(0), eventSequence(0), dataLength(0), dataConnection(-2),
+          commandLines(0), payloadBytes(0) {
+    memset(connections, 0, sizeof(connections));
+    schedule(config.registrationTime, [this]() {
+        registered = true;
+        if (networkReports != 0) {
+            respond("+CREG: 1");
+        }
+        if (gprsReports != 0) {
+            respond("+CGREG: 1");
+        }
+        respond("Call Ready");
+    });
+}
+
+SIM900EmulatorConfig SIM900Emulator::defaultConfig() {
+    SIM900EmulatorConfig config;
+    config.baudRate = 115200;
+    config.processingDelay = 20000;
+    config.networkRoundTrip = 300000;
+    config.attachTime = 2000000;
+    config.uplinkRate = 40000;
+    config.downlinkRate = 80000;
+    config.registrationTime = 1500000;
+    config.echo = true;
+    return config;
+}
+
+unsigned long long SIM900Emulator::byteTime(unsigned long rate) {
+
+    // Start bit, 8 data bits and stop bit
+    return rate == 0 ? 0 : (10000000ULL + rate - 1) / rate;
+}
+
+void SIM900Emulator::run() {
+    unsigned long long now = VirtualClock::now();
+    while (!events.empty() && events.top().at <= now) {
+        Event event = events.top();
+        events.pop();
+        time = event.at;
+        event.action();
+    }
+    time = now;
+}
+
+void SIM900Emulator::schedule(unsigned long long delay, std::function<void()> action) {
+    Event event;
+    event.at = time + delay;
+    event.sequence = eventSequence++;
+    event.action = action;
+    events.push(event);
+}
+
+void SIM900Emulator::send(const std::string &text) {
+    OutputByte b;
+    unsigned long long at = outputFreeAt > time ? outputFreeAt : time;
+    for (size_t i = 0; i < text.size(); i++) {
+        at += byteTime(rate);
+        b.readyAt = at;
+        b.rate = rate;
+        b.c = (unsigned char) text[i];
+        output.push_back(b);
+    }
+    outputFreeAt = at;
+}
+
+void SIM900Emulator::respond(const std::string &text) {
+    send("\r\n" + text + "\r\n");
+}
+
+std::string SIM900Emulator::prefix(int connection) {
+    if (!multiplexed) {
+        return "";
+    }
+    return std::string(1, (char) ('0' + connection)) + ", ";
+}
+
+void SIM900Emulator::receive(unsigned char c, unsigned long hostRate) {
+    run();
+    if (rate == 0) {
+        rate = hostRate;
+    }
+    if (hostRate != rate) {
+        return;
+    }
+    if (transparentData) {
+        receiveTransparent(c);
+        return;
+    }
+    if (dataConnection != -2) {
+        receiveData(c);
+        return;
+    }
+    if (echo) {
+        send(std::string(1, (char) c));
+    }
+    if (c == '\r') {
+        std::string commandLine = line;
+        line.clear();
+        schedule(config.processingDelay, [this, commandLine]() {
+            execute(commandLine);
+        });
+    } else if (c != '\n') {
+        line += (char) c;
+    }
+}
+
+void SIM900Emulator::execute(const std::string &commandLine) {
+    std::vector<std::string> commands;
+    std::string rest;
+    bool quoted = false;
+    unsigned char reply = REPLY_OK;
+    size_t i, from;
+    if (commandLine.size() < 2 || toupper(commandLine[0]) != 'A' || toupper(commandLine[1]) != 'T') {
+        return;
+    }
+    commandLines++;
+    rest = commandLine.substr(2);
+
+    // A dial string ends with ';' for voice calls, it is never batched
+    if (!rest.empty() && toupper(rest[0]) == 'D') {
+        commands.push_back(rest);
+    } else {
+        for (i = 0, from = 0; i <= rest.size(); i++) {
+            if (i == rest.size() || (rest[i] == ';' && !quoted)) {
+                commands.push_back(rest.substr(from, i - from));
+                from = i + 1;
+            } else if (rest[i] == '"') {
+                quoted = !quoted;
+            }
+        }
+    }
+    for (i = 0; i < commands.size() && reply == REPLY_OK; i++) {
+        reply = perform(commands[i]);
+    }
+    if (reply == REPLY_OK) {
+        respond("OK");
+    } else if (reply == REPLY_ERROR) {
+        respond("ERROR");
+    }
+}
+
+unsigned char SIM900Emulator::perform(const std::string &command) {
+    std::string name, arguments;
+    size_t separator = command.find_first_of("=?");
+    bool query = separator != std::string::npos && command[separator] == '?';
+    int connection;
+    name = command.substr(0, separator);
+    if (separator != std::string::npos && command[separator] == '=') {
+        arguments = command.substr(separator + 1);
+    }
+    for (size_t i = 0; i < name.size(); i++) {
+        name[i] = (char) toupper(name[i]);
+    }
+    if (name.empty() || name == "H" || name[0] == 'D' || name == "+CDNSCFG" || name == "+CIPSERVER") {
+        return REPLY_OK;
+    }
+    if (name == "E0" || name == "E1") {
+        echo = name[1] == '1';
+        return REPLY_OK;
+    }
+    if (name == "A") {
+        respond("NO CARRIER");
+        return REPLY_OWN;
+    }
+    if (name == "+IPR") {
+        respond("OK");
+
+        // The OK still goes out at the old rate
+        rate = strtoul(arguments.c_str(), NULL, 10);
+        return REPLY_OWN;
+    }
+    if (name == "+CPIN") {
+        respond("+CPIN: READY");
+        return REPLY_OK;
+    }
+    if (name == "+CREG") {
+        return registration(name, arguments, query, &networkReports);
+    }
+    if (name == "+CGREG") {
+        return registration(name, arguments, query, &gprsReports);
+    }
+    if (name == "+CIPMUX") {
+        if (transparent && arguments == "1") {
+            return REPLY_ERROR;
+        }
+        multiplexed = arguments == "1";
+        return REPLY_OK;
+    }
+    if (name == "+CIPTKA") {
+        if (query) {
+            respond("+CIPTKA: " + keepalive);
+        } else if (arguments == "0") {
+            keepalive = "0,7200,75,9";
+        } else if (arguments.compare(0, 2, "1,") == 0) {
+            keepalive = arguments;
+        } else {
+            return REPLY_ERROR;
+        }
+        return REPLY_OK;
+    }
+    if (name == "+CIPHEAD") {
+        if (query) {
+            respond(std::string("+CIPHEAD: ") + (dataHeader ? "1" : "0"));
+        } else {
+            dataHeader = arguments == "1";
+        }
+        return REPLY_OK;
+    }
+    if (name == "+CIPMODE") {
+        if (query) {
+            respond(std::string("+CIPMODE: ") + (transparent ? "1" : "0"));
+        } else if (multiplexed && arguments == "1") {
+            return REPLY_ERROR;
+        } else {
+            transparent = arguments == "1";
+        }
+        return REPLY_OK;
+    }
+    if (name == "O") {
+        if (!transparent || !connections[0].connected) {
+            respond("NO CARRIER");
+            return REPLY_OWN;
+        }
+        respond("CONNECT");
+        transparentData = true;
+        lastDataAt = time;
+        return REPLY_OWN;
+    }
+    if (name == "+CIPQSEND") {
+        if (query) {
+            respond(std::string("+CIPQSEND: ") + (quickSend ? "1" : "0"));
+        } else {
+            quickSend = arguments == "1";
+        }
+        return REPLY_OK;
+    }
+    if (name == "+CSTT") {
+        ipState = IP_START;
+        return REPLY_OK;
+    }
+    if (name == "+CIICR") {
+        if (ipState != IP_START) {
+            return REPLY_ERROR;
+        }
+        ipState = IP_CONFIG;
+        schedule(config.attachTime, [this]() {
+            ipState = IP_GPRSACT;
+            respond("OK");
+        });
+        return REPLY_OWN;
+    }
+    if (name == "+CIFSR") {
+        if (ipState < IP_GPRSACT) {
+            return REPLY_ERROR;
+        }
+        if (ipState == IP_GPRSACT) {
+            ipState = IP_STATUS;
+        }
+        respond(SIM900_EMULATOR_LOCAL_IP);
+        return REPLY_OWN;
+    }
+    if (name == "+CIPSTATUS") {
+        return status(arguments);
+    }
+    if (name == "+CIPSTART") {
+        return start(arguments);
+    }
+    if (name == "+CIPSEND") {
+        if (transparent) {
+            return REPLY_ERROR;
+        }
+        return sendData(arguments);
+    }
+    if (name == "+CIPACK") {
+        connection = takeConnection(arguments);
+        if (connection < 0) {
+            return REPLY_ERROR;
+        }
+        Connection *c = &connections[connection];
+        respond("+CIPACK: " + std::to_string(c->sent) + "," + std::to_string(c->acknowledged) + ","
+                + std::to_string(c->sent - c->acknowledged));
+        return REPLY_OK;
+    }
+    if (name == "+CDNSGIP") {
+        return resolve(arguments);
+    }
+    if (name == "+CIPCLOSE") {
+        return close(arguments);
+    }
+    if (name == "+SAPBR") {
+        return bearerControl(arguments);
+    }
+    if (name == "+HTTPINIT") {
+        if (!bearer || httpInitialized) {
+            return REPLY_ERROR;
+        }
+        httpInitialized = true;
+        httpBreak = 0;
+        httpBreakEnd = 0;
+        return REPLY_OK;
+    }
+    if (name == "+HTTPTERM") {
+        if (!httpInitialized) {
+            return REPLY_ERROR;
+        }
+        httpInitialized = false;
+        httpBody.clear();
+        return REPLY_OK;
+    }
+    if (name == "+HTTPPARA") {
+        return httpParameter(arguments);
+    }
+    if (name == "+HTTPACTION") {
+        return httpAction(arguments);
+    }
+    if (name == "+HTTPREAD") {
+        return httpRead(arguments);
+    }
+    if (name == "+CIPSHUT") {
+        flushSegment();
+        memset(connections, 0, sizeof(connections));
+        ipState = IP_INITIAL;
+        respond("SHUT OK");
+        return REPLY_OWN;
+    }
+    return REPLY_ERROR;
+}
+
+unsigned char SIM900Emulator::registration(const std::string &name, const std::string &arguments, bool query,
+        unsigned char *reports) {
+    if (query) {
+
+        // 1: registered, home network; 2: searching
+        respond(name + ": " + std::to_string(*reports) + "," + (registered ? "1" : "2"));
+    } else {
+        *reports = (unsigned char) strtoul(arguments.c_str(), NULL, 10);
+    }
+    return REPLY_OK;
+}
+
+int SIM900Emulator::takeConnection(std::string &arguments) {
+    int connection;
+    if (!multiplexed) {
+        return 0;
+    }
+    if (arguments.empty() || arguments[0] < '0' || arguments[0] >= '0' + SIM900_EMULATOR_CONNECTIONS
+            || (arguments.size() > 1 && arguments[1] != ',')) {
+        return -1;
+    }
+    connection = arguments[0] - '0';
+    arguments.erase(0, arguments.size() > 1 ? 2 : 1);
+    return connection;
+}
+
+unsigned char SIM900Emulator::status(const std::string &arguments) {
+    std::string rest = arguments;
+    int connection;
+    if (multiplexed && !rest.empty()) {
+        connection = takeConnection(rest);
+        if (connection < 0) {
+            return REPLY_ERROR;
+        }
+        respond("+CIPSTATUS: " + std::to_string(connection) + ",,\"\",\"\",\"\",\""
+                + (connections[connection].connected ? "CONNECTED" : "INITIAL") + "\"");
+        return REPLY_OK;
+    }
+    respond("OK");
+    respond(std::string("STATE: ") + SIM900_EMULATOR_STATES[ipState]);
+    if (multiplexed) {
+        for (connection = 0; connection < SIM900_EMULATOR_CONNECTIONS; connection++) {
+            respond("C: " + std::to_string(connection) + ",,\"\",\"\",\"\",\""
+                    + (connections[connection].connected ? "CONNECTED" : "INITIAL") + "\"");
+        }
+    }
+    return REPLY_OWN;
+}
+
+unsigned char SIM900Emulator::start(const std::string &arguments) {
+    std::string rest = arguments;
+    int connection = takeConnection(rest);
+    size_t address = rest.find(",\"");
+    unsigned long long delay = config.networkRoundTrip;
+    if (connection < 0 || ipState < IP_GPRSACT || connections[connection].connected) {
+        return REPLY_ERROR;
+    }
+    if (!multiplexed) {
+        ipState = TCP_CONNECTING;
+    }
+
+    // A name is resolved first, one more round trip
+    if (address != std::string::npos && rest.find_first_not_of("0123456789.", address + 2) != rest.find('"', address + 2)) {
+        delay += config.networkRoundTrip;
+    }
+
+    // The OK comes right away, the connection one or two round trips later
+    schedule(delay, [this, connection]() {
+        connections[connection].connected = true;
+        peerRequests[connection].clear();
+        peerTopics[connection].clear();
+        connections[connection].sent = 0;
+        connections[connection].acknowledged = 0;
+        if (!multiplexed) {
+            ipState = CONNECT_OK;
+        }
+
+        // A transparent connection goes straight to data mode
+        if (transparent) {
+            respond("CONNECT");
+            transparentData = true;
+            lastDataAt = time;
+            return;
+        }
+        respond(prefix(connection) + "CONNECT OK");
+    });
+    return REPLY_OK;
+}
+
+unsigned char SIM900Emulator::sendData(const std::string &arguments) {
+    std::string rest = arguments;
+    int connection = takeConnection(rest);
+    if (connection < 0 || !connections[connection].connected) {
+        return REPLY_ERROR;
+    }
+    dataLength = (unsigned int) strtoul(rest.c_str(), NULL, 10);
+    if (dataLength > SIM900_EMULATOR_MAX_SEND_SIZE) {
+        return REPLY_ERROR;
+    }
+    dataConnection = connection;
+    data.clear();
+    send("> ");
+    return REPLY_OWN;
+}
+
+void SIM900Emulator::receiveData(unsigned char c) {
+
+    // Without a length the payload ends with Ctrl-Z, and Esc cancels it
+    if (dataLength == 0 && c == 0x1b) {
+        dataConnection = -2;
+        return;
+    }
+    if (dataLength == 0 && c == 0x1a) {
+        finishData();
+        return;
+    }
+    data += (char) c;
+    if (data.size() == dataLength) {
+        finishData();
+    }
+}
+
+void SIM900Emulator::finishData() {
+    int connection = dataConnection;
+    unsigned long length = data.size();
+    unsigned long long start = uplinkFreeAt > time ? uplinkFreeAt : time;
+    dataConnection = -2;
+    payloadBytes += length;
+    uplinkFreeAt = start + config.processingDelay + (unsigned long long) length * 8 * 1000000ULL / config.uplinkRate;
+
+    // In quick send mode the payload is accepted once buffered, and only
+    // AT+CIPACK tells when the peer acknowledged it
+    reachPeer(connection, data, uplinkFreeAt + config.networkRoundTrip / 2);
+    if (quickSend) {
+        connections[connection].sent += length;
+        schedule(config.processingDelay, [this, connection, length]() {
+            respond("DATA ACCEPT:" + (multiplexed ? std::to_string(connection) + "," : std::string())
+                    + std::to_string(length));
+        });
+        schedule(uplinkFreeAt - time + config.networkRoundTrip, [this, connection, length]() {
+            connections[connection].acknowledged += length;
+        });
+        return;
+    }
+
+    // SEND OK tells the peer acknowledged the payload
+    schedule(uplinkFreeAt - time + config.networkRoundTrip, [this, connection, length]() {
+        connections[connection].sent += length;
+        connections[connection].acknowledged += length;
+        respond(prefix(connection) + "SEND OK");
+    });
+}
+
+void SIM900Emulator::receiveTransparent(unsigned char c) {
+    unsigned long long idle = time - lastDataAt, at = time;
+    lastDataAt = time;
+
+    // The first '+' after a silence may start an escape, which needs a silence after it too
+    if (c == '+' && escapeCount < 3 && (escapeCount > 0 || idle >= SIM900_EMULATOR_ESCAPE_GUARD)) {
+        escapeCount++;
+        if (escapeCount == 3) {
+            schedule(SIM900_EMULATOR_ESCAPE_GUARD, [this, at]() {
+                if (transparentData && escapeCount == 3 && lastDataAt == at) {
+                    escapeCount = 0;
+                    transparentData = false;
+                    respond("OK");
+                }
+            });
+        }
+        return;
+    }
+    forward(std::string(escapeCount, '+') + (char) c);
+    escapeCount = 0;
+}
+
+void SIM900Emulator::forward(const std::string &bytes) {
+    for (size_t i = 0; i < bytes.size(); i++) {
+        segment += bytes[i];
+        if (segment.size() == SIM900_EMULATOR_MAX_SEND_SIZE) {
+            flushSegment();
+        }
+    }
+    if (!segment.empty() && !packing) {
+        packing = true;
+        schedule(SIM900_EMULATOR_PACKING_TIME, [this]() {
+            packing = false;
+            flushSegment();
+        });
+    }
+}
+
+void SIM900Emulator::flushSegment() {
+    unsigned long length = segment.size();
+    unsigned long long start = uplinkFreeAt > time ? uplinkFreeAt : time;
+    if (length == 0) {
+        return;
+    }
+    payloadBytes += length;
+    connections[0].sent += length;
+    uplinkFreeAt = start + (unsigned long long) length * 8 * 1000000ULL / config.uplinkRate;
+    reachPeer(0, segment, uplinkFreeAt + config.networkRoundTrip / 2);
+    segment.clear();
+    schedule(uplinkFreeAt - time + config.networkRoundTrip, [this, length]() {
+        connections[0].acknowledged += length;
+    });
+}
+
+void SIM900Emulator::reachPeer(int connection, const std::string &payload, unsigned long long receivedAt) {
+    if (peerHttp) {
+        serveHttp(connection, payload, receivedAt);
+        return;
+    }
+    if (peerMqtt) {
+        serveMqtt(connection, payload, receivedAt);
+        return;
+    }
+    if (!peerEcho) {
+        return;
+    }
+
+    // Half a round trip to the peer, half a round trip back
+    schedule(receivedAt + config.networkRoundTrip / 2 - time, [this, connection, payload]() {
+        deliver(connection, payload);
+    });
+}
+
+void SIM900Emulator::serveHttp(int connection, const std::string &payload, unsigned long long receivedAt) {
+    std::string &pending = peerRequests[connection];
+    pending += payload;
+    for (;;) {
+        size_t headEnd = pending.find("\r\n\r\n"), consumed, bodyLength = 0, at, end;
+        if (headEnd == std::string::npos) {
+            return;
+        }
+        std::string head = pending.substr(0, headEnd + 2), lower = head, path, body, response;
+        for (size_t i = 0; i < lower.size(); i++) {
+            lower[i] = (char) tolower(lower[i]);
+        }
+
+        // The body goes up to the last chunk, or for Content-Length bytes
+        if (lower.find("transfer-encoding: chunked") != std::string::npos) {
+            unsigned long size;
+            at = headEnd + 4;
+            for (;;) {
+                end = pending.find("\r\n", at);
+                if (end == std::string::npos) {
+                    return;
+                }
+                size = strtoul(pending.c_str() + at, NULL, 16);
+                at = end + 2;
+                if (pending.size() < at + size + 2) {
+                    return;
+                }
+                at += size + 2;
+                if (size == 0) {
+                    break;
+                }
+                bodyLength += size;
+            }
+            consumed = at;
+        } else {
+            at = lower.find("content-length:");
+            if (at != std::string::npos) {
+                bodyLength = strtoul(lower.c_str() + at + 15, NULL, 10);
+            }
+            consumed = headEnd + 4 + bodyLength;
+            if (pending.size() < consumed) {
+                return;
+            }
+        }
+        at = head.find(' ');
+        end = head.find(' ', at + 1);
+        path = at != std::string::npos && end != std::string::npos ? head.substr(at + 1, end - at - 1) : "/";
+        bool closing = lower.find("connection: close") != std::string::npos, until = false;
+        bool headOnly = lower.compare(0, 5, "head ") == 0;
+        pending.erase(0, consumed);
+
+        response = "HTTP/1.1 200 OK\r\n";
+        if (path.compare(0, 9, "/chunked/") == 0) {
+            size_t length = strtoul(path.c_str() + 9, NULL, 10), size;
+            response += "Transfer-Encoding: chunked\r\n";
+            for (size_t i = 0; i < length; i += size) {
+                size = length - i < 100 ? length - i : 100;
+                char hex[8];
+                snprintf(hex, sizeof(hex), "%zx", size);
+                body += hex + std::string("\r\n");
+                for (size_t j = 0; j < size; j++) {
+                    body += (char) ('a' + (i + j) % 26);
+                }
+                body += "\r\n";
+            }
+            body += "0\r\n\r\n";
+        } else {
+
+            // /close/<n> has neither length nor chunks, the body ends with the connection
+            until = path.compare(0, 7, "/close/") == 0;
+            if (path.compare(0, 7, "/bytes/") == 0 || until) {
+                size_t length = strtoul(path.c_str() + 7, NULL, 10);
+                for (size_t i = 0; i < length; i++) {
+                    body += (char) ('a' + i % 26);
+                }
+            } else {
+                body = std::to_string(bodyLength);
+            }
+            if (!until) {
+                response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+            }
+        }
+        closing = closing || until;
+        if (closing) {
+            response += "Connection: close\r\n";
+        }
+        response += "\r\n" + (headOnly ? std::string() : body);
+
+        // Half a round trip to the peer, half a round trip back
+        schedule(receivedAt + config.networkRoundTrip / 2 - time, [this, connection, response, closing]() {
+            for (size_t i = 0; i < response.size(); i += SIM900_EMULATOR_MAX_SEND_SIZE) {
+                deliver(connection, response.substr(i, SIM900_EMULATOR_MAX_SEND_SIZE));
+            }
+            if (closing) {
+                disconnect(connection);
+            }
+        });
+    }
+}
+
+void SIM900Emulator::serveMqtt(int connection, const std::string &payload, unsigned long long receivedAt) {
+    std::string &pending = peerRequests[connection], replies[SIM900_EMULATOR_CONNECTIONS];
+    bool closing = false;
+    pending += payload;
+    while (!closing) {
+        size_t length = 0, at = 1;
+        unsigned int shift = 0;
+        unsigned char digit = 0x80;
+
+        // <type and flags><remaining length, 7 bits a byte><rest>
+        while ((digit & 0x80) && at < pending.size()) {
+            digit = (unsigned char) pending[at++];
+            length |= (size_t) (digit & 0x7f) << shift;
+            shift += 7;
+        }
+        if ((digit & 0x80) || pending.size() < at + length) {
+            break;
+        }
+        unsigned char header = (unsigned char) pending[0];
+        std::string body = pending.substr(at, length);
+        pending.erase(0, at + length);
+        switch (header >> 4) {
+        case 1:
+            replies[connection] += std::string("\x20\x02\x00\x00", 4);
+            break;
+        case 3: {
+            unsigned char qos = (header >> 1) & 0x03;
+            size_t topicLength = body.size() >= 2 ? ((unsigned char) body[0] << 8) | (unsigned char) body[1] : 0;
+            std::string topic = body.substr(2, topicLength), id;
+            peerPublishes++;
+            if (qos > 0) {
+                id = body.substr(2 + topicLength, 2);
+                replies[connection] += std::string("\x40\x02", 2) + id;
+            }
+
+            // Forwarded at QoS 0, without the packet id
+            std::string forward = std::string(1, (char) 0x30) + std::string(2, '\0') + topic
+                    + body.substr(2 + topicLength + (qos > 0 ? 2 : 0));
+            forward[1] = (char) (topicLength >> 8);
+            forward[2] = (char) topicLength;
+            std::string encoded(1, (char) 0x30);
+            for (size_t rest = forward.size() - 1; ; ) {
+                encoded += (char) ((rest & 0x7f) | (rest > 0x7f ? 0x80 : 0));
+                rest >>= 7;
+                if (rest == 0) {
+                    break;
+                }
+            }
+            encoded += forward.substr(1);
+            for (int i = 0; i < SIM900_EMULATOR_CONNECTIONS; i++) {
+                for (size_t j = 0; j < peerTopics[i].size(); j++) {
+                    if (peerTopics[i][j] == topic) {
+                        replies[i] += encoded;
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        case 8: {
+
+            // <packet id>, then <topic filter><QoS> pairs, each granted QoS 0
+            std::string reply = std::string(1, (char) 0x90) + std::string(1, '\0') + body.substr(0, 2);
+            for (size_t i = 2; i + 2 <= body.size(); ) {
+                size_t filterLength = ((unsigned char) body[i] << 8) | (unsigned char) body[i + 1];
+                peerTopics[connection].push_back(body.substr(i + 2, filterLength));
+                reply += '\0';
+                i += 2 + filterLength + 1;
+            }
+            reply[1] = (char) (reply.size() - 2);
+            replies[connection] += reply;
+            break;
+        }
+        case 12:
+            replies[connection] += std::string("\xd0\x00", 2);
+            break;
+        case 14:
+            closing = true;
+            break;
+        }
+    }
+
+    // Half a round trip to the peer, half a round trip back
+    for (int i = 0; i < SIM900_EMULATOR_CONNECTIONS; i++) {
+        std::string reply = replies[i];
+        bool closed = closing && i == connection;
+        if (reply.empty() && !closed) {
+            continue;
+        }
+        schedule(receivedAt + config.networkRoundTrip / 2 - time, [this, i, reply, closed]() {
+            for (size_t j = 0; j < reply.size(); j += SIM900_EMULATOR_MAX_SEND_SIZE) {
+                deliver(i, reply.substr(j, SIM900_EMULATOR_MAX_SEND_SIZE));
+            }
+            if (closed) {
+                disconnect(i);
+            }
+        });
+    }
+}
+
+void SIM900Emulator::deliver(int connection, const std::string &payload) {
+    std::string length = std::to_string(payload.size());
+    if (!connections[connection].connected) {
+        return;
+    }
+    if (transparent) {
+        send(payload);
+    } else if (multiplexed) {
+        send("\r\n+RECEIVE," + std::to_string(connection) + "," + length + ":\r\n" + payload);
+    } else if (dataHeader) {
+        send("\r\n+IPD," + length + ":" + payload);
+    } else {
+        send(payload);
+    }
+}
+
+void SIM900Emulator::disconnect(int connection) {
+    if (!connections[connection].connected) {
+        return;
+    }
+    connections[connection].connected = false;
+    if (!multiplexed) {
+        ipState = TCP_CLOSED;
+    }
+
+    // The modem leaves data mode with the connection
+    if (transparent) {
+        flushSegment();
+    }
+    transparentData = false;
+    respond(prefix(connection) + "CLOSED");
+}
+
+unsigned char SIM900Emulator::close(const std::string &arguments) {
+    std::string rest = arguments;
+    int connection = takeConnection(rest);
+    if (connection < 0 || !connections[connection].connected) {
+        return REPLY_ERROR;
+    }
+    if (transparent) {
+        flushSegment();
+    }
+    connections[connection].connected = false;
+    if (!multiplexed) {
+        ipState = TCP_CLOSED;
+    }
+    if (rest == "1") {
+        respond(prefix(connection) + "CLOSE OK");
+    } else {
+        schedule(config.networkRoundTrip, [this, connection]() {
+            respond(prefix(connection) + "CLOSE OK");
+        });
+    }
+    return REPLY_OWN;
+}
+
+unsigned char SIM900Emulator::resolve(const std::string &arguments) {
+    std::string name = arguments;
+    unsigned long hash = 2166136261UL;
+    if (ipState < IP_GPRSACT) {
+        return REPLY_ERROR;
+    }
+    if (name.size() >= 2 && name[0] == '"' && name[name.size() - 1] == '"') {
+        name = name.substr(1, name.size() - 2);
+    }
+
+    // The same name always resolves to the same address
+    for (size_t i = 0; i < name.size(); i++) {
+        hash = ((hash ^ (unsigned char) name[i]) * 16777619UL) & 0xffffffffUL;
+    }
+    std::string address = std::to_string(1 + (hash >> 24) % 223) + "." + std::to_string((hash >> 16) & 0xff) + "."
+            + std::to_string((hash >> 8) & 0xff) + "." + std::to_string(1 + (hash & 0xff) % 254);
+    schedule(config.networkRoundTrip, [this, name, address]() {
+
+        // 8: DNS common error, for the names of the reserved .invalid domain
+        if (name.size() >= 8 && name.compare(name.size() - 8, 8, ".invalid") == 0) {
+            respond("+CDNSGIP: 0,8");
+            return;
+        }
+        respond("+CDNSGIP: 1,\"" + name + "\",\"" + address + "\"");
+    });
+    return REPLY_OK;
+}
+
+unsigned char SIM900Emulator::bearerControl(const std::string &arguments) {
+
+    // <cmd>,<cid>[,<tag>,<value>]: 0 close, 1 open, 2 query, 3 set a parameter
+    if (arguments.size() < 3 || arguments[1] != ',' || arguments[2] != '1') {
+        return REPLY_ERROR;
+    }
+    switch (arguments[0]) {
+    case '0':
+        if (!bearer) {
+            return REPLY_ERROR;
+        }
+        bearer = false;
+        httpInitialized = false;
+        httpBody.clear();
+        return REPLY_OK;
+    case '1':
+        if (bearer || !registered) {
+            return REPLY_ERROR;
+        }
+        schedule(config.attachTime, [this]() {
+            bearer = true;
+            respond("OK");
+        });
+        return REPLY_OWN;
+    case '2':
+        respond(std::string("+SAPBR: 1,") + (bearer ? "1,\"" SIM900_EMULATOR_LOCAL_IP "\"" : "3,\"0.0.0.0\""));
+        return REPLY_OK;
+    case '3':
+        return REPLY_OK;
+    }
+    return REPLY_ERROR;
+}
+
+unsigned char SIM900Emulator::httpParameter(const std::string &arguments) {
+    size_t comma = arguments.find(',');
+    std::string tag;
+    if (!httpInitialized || comma == std::string::npos) {
+        return REPLY_ERROR;
+    }
+    tag = arguments.substr(0, comma);
+    for (size_t i = 0; i < tag.size(); i++) {
+        tag[i] = (char) toupper(tag[i]);
+    }
+    if (tag == "\"BREAK\"") {
+        httpBreak = strtoul(arguments.c_str() + comma + 1, NULL, 10);
+    } else if (tag == "\"BREAKEND\"") {
+        httpBreakEnd = strtoul(arguments.c_str() + comma + 1, NULL, 10);
+    }
+    return REPLY_OK;
+}
+
+unsigned char SIM900Emulator::httpAction(const std::string &arguments) {
+    unsigned long first = httpBreak, last = httpFileSize > 0 ? httpFileSize - 1 : 0;
+    unsigned long long delay;
+    std::string body;
+    int status = 200;
+    if (!httpInitialized || !bearer || arguments != "0") {
+        return REPLY_ERROR;
+    }
+    httpBody.clear();
+
+    // A drop loses the request, the network error comes once the modem gives up
+    if (httpFailures > 0) {
+        httpFailures--;
+        schedule(2 * (unsigned long long) config.networkRoundTrip, [this]() {
+            respond("+HTTPACTION: 0,601,0");
+        });
+        return REPLY_OK;
+    }
+
+    // BREAK and BREAKEND make a Range request, answered with 206
+    if (httpBreak > 0 || httpBreakEnd > 0) {
+        status = 206;
+        if (httpBreakEnd > 0 && httpBreakEnd < last) {
+            last = httpBreakEnd;
+        }
+        if (first >= httpFileSize) {
+            status = 416;
+        }
+    }
+    if (status != 416) {
+        for (unsigned long i = first; i <= last && i < httpFileSize; i++) {
+            body += (char) fileByte(i);
+        }
+    }
+    if (body.size() > SIM900_EMULATOR_HTTP_MEMORY) {
+        status = 602;
+        body.clear();
+    }
+    delay = 2 * (unsigned long long) config.networkRoundTrip
+            + (unsigned long long) body.size() * 8 * 1000000ULL / config.downlinkRate;
+    schedule(delay, [this, status, body]() {
+        httpBody = body;
+        respond("+HTTPACTION: 0," + std::to_string(status) + "," + std::to_string(body.size()));
+    });
+    return REPLY_OK;
+}
+
+unsigned char SIM900Emulator::httpRead(const std::string &arguments) {
+    unsigned long start = 0, length = httpBody.size();
+    size_t comma = arguments.find(',');
+    if (!httpInitialized || httpBody.empty()) {
+        return REPLY_ERROR;
+    }
+    if (comma != std::string::npos) {
+        start = strtoul(arguments.c_str(), NULL, 10);
+        length = strtoul(arguments.c_str() + comma + 1, NULL, 10);
+    }
+    if (start > httpBody.size()) {
+        start = httpBody.size();
+    }
+    if (length > httpBody.size() - start) {
+        length = httpBody.size() - start;
+    }
+    respond("+HTTPREAD: " + std::to_string(length));
+    send(httpBody.substr(start, length));
+    return REPLY_OK;
+}
+
+unsigned char SIM900Emulator::fileByte(unsigned long offset) {
+    return (unsigned char) (offset * 31 + (offset >> 8));
+}
+
+int SIM900Emulator::available() {
+    unsigned long long now = VirtualClock::now();
+    int count = 0;
+    run();
+    for (std::deque<OutputByte>::iterator i = output.begin(); i != output.end() && i->readyAt <= now; i++) {
+        count++;
+    }
+    return count;
+}
+
+int SIM900Emulator::read(unsigned long hostRate) {
+    int c = peek(hostRate);
+    if (c >= 0) {
+        output.pop_front();
+    }
+    return c;
+}
+
+int SIM900Emulator::peek(unsigned long hostRate) {
+    run();
+    if (output.empty() || output.front().readyAt > VirtualClock::now()) {
+        return -1;
+    }
+
+    // A byte framed at another rate comes out as garbage
+    return output.front().rate == hostRate ? output.front().c : 0xff;
+}
+
+unsigned long long SIM900Emulator::nextActivityAt() {
+    unsigned long long next = ~0ULL;
+    if (!events.empty()) {
+        next = events.top().at;
+    }
+    if (!output.empty() && output.front().readyAt < next) {
+        next = output.front().readyAt;
+    }
+    return next;
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_CPP__ */
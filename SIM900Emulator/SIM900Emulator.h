@@ -0,0 +1,530 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * SIM900Emulator.h
+ *
+ * Host side model of a SIM900 modem and its network, on virtual time.
+ *
+ * It answers the AT dialogue the drivers use: AT, E0/E1, +IPR, +CPIN,
+ * +CREG, +CGREG, +CIPMUX, +CIPMODE, +CIPQSEND, +CIPHEAD, +CSTT, +CIICR, +CIFSR, +CIPSTATUS, +CDNSCFG,
+ * +CIPSTART, +CIPSEND, +CIPACK, +CDNSGIP, +CIPCLOSE, +CIPSHUT, +CIPSERVER, O, the call
+ * commands A, D and H, and the built-in HTTP stack: +SAPBR, +HTTPINIT, +HTTPPARA,
+ * +HTTPACTION, +HTTPREAD and +HTTPTERM. Several extended commands can share a line.
+ *
+ * The serial line carries 10 bits per byte at the modem rate, the modem
+ * takes a processing delay to act on each command line, and anything
+ * which crosses the network takes a round trip time (the attach its own).
+ * The modem registers, and says Call Ready, a while after it is created.
+ * The peer can echo what it receives, which comes back as +IPD (with
+ * +CIPHEAD=1), +RECEIVE (multi-IP) or raw bytes (transparent mode), or
+ * answer it as an HTTP server would.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_H__
+#define __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_H__ 1
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+#include "VirtualClock.h"
+
+#define SIM900_EMULATOR_CONNECTIONS             8
+#define SIM900_EMULATOR_MAX_SEND_SIZE           1460
+#define SIM900_EMULATOR_LOCAL_IP                "10.64.0.2"
+
+/**
+ * Size of the HTTP response the built-in stack can hold.
+ */
+#define SIM900_EMULATOR_HTTP_MEMORY             102400
+
+/**
+ * Silence around +++ in data mode, and how long the modem collects the
+ * bytes of a segment, in microseconds.
+ */
+#define SIM900_EMULATOR_ESCAPE_GUARD            500000
+#define SIM900_EMULATOR_PACKING_TIME            100000
+
+struct SIM900EmulatorConfig {
+
+    /**
+     * Serial rate of the modem, 0 to lock on the rate of the first byte
+     * received (autobauding).
+     */
+    unsigned long baudRate;
+
+    /**
+     * Time the modem takes to act on a command line, in microseconds.
+     */
+    unsigned long processingDelay;
+
+    /**
+     * Network round trip time, in microseconds.
+     */
+    unsigned long networkRoundTrip;
+
+    /**
+     * Time AT+CIICR takes to bring the GPRS context up, in microseconds.
+     */
+    unsigned long attachTime;
+
+    /**
+     * Uplink and downlink rates of the network, in bits per second.
+     */
+    unsigned long uplinkRate;
+    unsigned long downlinkRate;
+
+    /**
+     * Time from power on to network and GPRS registration, in microseconds.
+     */
+    unsigned long registrationTime;
+
+    /**
+     * Echo of the command lines, as after a modem reset.
+     */
+    bool echo;
+};
+
+class SIM900Emulator {
+
+    /**
+     * A byte on its way to the host, and when its stop bit ends.
+     */
+    struct OutputByte {
+        unsigned long long readyAt;
+        unsigned long rate;
+        unsigned char c;
+    };
+
+    /**
+     * Something the modem or the network does at a given time.
+     */
+    struct Event {
+        unsigned long long at;
+        unsigned long sequence;
+        std::function<void()> action;
+
+        bool operator>(const Event &other) const {
+            return at != other.at ? at > other.at : sequence > other.sequence;
+        }
+    };
+
+    struct Connection {
+        bool connected;
+        unsigned long sent;
+        unsigned long acknowledged;
+    };
+
+    enum IpState {
+        IP_INITIAL = 0,
+        IP_START = 1,
+        IP_CONFIG = 2,
+        IP_GPRSACT = 3,
+        IP_STATUS = 4,
+        TCP_CONNECTING = 5,
+        CONNECT_OK = 6,
+        TCP_CLOSED = 7
+    };
+
+    /**
+     * How a command answered: OK, ERROR, or with its own final response.
+     */
+    enum Reply {
+        REPLY_OK = 0,
+        REPLY_ERROR = 1,
+        REPLY_OWN = 2
+    };
+
+    SIM900EmulatorConfig config;
+
+    /**
+     * Rate the modem is running at, 0 while autobauding.
+     */
+    unsigned long rate;
+
+    bool echo;
+    bool multiplexed;
+
+    /**
+     * Quick send mode (AT+CIPQSEND=1): DATA ACCEPT once the payload is
+     * buffered instead of SEND OK once the peer acknowledged it.
+     */
+    bool quickSend;
+
+    /**
+     * +IPD header on the payloads received in single connection mode
+     * (+CIPHEAD=1), and whether the peer echoes what it receives.
+     */
+    bool dataHeader;
+    bool peerEcho;
+
+    /**
+     * Whether the peer is an HTTP server, and the bytes of the requests it
+     * did not answer yet, for each connection. Kept out of Connection,
+     * which is cleared as a whole.
+     */
+    bool peerHttp;
+    std::string peerRequests[SIM900_EMULATOR_CONNECTIONS];
+
+    /**
+     * Whether the peer is an MQTT broker, the topics each connection
+     * subscribed to and how many PUBLISH packets it received.
+     */
+    bool peerMqtt;
+    std::vector<std::string> peerTopics[SIM900_EMULATOR_CONNECTIONS];
+    unsigned long peerPublishes;
+
+    /**
+     * The TCP keepalive settings (+CIPTKA), as given.
+     */
+    std::string keepalive;
+
+    /**
+     * Transparent mode (+CIPMODE=1) and whether the connection is in data
+     * mode. There the bytes from the host are packed into segments for
+     * connection 0, except for a +++ with silence around it: its '+' are
+     * held back, counted by escapeCount, until told from data.
+     */
+    bool transparent;
+    bool transparentData;
+    std::string segment;
+    bool packing;
+    unsigned char escapeCount;
+    unsigned long long lastDataAt;
+
+    /**
+     * Registered on the network (and GPRS), and the +CREG/+CGREG report modes.
+     */
+    bool registered;
+    unsigned char networkReports;
+    unsigned char gprsReports;
+
+    unsigned char ipState;
+    Connection connections[SIM900_EMULATOR_CONNECTIONS];
+
+    /**
+     * The bearer of the built-in HTTP stack (+SAPBR) and the stack itself
+     * (+HTTPINIT): the range asked with BREAK and BREAKEND, the body of
+     * the last response, the size of the file the server has, and how
+     * many of the next requests fail as after a drop.
+     */
+    bool bearer;
+    bool httpInitialized;
+    unsigned long httpBreak;
+    unsigned long httpBreakEnd;
+    std::string httpBody;
+    unsigned long httpFileSize;
+    unsigned int httpFailures;
+
+    /**
+     * Time the modem is acting at: the time of the event it runs or of
+     * the byte it receives.
+     */
+    unsigned long long time;
+
+    std::deque<OutputByte> output;
+    unsigned long long outputFreeAt;
+
+    /**
+     * Time the uplink is done with the payloads sent so far.
+     */
+    unsigned long long uplinkFreeAt;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+    unsigned long eventSequence;
+
+    /**
+     * The command line being received.
+     */
+    std::string line;
+
+    /**
+     * Payload of AT+CIPSEND being received, how long it is and which
+     * connection it goes to; dataConnection is -2 out of data mode.
+     */
+    std::string data;
+    unsigned int dataLength;
+    int dataConnection;
+
+    /**
+     * Counters.
+     */
+    unsigned long commandLines;
+    unsigned long payloadBytes;
+
+    void schedule(unsigned long long delay, std::function<void()> action);
+
+    /**
+     * Sends raw bytes, paced at the current rate.
+     */
+    void send(const std::string &text);
+
+    /**
+     * Sends a response line, framed with \r\n.
+     */
+    void respond(const std::string &text);
+
+    /**
+     * Prefix of a connection in multi-IP responses, "<n>, ".
+     */
+    std::string prefix(int connection);
+
+    /**
+     * Runs a command line, and each command in it.
+     */
+    void execute(const std::string &commandLine);
+
+    /**
+     * Runs one command, without the AT.
+     *
+     * @return              One of Reply.
+     */
+    unsigned char perform(const std::string &command);
+
+    /**
+     * Answers +CREG or +CGREG, setting the report mode or reporting the status.
+     */
+    unsigned char registration(const std::string &name, const std::string &arguments, bool query,
+            unsigned char *reports);
+
+    unsigned char start(const std::string &arguments);
+
+    unsigned char sendData(const std::string &arguments);
+
+    unsigned char close(const std::string &arguments);
+
+    unsigned char status(const std::string &arguments);
+
+    unsigned char resolve(const std::string &arguments);
+
+    unsigned char bearerControl(const std::string &arguments);
+
+    unsigned char httpParameter(const std::string &arguments);
+
+    /**
+     * Has the server answer the range asked, a round trip to connect and
+     * one for the request, plus the body at the downlink rate.
+     */
+    unsigned char httpAction(const std::string &arguments);
+
+    unsigned char httpRead(const std::string &arguments);
+
+    void receiveData(unsigned char c);
+
+    void finishData();
+
+    void receiveTransparent(unsigned char c);
+
+    /**
+     * Adds bytes to the segment, which goes out when full or when the
+     * packing time is over.
+     */
+    void forward(const std::string &bytes);
+
+    void flushSegment();
+
+    /**
+     * Hands a payload to the peer, which echoes it or answers it once it
+     * received it.
+     */
+    void reachPeer(int connection, const std::string &payload, unsigned long long receivedAt);
+
+    /**
+     * Answers the complete requests the peer received so far:
+     * /bytes/<n> with n bytes, /chunked/<n> with n bytes in chunks of 100
+     * and anything else with the length of its body, in decimal. A request
+     * asking for Connection: close has the peer close after the response.
+     */
+    void serveHttp(int connection, const std::string &payload, unsigned long long receivedAt);
+
+    /**
+     * Answers the complete packets the broker received so far: CONNACK
+     * accepting any CONNECT, PUBACK to the QoS 1 PUBLISH, SUBACK granting
+     * QoS 0 and PINGRESP. A PUBLISH goes to the connections subscribed to
+     * its exact topic, the sender included, and DISCONNECT closes.
+     */
+    void serveMqtt(int connection, const std::string &payload, unsigned long long receivedAt);
+
+    /**
+     * Reads the connection number off the arguments in multi-IP mode.
+     *
+     * @return              The connection, 0 in single mode, -1 if invalid.
+     */
+    int takeConnection(std::string &arguments);
+
+public:
+
+    /**
+     * Public constructor.
+     *
+     * @param config        The modem and network model.
+     */
+    SIM900Emulator(const SIM900EmulatorConfig &config);
+
+    /**
+     * A typical setup: 115200 bps, 20 ms processing, 300 ms round trip,
+     * 2 s attach, 40 kbps uplink and registered 1.5 s after power on.
+     */
+    static SIM900EmulatorConfig defaultConfig();
+
+    /**
+     * Runs everything due up to the virtual time.
+     */
+    void run();
+
+    /**
+     * Takes a byte from the host, at the virtual time.
+     *
+     * @param c             The byte.
+     * @param hostRate      Rate the host sent it at.
+     */
+    void receive(unsigned char c, unsigned long hostRate);
+
+    /**
+     * Number of bytes the host can read at the virtual time.
+     *
+     * @return
+     */
+    int available();
+
+    /**
+     * Reads a byte which reached the host.
+     *
+     * @param hostRate      Rate the host reads at; a byte sent at another
+     *                      rate is read as garbage.
+     * @return              The byte, -1 if none.
+     */
+    int read(unsigned long hostRate);
+
+    /**
+     * Peeks a byte which reached the host.
+     *
+     * @return              The byte, -1 if none.
+     */
+    int peek(unsigned long hostRate);
+
+    /**
+     * When something happens next: an event or a byte reaching the host.
+     *
+     * @return              The virtual time, ~0 if nothing is pending.
+     */
+    unsigned long long nextActivityAt();
+
+    /**
+     * Time a byte takes on the wire at a rate.
+     *
+     * @return              Microseconds.
+     */
+    static unsigned long long byteTime(unsigned long rate);
+
+    /**
+     * Has the peer echo every payload it receives.
+     *
+     * @param peerEcho
+     */
+    inline void setPeerEcho(bool peerEcho) {
+        this->peerEcho = peerEcho;
+    }
+
+    /**
+     * Has the peer answer what it receives as an HTTP/1.1 server.
+     *
+     * @param peerHttp
+     */
+    inline void setPeerHttp(bool peerHttp) {
+        this->peerHttp = peerHttp;
+    }
+
+    /**
+     * Has the peer act as an MQTT 3.1.1 broker.
+     *
+     * @param peerMqtt
+     */
+    inline void setPeerMqtt(bool peerMqtt) {
+        this->peerMqtt = peerMqtt;
+    }
+
+    /**
+     * Sends a payload from the peer of a connection to the host, with the
+     * header of the current mode, at the time of the last run().
+     *
+     * @param connection    The connection, 0 in single connection mode.
+     * @param payload       The payload.
+     */
+    void deliver(int connection, const std::string &payload);
+
+    /**
+     * Has the peer of a connection close it, at the time of the last run().
+     *
+     * @param connection    The connection, 0 in single connection mode.
+     */
+    void disconnect(int connection);
+
+    /**
+     * Sets the size of the file served to AT+HTTPACTION, whatever the URL.
+     *
+     * @param size
+     */
+    inline void setHttpFileSize(unsigned long size) {
+        httpFileSize = size;
+    }
+
+    /**
+     * Has the next AT+HTTPACTION fail with a network error (601), as when
+     * the bearer drops, which also loses the response held.
+     *
+     * @param count         How many requests fail in a row.
+     */
+    inline void failHttpActions(unsigned int count) {
+        httpFailures = count;
+    }
+
+    /**
+     * The byte at an offset of the served file.
+     *
+     * @return
+     */
+    static unsigned char fileByte(unsigned long offset);
+
+    /**
+     * Number of command lines executed.
+     *
+     * @return
+     */
+    inline unsigned long getCommandLines() {
+        return commandLines;
+    }
+
+    /**
+     * Number of payload bytes taken by AT+CIPSEND.
+     *
+     * @return
+     */
+    inline unsigned long getPayloadBytes() {
+        return payloadBytes;
+    }
+
+    /**
+     * Rate the modem is running at.
+     *
+     * @return              The rate, 0 while autobauding.
+     */
+    inline unsigned long getBaudRate() {
+        return rate;
+    }
+
+    /**
+     * Number of PUBLISH packets the broker received.
+     *
+     * @return
+     */
+    inline unsigned long getPeerPublishes() {
+        return peerPublishes;
+    }
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_SIM900_EMULATOR_H__ */
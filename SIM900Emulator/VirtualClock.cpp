@@ -0,0 +1,48 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * VirtualClock.cpp
+ *
+ * Virtual time for the SIM900 emulator, replacing Host/Clock.cpp.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_CPP__
+#define __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_CPP__ 1
+
+#include "VirtualClock.h"
+
+unsigned long long VirtualClock::current = 0;
+
+void VirtualClock::reset() {
+    current = 0;
+}
+
+unsigned long long VirtualClock::now() {
+    return current;
+}
+
+void VirtualClock::advance(unsigned long long us) {
+    current += us;
+}
+
+void VirtualClock::advanceTo(unsigned long long us) {
+    if (us > current) {
+        current = us;
+    }
+}
+
+unsigned long millis() {
+    return (unsigned long) (VirtualClock::now() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long) VirtualClock::now();
+}
+
+void delay(unsigned long ms) {
+    VirtualClock::advance((unsigned long long) ms * 1000);
+}
+
+#endif /* __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_CPP__ */
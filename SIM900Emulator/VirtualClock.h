@@ -0,0 +1,56 @@
+/**
+ * Arduino - Gsm driver
+ *
+ * VirtualClock.h
+ *
+ * Virtual time for the SIM900 emulator, replacing Host/Clock.cpp.
+ *
+ * millis(), micros() and delay() only read and move this clock, so a
+ * program run against the emulator takes the same virtual time on every
+ * run, however fast or loaded the host is.
+ *
+ * @author Dalmir da Silva <dalmirdasilva@gmail.com>
+ */
+
+#ifndef __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_H__
+#define __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_H__ 1
+
+#include <Arduino.h>
+
+class VirtualClock {
+
+    /**
+     * Virtual time, in microseconds since the last reset.
+     */
+    static unsigned long long current;
+
+public:
+
+    /**
+     * Goes back to time 0.
+     */
+    static void reset();
+
+    /**
+     * The virtual time.
+     *
+     * @return              Microseconds since the last reset.
+     */
+    static unsigned long long now();
+
+    /**
+     * Moves the clock forward.
+     *
+     * @param us            Microseconds to move.
+     */
+    static void advance(unsigned long long us);
+
+    /**
+     * Moves the clock forward to the given time, if it is not past already.
+     *
+     * @param us            Microseconds since the last reset.
+     */
+    static void advanceTo(unsigned long long us);
+};
+
+#endif /* __ARDUINO_DRIVER_GSM_VIRTUAL_CLOCK_H__ */
@@ -0,0 +1,720 @@
+/**
+ * Measures the driver against the SIM900 emulator, on virtual time, so
+ * the figures only change when the driver (or the model) does.
+ *
+ * $ make bench
+ * $ build/host/benchmark [baud] [processing ms] [round trip ms]
+ */
+
+#include <Arduino.h>
+#include <SIM900.h>
+#include <GprsSIM900.h>
+#include <HttpClient.h>
+#include <DownloadSIM900.h>
+#include <MqttClient.h>
+#include <RecordQueue.h>
+#include <SIM900Emulator.h>
+#include <EmulatedSerial.h>
+
+#define BENCHMARK_ROUND_TRIPS                   100
+#define BENCHMARK_STATUS_QUERIES                20
+#define BENCHMARK_PAYLOADS                      20
+#define BENCHMARK_PAYLOAD_SIZE                  512
+#define BENCHMARK_UPLOAD_SIZE                   8192UL
+#define BENCHMARK_UPLOAD_PIECE                  64
+#define BENCHMARK_DELIVERY_TIMEOUT              30000UL
+#define BENCHMARK_EXCHANGES                     20
+#define BENCHMARK_EXCHANGE_SIZE                 48
+#define BENCHMARK_EXCHANGE_TIMEOUT              5000UL
+#define BENCHMARK_POOL_CONNECTIONS              4
+#define BENCHMARK_POOL_UPLOAD_SIZE              2048
+#define BENCHMARK_MESSAGES                      10
+#define BENCHMARK_NAMES                         4
+#define BENCHMARK_REQUESTS                      10
+#define BENCHMARK_CHUNK_SIZE                    256
+#define BENCHMARK_DOWNLOAD_SIZE                 204800UL
+#define BENCHMARK_SLOW_DOWNLOAD_SIZE            16384UL
+#define BENCHMARK_SAMPLES                       20
+#define BENCHMARK_RECORDS                       40
+#define BENCHMARK_RECORD_AGE                    5000UL
+
+/**
+ * What a download sink checks: the next offset it expects, the bytes
+ * which differ from the served file, the offset at which the modem drops
+ * the next ranges, how many times, and how long writing a piece takes.
+ */
+struct DownloadCheck {
+    SIM900Emulator *modem;
+    unsigned long expected;
+    unsigned long mismatches;
+    unsigned long dropAt;
+    unsigned int drops;
+    unsigned long writeTime;
+};
+
+/**
+ * What the MQTT handlers count: the QoS 1 PUBLISH acknowledged and given
+ * up, and the messages received.
+ */
+struct MqttCheck {
+    unsigned int acknowledged;
+    unsigned int givenUp;
+    unsigned int received;
+};
+
+static unsigned long long phaseStartedAt;
+static unsigned char upload[BENCHMARK_POOL_UPLOAD_SIZE];
+static const char * const names[BENCHMARK_NAMES] = {
+    "example.com", "api.example.com", "log.example.com", "ota.example.com"
+};
+
+static void startPhase() {
+    phaseStartedAt = VirtualClock::now();
+}
+
+static double phaseSeconds() {
+    return (VirtualClock::now() - phaseStartedAt) / 1000000.0;
+}
+
+static int fail(const char *step) {
+    printf("%-28s failed\n", step);
+    return 1;
+}
+
+/**
+ * Reads a whole reply, as a request/response protocol does.
+ */
+static bool receive(GprsSIM900 *gprs, unsigned char *buf, unsigned int len) {
+    unsigned long start = millis();
+    unsigned int received = 0;
+    while (received < len) {
+        received += gprs->read(-1, buf + received, len - received);
+        if (millis() - start >= BENCHMARK_EXCHANGE_TIMEOUT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Reads a whole response body, keeping what fits in the buffer.
+ *
+ * @return              Length of the body, -1 if it did not come in time.
+ */
+static long receiveBody(HttpClient *http, unsigned char *buf, unsigned int len) {
+    unsigned char rest[64];
+    unsigned long start = millis();
+    long received = 0;
+    while (!http->isComplete()) {
+        if (received < (long) len) {
+            received += http->read(buf + received, len - received);
+        } else {
+            received += http->read(rest, sizeof(rest));
+        }
+        if (millis() - start >= BENCHMARK_EXCHANGE_TIMEOUT) {
+            return -1;
+        }
+    }
+    return received;
+}
+
+/**
+ * GETs a path and reads the whole body, as a small page or an API call.
+ */
+static bool fetch(HttpClient *http, const char *path, long length) {
+    unsigned char buf[64];
+    if (http->get(path) != HttpClient::OK || http->awaitResponse(BENCHMARK_EXCHANGE_TIMEOUT) != HttpClient::OK
+            || http->getStatus() != 200) {
+        return false;
+    }
+    return receiveBody(http, buf, sizeof(buf)) == length;
+}
+
+/**
+ * Writes the upload buffer as the body of a chunked request.
+ */
+static bool writeUpload(HttpClient *http, void *context) {
+    unsigned int *written = (unsigned int *) context;
+    if (!http->writeChunk(upload + *written, BENCHMARK_CHUNK_SIZE)) {
+        return false;
+    }
+    *written += BENCHMARK_CHUNK_SIZE;
+    return *written < BENCHMARK_POOL_UPLOAD_SIZE;
+}
+
+/**
+ * Checks the downloaded bytes against the served file, as a flash page
+ * writer would write them.
+ */
+static bool checkDownload(const unsigned char *buf, unsigned int len, unsigned long offset, void *context) {
+    DownloadCheck *check = (DownloadCheck *) context;
+    unsigned int i;
+    if (offset != check->expected) {
+        check->mismatches += len;
+    }
+    for (i = 0; i < len; i++) {
+        if (buf[i] != SIM900Emulator::fileByte(offset + i)) {
+            check->mismatches++;
+        }
+    }
+    check->expected = offset + len;
+    if (check->drops > 0 && check->expected >= check->dropAt) {
+        check->modem->failHttpActions(check->drops);
+        check->drops = 0;
+    }
+    delay(check->writeTime);
+    return true;
+}
+
+static void countPublished(MqttClient *client, unsigned int packetId, bool acknowledged, void *context) {
+    MqttCheck *check = (MqttCheck *) context;
+    if (acknowledged) {
+        check->acknowledged++;
+    } else {
+        check->givenUp++;
+    }
+}
+
+static void countMessage(MqttClient *client, const char *topic, const unsigned char *payload, unsigned int len,
+        void *context) {
+    MqttCheck *check = (MqttCheck *) context;
+    if (strcmp(topic, "bench/echo") == 0 && len == 5 && memcmp(payload, "hello", 5) == 0) {
+        check->received++;
+    }
+}
+
+/**
+ * Formats a sensor record of 24 bytes, a line.
+ */
+static int formatRecord(char *record, int n) {
+    return snprintf(record, 32, "t=23.5,h=41,v=3.71,%04d\n", n % 10000);
+}
+
+/**
+ * Publishes telemetry samples of about 24 bytes, flushing after each or
+ * once at the end.
+ */
+static bool publishSamples(MqttClient *mqtt, unsigned char qos, bool each) {
+    char sample[32];
+    int i, len;
+    unsigned char result;
+    for (i = 0; i < BENCHMARK_SAMPLES; i++) {
+        len = snprintf(sample, sizeof(sample), "t=23.5,h=41,v=3.71,n=%03d", i);
+
+        // A QoS 1 sample waits for a slot, the PUBACKs of the queued ones coming meanwhile
+        while ((result = mqtt->publish("bench/t", (const unsigned char *) sample, len, qos))
+                == MqttClient::IN_FLIGHT_FULL) {
+            if (mqtt->flush() != MqttClient::OK) {
+                return false;
+            }
+            mqtt->loop();
+        }
+        if (result != MqttClient::OK || (each && mqtt->flush() != MqttClient::OK)) {
+            return false;
+        }
+    }
+    return mqtt->flush() == MqttClient::OK;
+}
+
+int main(int argc, char **argv) {
+    unsigned char ip[4];
+    unsigned char payload[BENCHMARK_PAYLOAD_SIZE];
+    unsigned char reply[BENCHMARK_EXCHANGE_SIZE];
+    char pool[BENCHMARK_POOL_CONNECTIONS];
+    unsigned long sent = 0;
+    unsigned int written;
+    int i;
+    SIM900EmulatorConfig config = SIM900Emulator::defaultConfig();
+    if (argc > 1) {
+        config.baudRate = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        config.processingDelay = strtoul(argv[2], NULL, 10) * 1000;
+    }
+    if (argc > 3) {
+        config.networkRoundTrip = strtoul(argv[3], NULL, 10) * 1000;
+    }
+    SIM900Emulator modem(config);
+    EmulatedSerial serial(&modem);
+    SIM900 sim(&serial);
+    GprsSIM900 gprs(&sim);
+    memset(payload, 'x', sizeof(payload));
+    memset(upload, 'x', sizeof(upload));
+    printf("SIM900 emulator: %lu bps, %lu ms processing, %lu ms round trip\n", config.baudRate,
+            config.processingDelay / 1000, config.networkRoundTrip / 1000);
+
+    startPhase();
+    if (!gprs.begin(config.baudRate)) {
+        return fail("begin");
+    }
+    printf("%-28s %10.0f ms\n", "begin", phaseSeconds() * 1000);
+    printf("%-28s %10lu ms\n", "answering AT", sim.getCapabilityTime(SIM900::CAPABILITY_AT));
+    printf("%-28s %10lu ms\n", "SIM ready", sim.getCapabilityTime(SIM900::CAPABILITY_SIM));
+    printf("%-28s %10lu ms\n", "attached to GPRS", sim.getCapabilityTime(SIM900::CAPABILITY_GPRS));
+
+    startPhase();
+    for (i = 0; i < BENCHMARK_ROUND_TRIPS; i++) {
+        if (!sim.sendCommandExpecting("AT", "OK")) {
+            return fail("AT round trip");
+        }
+    }
+    printf("%-28s %10.1f commands/s\n", "AT round trips", BENCHMARK_ROUND_TRIPS / phaseSeconds());
+
+    startPhase();
+    if (gprs.configure(false, "apn", "user", "password", "8.8.8.8", "8.8.4.4") != GprsSIM900::OK) {
+        return fail("configure");
+    }
+    if (gprs.bringUp() != GprsSIM900::OK) {
+        return fail("bring up");
+    }
+    if (gprs.obtainIp(ip) != GprsSIM900::OK) {
+        return fail("obtain ip");
+    }
+    if (gprs.resolve("example.com", ip) != GprsSIM900::OK) {
+        return fail("resolve");
+    }
+    if (gprs.open(-1, "TCP", "example.com", 80) != GprsSIM900::OK) {
+        return fail("open");
+    }
+    printf("%-28s %10.0f ms\n", "bring-up to connected", phaseSeconds() * 1000);
+
+    startPhase();
+    for (i = 0; i < BENCHMARK_STATUS_QUERIES; i++) {
+        if (gprs.status() != GprsSIM900::CONNECT_OK) {
+            return fail("status");
+        }
+    }
+    printf("%-28s %10.1f queries/s\n", "CIPSTATUS queries", BENCHMARK_STATUS_QUERIES / phaseSeconds());
+
+    startPhase();
+    for (i = 0; i < BENCHMARK_PAYLOADS; i++) {
+        sent += gprs.send(-1, payload, sizeof(payload));
+    }
+    if (sent != BENCHMARK_PAYLOADS * sizeof(payload)) {
+        return fail("send");
+    }
+    printf("%-28s %10.0f B/s\n", "payload (20 x 512 B)", sent / phaseSeconds());
+
+    // A log much larger than RAM, produced a piece at a time
+    startPhase();
+    sent = 0;
+    if (gprs.beginSend(-1, BENCHMARK_UPLOAD_SIZE) != GprsSIM900::OK) {
+        return fail("begin send");
+    }
+    while (sent < BENCHMARK_UPLOAD_SIZE) {
+        i = gprs.write(payload, BENCHMARK_UPLOAD_PIECE);
+        if (i != BENCHMARK_UPLOAD_PIECE) {
+            return fail("streamed write");
+        }
+        sent += i;
+    }
+    if (gprs.endSend() != GprsSIM900::OK) {
+        return fail("end send");
+    }
+    printf("%-28s %10.0f B/s\n", "streamed upload (8 KB)", sent / phaseSeconds());
+
+    // The same payloads, each one done once buffered, all acknowledged at the end
+    if (gprs.useQuickSend(true) != GprsSIM900::OK) {
+        return fail("quick send mode");
+    }
+    startPhase();
+    sent = 0;
+    for (i = 0; i < BENCHMARK_PAYLOADS; i++) {
+        sent += gprs.send(-1, payload, sizeof(payload));
+    }
+    if (sent != BENCHMARK_PAYLOADS * sizeof(payload)) {
+        return fail("quick send");
+    }
+    printf("%-28s %10.0f B/s\n", "quick send accepted", sent / phaseSeconds());
+    if (gprs.waitForDelivery(-1, 0, BENCHMARK_DELIVERY_TIMEOUT) != GprsSIM900::OK) {
+        return fail("delivery");
+    }
+    printf("%-28s %10.0f B/s\n", "quick send delivered", sent / phaseSeconds());
+    if (gprs.useQuickSend(false) != GprsSIM900::OK) {
+        return fail("normal send mode");
+    }
+
+    // A request, then its reply read back, with the peer echoing
+    modem.setPeerEcho(true);
+    startPhase();
+    for (i = 0; i < BENCHMARK_EXCHANGES; i++) {
+        payload[0] = (unsigned char) i;
+        if (gprs.send(-1, payload, BENCHMARK_EXCHANGE_SIZE) != BENCHMARK_EXCHANGE_SIZE) {
+            return fail("request");
+        }
+        if (!receive(&gprs, reply, sizeof(reply)) || memcmp(reply, payload, sizeof(reply)) != 0) {
+            return fail("reply");
+        }
+    }
+    printf("%-28s %10.1f exchanges/s\n", "request/reply (48 B)", BENCHMARK_EXCHANGES / phaseSeconds());
+    modem.setPeerEcho(false);
+
+    startPhase();
+    if (gprs.close() != GprsSIM900::OK) {
+        return fail("close");
+    }
+    printf("%-28s %10.0f ms\n", "close", phaseSeconds() * 1000);
+
+    // The same upload as a raw stream, without AT+CIPSEND framing
+    if (gprs.useTransparentMode(true) != GprsSIM900::OK) {
+        return fail("transparent mode");
+    }
+    if (gprs.open(-1, "TCP", "example.com", 80) != GprsSIM900::OK || !gprs.isInDataMode()) {
+        return fail("transparent open");
+    }
+    startPhase();
+    for (sent = 0; sent < BENCHMARK_UPLOAD_SIZE; sent += BENCHMARK_UPLOAD_PIECE) {
+        gprs.write(payload, BENCHMARK_UPLOAD_PIECE);
+    }
+    if (gprs.escape() != GprsSIM900::OK) {
+        return fail("escape");
+    }
+    if (gprs.waitForDelivery(-1, 0, BENCHMARK_DELIVERY_TIMEOUT) != GprsSIM900::OK) {
+        return fail("transparent delivery");
+    }
+    printf("%-28s %10.0f B/s\n", "transparent upload (8 KB)", sent / phaseSeconds());
+    if (gprs.resume() != GprsSIM900::OK || gprs.close() != GprsSIM900::OK) {
+        return fail("transparent close");
+    }
+
+    // Several connections of the pool opened at once, then sharing the link
+    if (gprs.useTransparentMode(false) != GprsSIM900::OK || gprs.shutdown() != GprsSIM900::OK) {
+        return fail("pool shutdown");
+    }
+    if (gprs.configure(true, "apn", "user", "password", NULL, NULL) != GprsSIM900::OK
+            || gprs.bringUp() != GprsSIM900::OK || gprs.obtainIp(ip) != GprsSIM900::OK) {
+        return fail("pool bring-up");
+    }
+    startPhase();
+    for (i = 0; i < BENCHMARK_POOL_CONNECTIONS; i++) {
+        pool[i] = gprs.allocate();
+        if (pool[i] < 0 || gprs.startOpen(pool[i], "TCP", "example.com", 80) != GprsSIM900::OK) {
+            return fail("pool open");
+        }
+    }
+    for (i = 0; i < BENCHMARK_POOL_CONNECTIONS; i++) {
+        if (gprs.waitForChannel(pool[i], BENCHMARK_DELIVERY_TIMEOUT) != GprsSIM900::OK) {
+            return fail("pool connect");
+        }
+    }
+    printf("%-28s %10.0f ms\n", "pool open (4 connections)", phaseSeconds() * 1000);
+    startPhase();
+    for (i = 0; i < BENCHMARK_POOL_CONNECTIONS; i++) {
+        if (!gprs.queueSend(pool[i], upload, BENCHMARK_POOL_UPLOAD_SIZE)) {
+            return fail("pool queue");
+        }
+    }
+    for (i = 0; i < BENCHMARK_POOL_CONNECTIONS; i++) {
+        if (gprs.waitForChannel(pool[i], BENCHMARK_DELIVERY_TIMEOUT) != GprsSIM900::OK) {
+            return fail("pool send");
+        }
+    }
+    printf("%-28s %10.0f B/s\n", "pool upload (4 x 2 KB)",
+            BENCHMARK_POOL_CONNECTIONS * BENCHMARK_POOL_UPLOAD_SIZE / phaseSeconds());
+    for (i = 0; i < BENCHMARK_POOL_CONNECTIONS; i++) {
+        gprs.release(pool[i]);
+    }
+
+    // Telemetry messages, a connection each as in sending_to_server.ino, then over a kept one
+    pool[0] = gprs.allocate();
+    startPhase();
+    for (i = 0; i < BENCHMARK_MESSAGES; i++) {
+        if (gprs.open(pool[0], "TCP", "example.com", 80) != GprsSIM900::OK
+                || gprs.send(pool[0], payload, BENCHMARK_EXCHANGE_SIZE) != BENCHMARK_EXCHANGE_SIZE
+                || gprs.close(pool[0]) != GprsSIM900::OK) {
+            return fail("message");
+        }
+    }
+    printf("%-28s %10.1f messages/s\n", "connection per message", BENCHMARK_MESSAGES / phaseSeconds());
+    if (gprs.usePersistentConnection(pool[0], "TCP", "example.com", 80) != GprsSIM900::OK
+            || !gprs.isKeepaliveEnabled()) {
+        return fail("persistent connection");
+    }
+    startPhase();
+    for (i = 0; i < BENCHMARK_MESSAGES; i++) {
+
+        // The peer drops it once halfway
+        if (i == BENCHMARK_MESSAGES / 2) {
+            modem.disconnect(pool[0]);
+        }
+        if (gprs.sendPersistent(payload, BENCHMARK_EXCHANGE_SIZE) != BENCHMARK_EXCHANGE_SIZE) {
+            return fail("persistent message");
+        }
+    }
+    printf("%-28s %10.1f messages/s\n", "persistent connection", BENCHMARK_MESSAGES / phaseSeconds());
+    if (gprs.getReconnects() != 1 || gprs.endPersistentConnection() != GprsSIM900::OK) {
+        return fail("persistent reconnect");
+    }
+
+    // Names looked up one at a time, then all at once, then connected to by address
+    gprs.flushDnsCache();
+    startPhase();
+    for (i = 0; i < BENCHMARK_NAMES; i++) {
+        if (gprs.resolve(names[i], ip) != GprsSIM900::OK) {
+            return fail("resolve");
+        }
+    }
+    printf("%-28s %10.0f ms\n", "dns, one name at a time (4)", phaseSeconds() * 1000);
+    gprs.flushDnsCache();
+    startPhase();
+    if (gprs.prefetch(names, BENCHMARK_NAMES) != BENCHMARK_NAMES) {
+        return fail("prefetch");
+    }
+    printf("%-28s %10.0f ms\n", "dns prefetch (4 names)", phaseSeconds() * 1000);
+    startPhase();
+    for (i = 0; i < BENCHMARK_NAMES; i++) {
+        if (gprs.resolve(names[i], ip) != GprsSIM900::OK) {
+            return fail("cached lookup");
+        }
+    }
+    printf("%-28s %10.0f ms\n", "dns cache hits (4)", phaseSeconds() * 1000);
+
+    // A failure is cached too
+    if (gprs.resolve("nothing.invalid", ip) == GprsSIM900::OK) {
+        return fail("failed lookup");
+    }
+    startPhase();
+    if (gprs.resolve("nothing.invalid", ip) == GprsSIM900::OK) {
+        return fail("cached failure");
+    }
+    printf("%-28s %10.0f ms\n", "dns cached failure", phaseSeconds() * 1000);
+    gprs.useResolvedAddresses(true);
+    startPhase();
+    for (i = 0; i < BENCHMARK_MESSAGES; i++) {
+        if (gprs.open(pool[0], "TCP", "example.com", 80) != GprsSIM900::OK
+                || gprs.send(pool[0], payload, BENCHMARK_EXCHANGE_SIZE) != BENCHMARK_EXCHANGE_SIZE
+                || gprs.close(pool[0]) != GprsSIM900::OK) {
+            return fail("message by address");
+        }
+    }
+    printf("%-28s %10.1f messages/s\n", "connection per message, ip", BENCHMARK_MESSAGES / phaseSeconds());
+    gprs.useResolvedAddresses(false);
+    gprs.release(pool[0]);
+
+    // HTTP over a kept connection, then a connection per request, then a chunked upload. Quick send keeps
+    // the responses from arriving while a SEND OK is awaited
+    modem.setPeerHttp(true);
+    if (gprs.useQuickSend(true) != GprsSIM900::OK) {
+        return fail("http quick send");
+    }
+    pool[0] = gprs.allocate();
+    HttpClient http(&gprs, "example.com", 80, pool[0]);
+    startPhase();
+    for (i = 0; i < BENCHMARK_REQUESTS; i++) {
+        if (!fetch(&http, "/bytes/512", BENCHMARK_PAYLOAD_SIZE)) {
+            return fail("http kept");
+        }
+    }
+    printf("%-28s %10.1f requests/s\n", "http get, kept (512 B)", BENCHMARK_REQUESTS / phaseSeconds());
+    if (!fetch(&http, "/chunked/512", BENCHMARK_PAYLOAD_SIZE)) {
+        return fail("http chunked response");
+    }
+
+    // A body without length ends with the connection, the response to a HEAD has none
+    if (!fetch(&http, "/close/512", BENCHMARK_PAYLOAD_SIZE)) {
+        return fail("http body until close");
+    }
+    if (http.request(F("HEAD"), "/bytes/512", NULL, 0, NULL, 0) != HttpClient::OK
+            || http.awaitResponse(BENCHMARK_EXCHANGE_TIMEOUT) != HttpClient::OK || !http.isComplete()
+            || http.getContentLength() != BENCHMARK_PAYLOAD_SIZE) {
+        return fail("http head");
+    }
+    http.useKeepAlive(false);
+    startPhase();
+    for (i = 0; i < BENCHMARK_REQUESTS; i++) {
+        if (!fetch(&http, "/bytes/512", BENCHMARK_PAYLOAD_SIZE)) {
+            return fail("http closed");
+        }
+    }
+    printf("%-28s %10.1f requests/s\n", "http get, closed (512 B)", BENCHMARK_REQUESTS / phaseSeconds());
+    http.useKeepAlive(true);
+    startPhase();
+    written = 0;
+    if (http.requestChunked(F("POST"), "/upload", NULL, 0, writeUpload, &written) != HttpClient::OK
+            || http.awaitResponse(BENCHMARK_EXCHANGE_TIMEOUT) != HttpClient::OK
+            || receiveBody(&http, payload, sizeof(payload)) != 4 || memcmp(payload, "2048", 4) != 0) {
+        return fail("http chunked post");
+    }
+    printf("%-28s %10.0f B/s\n", "http chunked post (2 KB)", written / phaseSeconds());
+    http.close();
+    gprs.release(pool[0]);
+    if (gprs.useQuickSend(false) != GprsSIM900::OK) {
+        return fail("http quick send");
+    }
+    modem.setPeerHttp(false);
+
+    // A file through the HTTP stack of the modem, the bearer dropping once on the way, then for longer
+    // than download() retries, so resume() has to go on
+    DownloadSIM900 downloader(&sim);
+    DownloadCheck check = { &modem, 0, 0, BENCHMARK_DOWNLOAD_SIZE / 2, 1, 0 };
+    modem.setHttpFileSize(BENCHMARK_DOWNLOAD_SIZE);
+    if (downloader.openBearer("apn", NULL, NULL) != DownloadSIM900::OK) {
+        return fail("download bearer");
+    }
+    startPhase();
+    if (downloader.download("example.com/fw.bin", checkDownload, &check) != DownloadSIM900::OK
+            || downloader.getLength() != (long) BENCHMARK_DOWNLOAD_SIZE || check.expected != BENCHMARK_DOWNLOAD_SIZE
+            || check.mismatches != 0 || downloader.getRestarts() != 1) {
+        return fail("download");
+    }
+    printf("%-28s %10.0f B/s, %u B window\n", "download (200 KB, 1 drop)", BENCHMARK_DOWNLOAD_SIZE / phaseSeconds(),
+            downloader.getWindow());
+    check.expected = 0;
+    check.drops = DOWNLOAD_SIM900_RETRIES + 1;
+    startPhase();
+    if (downloader.download("example.com/fw.bin", checkDownload, &check) != DownloadSIM900::INTERRUPTED
+            || downloader.resume("example.com/fw.bin", checkDownload, &check) != DownloadSIM900::OK
+            || check.expected != BENCHMARK_DOWNLOAD_SIZE || check.mismatches != 0) {
+        return fail("download resume");
+    }
+    printf("%-28s %10.0f B/s\n", "download, resumed", BENCHMARK_DOWNLOAD_SIZE / phaseSeconds());
+
+    // A sink as slow as a flash page write holds the payload back for longer than the read takes on the line
+    check.expected = 0;
+    check.writeTime = 50;
+    modem.setHttpFileSize(BENCHMARK_SLOW_DOWNLOAD_SIZE);
+    if (downloader.download("example.com/fw.bin", checkDownload, &check) != DownloadSIM900::OK
+            || check.expected != BENCHMARK_SLOW_DOWNLOAD_SIZE || check.mismatches != 0
+            || downloader.getRestarts() != 0) {
+        return fail("download, slow sink");
+    }
+    if (downloader.closeBearer() != DownloadSIM900::OK) {
+        return fail("download bearer");
+    }
+
+    // MQTT samples, a frame each and then coalesced, then QoS 1 ones until all are acknowledged
+    modem.setPeerMqtt(true);
+    if (gprs.useQuickSend(true) != GprsSIM900::OK) {
+        return fail("mqtt quick send");
+    }
+    pool[0] = gprs.allocate();
+    MqttClient mqtt(&gprs, pool[0]);
+    MqttCheck mqttCheck = { 0, 0, 0 };
+    unsigned long frames, lines;
+    mqtt.onPublished(countPublished, &mqttCheck);
+    mqtt.onMessage(countMessage, &mqttCheck);
+    startPhase();
+    if (mqtt.connect("broker.example.com", 1883, "bench", NULL, NULL, 60) != MqttClient::OK) {
+        return fail("mqtt connect");
+    }
+    printf("%-28s %10.0f ms\n", "mqtt connect", phaseSeconds() * 1000);
+    startPhase();
+    frames = mqtt.getFrames();
+    lines = modem.getCommandLines();
+    if (!publishSamples(&mqtt, 0, true)) {
+        return fail("mqtt publish");
+    }
+    printf("%-28s %10.1f samples/s, %lu frames, %lu lines\n", "mqtt qos 0, flushed each",
+            BENCHMARK_SAMPLES / phaseSeconds(), mqtt.getFrames() - frames, modem.getCommandLines() - lines);
+    startPhase();
+    frames = mqtt.getFrames();
+    lines = modem.getCommandLines();
+    if (!publishSamples(&mqtt, 0, false)) {
+        return fail("mqtt batch");
+    }
+    printf("%-28s %10.1f samples/s, %lu frames, %lu lines\n", "mqtt qos 0, batched",
+            BENCHMARK_SAMPLES / phaseSeconds(), mqtt.getFrames() - frames, modem.getCommandLines() - lines);
+    startPhase();
+    frames = mqtt.getFrames();
+    if (!publishSamples(&mqtt, 1, false)) {
+        return fail("mqtt qos 1");
+    }
+    while (mqtt.getInFlight() > 0 && mqtt.isConnected()) {
+        mqtt.loop();
+    }
+    if (mqttCheck.acknowledged != BENCHMARK_SAMPLES || mqttCheck.givenUp != 0) {
+        return fail("mqtt qos 1 acknowledged");
+    }
+    printf("%-28s %10.1f samples/s, %lu frames\n", "mqtt qos 1, batched", BENCHMARK_SAMPLES / phaseSeconds(),
+            mqtt.getFrames() - frames);
+    startPhase();
+    if (mqtt.subscribe("bench/echo", 0) != MqttClient::OK
+            || mqtt.publish("bench/echo", (const unsigned char *) "hello", 5, 0) != MqttClient::OK
+            || mqtt.flush() != MqttClient::OK) {
+        return fail("mqtt subscribe");
+    }
+    while (mqttCheck.received == 0 && phaseSeconds() < BENCHMARK_EXCHANGE_TIMEOUT / 1000.0) {
+        mqtt.loop();
+    }
+    if (mqttCheck.received != 1) {
+        return fail("mqtt echo");
+    }
+    printf("%-28s %10.0f ms\n", "mqtt subscribe and echo", phaseSeconds() * 1000);
+    startPhase();
+    if (mqtt.ping() != MqttClient::OK) {
+        return fail("mqtt ping");
+    }
+    printf("%-28s %10.0f ms\n", "mqtt ping", phaseSeconds() * 1000);
+    if (mqtt.disconnect() != MqttClient::OK || modem.getPeerPublishes() != 3 * BENCHMARK_SAMPLES + 1) {
+        return fail("mqtt disconnect");
+    }
+    gprs.release(pool[0]);
+    if (gprs.useQuickSend(false) != GprsSIM900::OK) {
+        return fail("mqtt quick send");
+    }
+    modem.setPeerMqtt(false);
+
+    // Sensor records, a send each and then coalesced into frames, then a few flushed by their age
+    char record[32];
+    int len;
+    unsigned long bytes;
+    pool[0] = gprs.allocate();
+    if (gprs.open(pool[0], "TCP", "example.com", 80) != GprsSIM900::OK) {
+        return fail("records open");
+    }
+    startPhase();
+    lines = modem.getCommandLines();
+    for (i = 0; i < BENCHMARK_RECORDS; i++) {
+        len = formatRecord(record, i);
+        if (gprs.send(pool[0], (unsigned char *) record, len) != (unsigned int) len) {
+            return fail("record send");
+        }
+    }
+    printf("%-28s %10.1f records/s, %lu lines\n", "records, a send each", BENCHMARK_RECORDS / phaseSeconds(),
+            modem.getCommandLines() - lines);
+    RecordQueue records(&gprs, pool[0]);
+    startPhase();
+    lines = modem.getCommandLines();
+    bytes = modem.getPayloadBytes();
+    for (i = 0; i < BENCHMARK_RECORDS; i++) {
+        len = formatRecord(record, i);
+        if (records.append((const unsigned char *) record, len) != RecordQueue::OK) {
+            return fail("record append");
+        }
+    }
+    if (records.flush() != RecordQueue::OK || modem.getPayloadBytes() - bytes != BENCHMARK_RECORDS * 24UL) {
+        return fail("record flush");
+    }
+    printf("%-28s %10.1f records/s, %lu frames, %lu lines\n", "records, coalesced", BENCHMARK_RECORDS / phaseSeconds(),
+            records.getFrames(), modem.getCommandLines() - lines);
+    records.setMaxAge(BENCHMARK_RECORD_AGE);
+    frames = records.getFrames();
+    startPhase();
+    for (i = 0; i < 3; i++) {
+        len = formatRecord(record, i);
+        if (records.append((const unsigned char *) record, len) != RecordQueue::OK) {
+            return fail("record append");
+        }
+    }
+    while (records.getFrames() == frames && phaseSeconds() < 2 * BENCHMARK_RECORD_AGE / 1000.0) {
+        if (records.poll() != RecordQueue::OK) {
+            return fail("record poll");
+        }
+        delay(10);
+    }
+    if (records.getFrames() != frames + 1 || records.getSentRecords() != BENCHMARK_RECORDS + 3) {
+        return fail("record age");
+    }
+    printf("%-28s %10.0f ms\n", "records, flushed by age (5 s)", phaseSeconds() * 1000);
+    if (gprs.close(pool[0]) != GprsSIM900::OK) {
+        return fail("records close");
+    }
+    gprs.release(pool[0]);
+    printf("%-28s %10lu lines, %.1f s virtual\n", "total", modem.getCommandLines(), VirtualClock::now() / 1000000.0);
+#ifdef SIM900_STATS
+    Serial.flush();
+    sim.dumpStats(&Serial);
+    Serial.flush();
+#endif
+    return 0;
+}